@@ -0,0 +1,44 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "onnx_structs.h"
+#include "tensor.h"
+#include "exec_plan.h"
+#include "cpu_features.h"
+
+/**
+ * Inference Session
+ * Giữ graph đã parse và toàn bộ weights (initializers) đã load sẵn,
+ * để các lần chạy sau chỉ phải xử lý activations.
+ * Lưu ý: session chỉ tham chiếu tới model, model phải sống lâu hơn session.
+ *
+ * Session không bị ghi sau khi tạo xong: mọi thứ thay đổi theo lần chạy (shape, activations,
+ * scratch, arena) nằm trong RunContext. Nhiều thread chạy cùng một session được, mỗi thread một
+ * RunContext riêng, và chỉ có một bản weights / weights đã pack cho tất cả.
+ */
+typedef struct EngineSession EngineSession;
+
+// Tạo session: load initializers một lần duy nhất
+EngineSession* engine_session_create(OnnxModel* model);
+
+// Như engine_session_create nhưng kernel không vượt quá tập lệnh max_isa
+// (so sánh các bản kernel, kiểm thử bản generic trên máy có AVX2...)
+EngineSession* engine_session_create_isa(OnnxModel* model, CpuIsa max_isa);
+
+// Chạy inference trên RunContext mặc định của session (không gọi đồng thời từ nhiều thread).
+// Tensor trả về thuộc sở hữu của session, chỉ hợp lệ tới lần chạy kế tiếp hoặc khi session bị hủy.
+Tensor* engine_session_run(EngineSession* session, Tensor* input_img);
+
+// Workspace riêng cho một thread: arena activations chỉ được cấp ở lần chạy đầu tiên.
+// Phải được giải phóng trước session.
+RunContext* engine_context_create(const EngineSession* session);
+void engine_context_free(RunContext* ctx);
+
+// Chạy inference trên ctx; gọi đồng thời được với các ctx khác nhau trên cùng session.
+// Tensor trả về thuộc sở hữu của ctx, chỉ hợp lệ tới lần chạy kế tiếp trên ctx đó.
+Tensor* engine_session_run_context(const EngineSession* session, RunContext* ctx, Tensor* input_img);
+
+// Giải phóng weights, activations và session
+void engine_session_free(EngineSession* session);
+
+#endif // ENGINE_H
@@ -0,0 +1,34 @@
+#ifndef FUSION_H
+#define FUSION_H
+
+#include "exec_plan.h"
+
+/**
+ * BatchNorm folding (chạy trước fusion_apply)
+ * Conv -> BatchNormalization với tham số là initializer: BN được gộp thẳng vào weights
+ * và bias của Conv lúc tạo session, node BN bị xóa khỏi plan. Weights / bias bị sửa
+ * tại chỗ nên chỉ gộp khi chúng không được node nào khác dùng chung; nếu Conv không có
+ * bias thì beta của BN được dùng làm bias. Các BN không gộp được vẫn có thể được
+ * fusion_apply đưa vào epilogue.
+ *
+ * Trả về số node BN bị loại bỏ.
+ */
+int fusion_fold_batchnorm(ExecPlan* plan);
+
+/**
+ * Graph fusion (chạy một lần sau compile, trước layout pass và prepare)
+ * Mỗi Conv có kernel hỗ trợ epilogue (OP_FLAG_FUSE_EPILOGUE) gộp chuỗi phía sau nó:
+ *   Conv -> [BatchNormalization] -> [Add(residual)] -> [Relu]
+ * thành một node duy nhất, được áp dụng ngay trên tile output (xem ConvEpilogue trong
+ * operators.h) thay vì mỗi op đọc-ghi lại toàn bộ activation một lần.
+ *
+ * Chỉ gộp khi tensor trung gian có đúng một node đọc và không phải output của graph;
+ * tham số BatchNorm phải là initializer; toán hạng residual của Add phải chắc chắn cùng shape
+ * với output của Conv (graph_shapes_equal), Add có broadcast vẫn là node riêng. Node đã fuse được đặt vào vị trí của node
+ * cuối cùng trong chuỗi (lúc đó toán hạng residual chắc chắn đã được tính xong).
+ *
+ * Trả về số node bị loại bỏ.
+ */
+int fusion_apply(ExecPlan* plan);
+
+#endif // FUSION_H
@@ -0,0 +1,96 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <stddef.h>
+
+struct KernelTable; // Định nghĩa trong kernels.h
+
+/**
+ * SGEMM (row-major): C[M, N] = alpha * A[M, K] * B[K, N] + beta * C[M, N]
+ * lda, ldb, ldc: khoảng cách (số phần tử) giữa 2 hàng liên tiếp của A, B, C
+ *
+ * Cài đặt theo kiểu cache-blocked: B được pack thành các panel KC x NR (nằm trong L2/L3),
+ * A được pack thành các panel MC x KC (nằm trong L2), micro-kernel MR x NR giữ
+ * toàn bộ tile C trong thanh ghi (bản theo tập lệnh của CPU, xem kernels.h).
+ * Khi beta == 0, C không được đọc (có thể chứa dữ liệu rác).
+ * GEMM đủ lớn được chia thành lưới khối C chạy song song trên thread pool (thread_pool.h).
+ * kt: bảng kernel theo ISA của session (kernels.h), micro-kernel được gọi qua bảng này;
+ * mọi hàm bên dưới cũng nhận kt như vậy.
+ */
+void sgemm(const struct KernelTable* kt, int M, int N, int K,
+           float alpha, const float* A, int lda,
+           const float* B, int ldb,
+           float beta, float* C, int ldc);
+
+/**
+ * SGEMM tổng quát: C[M, N] = alpha * op(A) * op(B) + beta * C
+ * op(A) = A [M, K] (transA = 0) hoặc A^T với A lưu dạng [K, M] (transA = 1), tương tự cho B.
+ * Phép chuyển vị được xử lý trong bước pack nên mọi tổ hợp đều chạy cùng micro-kernel.
+ */
+void sgemm_ex(const struct KernelTable* kt, int transA, int transB, int M, int N, int K,
+              float alpha, const float* A, int lda,
+              const float* B, int ldb,
+              float beta, float* C, int ldc);
+
+/**
+ * Epilogue của SGEMM: áp dụng lên tile C khi còn trong thanh ghi (sau block K cuối cùng),
+ * thay cho các lượt đọc-ghi lại toàn bộ C sau GEMM:
+ *   c = alpha * acc + beta * C;  c += bias[i];  c = c * scale[i] + shift[i];  c += R[i, j];  ReLU
+ * Các vector theo hàng i của C; con trỏ NULL = bỏ qua bước đó (scale và shift luôn đi cùng nhau).
+ */
+typedef struct {
+    const float* bias;
+    const float* scale;
+    const float* shift;
+    const float* residual;  // R[M, N] với khoảng cách hàng ldr
+    int ldr;
+    int relu;
+} GemmEpilogue;
+
+// C[M, N] = epilogue(A[M, K] * B[K, N]) (alpha = 1, beta = 0, K > 0), ep có thể NULL
+void sgemm_epilogue(const struct KernelTable* kt, int M, int N, int K,
+                    const float* A, int lda,
+                    const float* B, int ldb,
+                    float* C, int ldc,
+                    const GemmEpilogue* ep);
+
+/**
+ * Ma trận B[K, N] được đọc qua một view có stride, không cần copy ra buffer riêng:
+ *   B(k, j) = data[k * k_stride + (j / n_cols) * row_stride + (j % n_cols) * col_stride]
+ * Ví dụ Conv 1x1 stride s trên ảnh [C, H, W]: cột j là điểm output (oh, ow) = (j / W_out, j % W_out)
+ *   -> k_stride = H * W, n_cols = W_out, row_stride = s * W, col_stride = s
+ */
+typedef struct {
+    const float* data;
+    int k_stride;
+    int n_cols;
+    int row_stride;
+    int col_stride;
+} GemmStridedB;
+
+// Giống sgemm() nhưng B được đọc qua view có stride (việc gom dữ liệu nằm trong bước pack),
+// ep (có thể NULL): epilogue như sgemm_epilogue
+void sgemm_strided_b(const struct KernelTable* kt, int M, int N, int K,
+                     float alpha, const float* A, int lda,
+                     const GemmStridedB* B,
+                     float beta, float* C, int ldc,
+                     const GemmEpilogue* ep);
+
+/**
+ * GEMV cho batch 1 (lớp fully connected): y[N] = alpha * x[K] * op(B)[K, N] + beta * y
+ * Bài toán bị giới hạn bởi băng thông bộ nhớ: op(B) được pack một lần (lúc prepare)
+ * thành các panel GEMV_NR cột, mỗi lần chạy chỉ đọc tuần tự toàn bộ panel đúng một lần.
+ * sgemv_pack_b: B lưu dạng [K, N] (transB = 0) hoặc [N, K] (transB = 1),
+ *   dst có ít nhất sgemv_packed_size(N, K) phần tử, căn lề 32 byte
+ * sgemv_packed: chỉ tính các cột y[n_begin : n_end) để có thể chia cho nhiều thread
+ *   (nên chọn n_begin là bội của GEMV_NR để mỗi panel chỉ được đọc một lần)
+ */
+#define GEMV_NR 16
+
+size_t sgemv_packed_size(int N, int K);
+void sgemv_pack_b(int transB, int N, int K, const float* B, int ldb, float* dst);
+void sgemv_packed(const struct KernelTable* kt, int N, int K,
+                  float alpha, const float* x, const float* packed_b,
+                  float beta, float* y, int n_begin, int n_end);
+
+#endif // GEMM_H
@@ -0,0 +1,58 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stddef.h>
+#include "cpu_features.h"
+#include "gemm.h"
+
+/**
+ * Kernel đa phiên bản (multi-versioned)
+ * src/kernels_impl.c được biên dịch thành nhiều translation unit, mỗi bản với cờ -m
+ * của một tập lệnh (xem Makefile), và xuất một KernelTable. Lúc tạo session,
+ * kernels_select() chọn bảng tốt nhất mà CPU hỗ trợ và session giữ bảng đó (ExecPlan::kernels);
+ * các vòng lặp nóng gọi qua bảng được truyền xuống (kt->...) nên một binary chạy được trên
+ * mọi máy x86-64 mà vẫn dùng hết độ rộng vector ở máy có AVX2 / AVX-512.
+ * Không có bảng toàn cục: mỗi session có bảng riêng, session tạo sau không đổi kernel
+ * của session đang chạy.
+ */
+
+// Tile thanh ghi của micro-kernel GEMM (gemm.c pack A/B theo đúng kích thước này)
+#define GEMM_MR 6
+#define GEMM_NR 16
+
+typedef struct KernelTable {
+    CpuIsa isa;
+    const char* name;
+
+    /**
+     * GEMM: acc = panel_a[kc, MR] * panel_b[kc, NR], rồi C = alpha * acc + beta * C
+     * (chỉ ghi mr x nr phần tử hợp lệ, beta == 0 thì không đọc C). panel_b căn lề 64 byte.
+     * ep (có thể NULL): epilogue của tile, các con trỏ đã trỏ tới hàng / phần tử đầu của tile.
+     */
+    void (*gemm_micro)(int kc, const float* a, const float* b,
+                       float* C, int ldc, int mr, int nr,
+                       float alpha, float beta, const GemmEpilogue* ep);
+
+    // GEMV: out[0 : GEMV_NR] = x[K] * panel[K, GEMV_NR] (panel căn lề 64 byte)
+    void (*gemv_panel)(int K, const float* x, const float* panel, float* out);
+
+    // Element-wise trên n phần tử liên tiếp
+    void (*relu)(const float* x, float* y, size_t n);
+    void (*add)(const float* a, const float* b, float* y, size_t n);
+    void (*scale_shift)(const float* x, float scale, float shift, float* y, size_t n); // y = x * scale + shift
+    float (*sum)(const float* x, size_t n);
+
+    // y[i] += a * x[i] và y[i] += a * x[i * stride] (depthwise conv), x và y không chồng nhau
+    void (*axpy)(float* y, const float* x, float a, int n);
+    void (*axpy_strided)(float* y, const float* x, float a, int n, int stride);
+} KernelTable;
+
+extern const KernelTable kernel_table_generic;
+extern const KernelTable kernel_table_sse42;
+extern const KernelTable kernel_table_avx2;
+extern const KernelTable kernel_table_avx512;
+
+// Bảng của tập lệnh cao nhất không vượt quá max_isa mà CPU hỗ trợ (chỉ tra cứu, không có trạng thái)
+const KernelTable* kernels_select(CpuIsa max_isa);
+
+#endif // KERNELS_H
@@ -0,0 +1,41 @@
+#ifndef MEMORY_PLANNER_H
+#define MEMORY_PLANNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "exec_plan.h"
+
+#define ARENA_ALIGNMENT 64
+
+struct NodeDag;  // Định nghĩa trong scheduler.h
+
+/**
+ * Một buffer cần đặt vào arena.
+ * first_use: chỉ số node ghi buffer, last_use: chỉ số node cuối cùng đọc buffer.
+ * Chạy tuần tự: hai buffer được dùng chung vùng nhớ nếu khoảng [first_use, last_use] không giao nhau.
+ * Chạy theo DAG: thứ tự chỉ số node không còn là thứ tự thời gian, buffer A chỉ được đặt trước B
+ * khi mọi node trong users của A là ancestor của node ghi B (first_use) và ngược lại.
+ */
+typedef struct {
+    size_t size;     // Số byte (đã làm tròn theo ARENA_ALIGNMENT)
+    int first_use;
+    int last_use;
+    const uint64_t* users;  // Chỉ dùng với DAG: bitset các node đọc / ghi buffer
+    size_t offset;   // Kết quả: vị trí trong arena
+} BufferRequest;
+
+// Greedy by size + best-fit: trả về kích thước arena cần thiết (peak).
+// dag = NULL: xung đột theo khoảng lifetime, ngược lại theo thứ tự của DAG (xem trên).
+size_t memory_plan_offsets(BufferRequest* reqs, int n, const struct NodeDag* dag);
+
+/**
+ * Lập kế hoạch bộ nhớ cho toàn bộ activations và scratch của một RunContext (shape đã được infer
+ * vào ctx->slots). Output của op có OP_FLAG_INPLACE dùng lại buffer của input nếu input chết tại op đó.
+ * Nếu plan->dag khác NULL, kế hoạch đúng với mọi thứ tự chạy mà DAG cho phép.
+ * Cấp phát lại ctx->arena nếu cần và gán data của từng activation vào arena; plan không bị ghi.
+ * Thống kê (naive = tổng activations + scratch, không dùng chung) chỉ được in ở lần đầu của ctx.
+ * Trả về 0 nếu thành công.
+ */
+int memory_plan_activations(const ExecPlan* plan, RunContext* ctx);
+
+#endif // MEMORY_PLANNER_H
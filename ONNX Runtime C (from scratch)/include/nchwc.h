@@ -0,0 +1,59 @@
+#ifndef NCHWC_H
+#define NCHWC_H
+
+#include "tensor.h"
+#include "operators.h" // ConvEpilogue
+
+/**
+ * Kernel cho layout blocked NCHWc (xem TensorLayout trong tensor.h)
+ * Mỗi điểm ảnh của một block channel là 8 float liên tiếp = một thanh ghi AVX2,
+ * nên conv/pool/element-wise đều được vector hóa theo chiều channel.
+ *
+ * File nchwc.c được biên dịch với -mavx2 -mfma: chỉ gọi các hàm này khi
+ * nchwc_cpu_supported(kt) (ở layout.c) trả về 1.
+ */
+
+// Số block channel của c channel
+static inline int nchwc_blocks(int c) {
+    return (c + TENSOR_BLOCK_C - 1) / TENSOR_BLOCK_C;
+}
+
+/**
+ * 1. Chuyển layout (chỉ dùng ở biên của vùng blocked trong graph)
+ */
+void nchwc_reorder_to_blocked(const Tensor* X, Tensor* Y);
+void nchwc_reorder_to_plain(const Tensor* X, Tensor* Y);
+
+/**
+ * 2. Convolution trực tiếp (group = 1)
+ * nchwc_conv_pack_weights: W [OC, IC, kH, kW] -> [OCb, ICb, kH, kW, 8 ic, 8 oc] (đệm 0),
+ *   dst có ít nhất nchwc_blocks(OC) * nchwc_blocks(IC) * kH * kW * 64 phần tử
+ * bias: đã đệm tới nchwc_blocks(OC) * 8 phần tử
+ * ep (có thể NULL): scale/shift đã đệm như bias, residual cùng layout blocked với Y
+ */
+void nchwc_conv_pack_weights(const Tensor* W, float* dst);
+void nchwc_conv2d(const Tensor* X, const float* packed_w, const float* bias, Tensor* Y,
+                  int kernel_h, int kernel_w,
+                  int stride_h, int stride_w,
+                  int pad_h, int pad_w,
+                  int dilation_h, int dilation_w,
+                  const ConvEpilogue* ep);
+
+/**
+ * 3. Element-wise
+ * scale, shift: đã đệm tới nchwc_blocks(C) * 8 phần tử (BatchNorm đã gộp: y = x * scale + shift)
+ */
+void nchwc_scale_shift(const Tensor* X, const float* scale, const float* shift, Tensor* Y);
+void nchwc_relu(const Tensor* X, Tensor* Y);
+void nchwc_add(const Tensor* A, const Tensor* B, Tensor* Y);
+
+/**
+ * 4. Pooling
+ */
+void nchwc_maxpool(const Tensor* X, Tensor* Y,
+                   int kernel_h, int kernel_w,
+                   int stride_h, int stride_w,
+                   int pad_h, int pad_w);
+void nchwc_global_average_pool(const Tensor* X, Tensor* Y);
+
+#endif // NCHWC_H
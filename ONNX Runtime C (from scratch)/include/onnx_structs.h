@@ -25,14 +25,21 @@ typedef struct {
     int n_attributes;
 } OnnxNode;
 
+// TensorProto.DataType (các giá trị được hỗ trợ; INT32 được đọc thành int64)
+#define ONNX_DTYPE_FLOAT 1
+#define ONNX_DTYPE_INT32 6
+#define ONNX_DTYPE_INT64 7
+
 // Định nghĩa Tensor (Trọng số - Weights)
 typedef struct {
     char* name;
-    int32_t data_type; // 1: FLOAT
+    int32_t data_type; // ONNX_DTYPE_*
     int64_t* dims;     // Kích thước [N, C, H, W]
     int n_dims;
     float* float_data; // Dữ liệu weight
     int n_float_data;
+    int64_t* int64_data; // Tensor số nguyên (INT32 / INT64)
+    int n_int64_data;
 } OnnxTensor;
 
 // Định nghĩa Graph
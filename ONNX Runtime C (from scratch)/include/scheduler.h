@@ -0,0 +1,49 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include "exec_plan.h"
+
+/**
+ * DAG phụ thuộc dữ liệu giữa các node của plan (cạnh p -> i: node i đọc một output của node p).
+ * node_dag_run chạy các node trên thread pool theo kiểu đếm phụ thuộc: node hết phụ thuộc được
+ * đưa vào deque của thread vừa chạy xong node trước nó, nên các nhánh độc lập (Inception, nhánh
+ * downsample của ResNet...) chạy đồng thời, còn parallel_for bên trong mỗi op lồng vào cùng pool.
+ *
+ * ancestors[i] là bitset các node phải chạy xong trước node i; memory planner dùng nó để chỉ
+ * cho hai buffer dùng chung vùng nhớ khi thứ tự sử dụng của chúng được DAG bảo đảm.
+ * DAG không đổi sau khi xây, bộ đếm phụ thuộc của mỗi lần chạy nằm trong RunContext.
+ */
+typedef struct NodeDag {
+    int n_nodes;
+    int n_edges;
+    int n_roots;            // Node không phụ thuộc node nào (chỉ đọc input / weights)
+    int depth;              // Số node trên đường dài nhất (critical path)
+    int* n_deps;            // [n_nodes] số node trực tiếp đứng trước
+    int* succ_begin;        // [n_nodes + 1] danh sách node kế tiếp dạng CSR
+    int* succ;              // [n_edges]
+    int words;              // Số uint64_t của một bitset
+    uint64_t* ancestors;    // [n_nodes * words]
+} NodeDag;
+
+// Xây DAG từ input / output của các node (nodes đã theo thứ tự topo). Trả về NULL nếu lỗi cấp phát.
+NodeDag* node_dag_build(const ExecPlan* plan);
+void node_dag_free(NodeDag* dag);
+
+// Bitset ancestors của node i
+static inline const uint64_t* node_dag_ancestors(const NodeDag* dag, int i) {
+    return dag->ancestors + (size_t)i * dag->words;
+}
+
+// Node a chắc chắn chạy xong trước khi node b bắt đầu
+static inline int node_dag_precedes(const NodeDag* dag, int a, int b) {
+    return (int)((node_dag_ancestors(dag, b)[a >> 6] >> (a & 63)) & 1);
+}
+
+// Mọi node trong bitset set đều chạy xong trước khi node b bắt đầu
+int node_dag_all_precede(const NodeDag* dag, const uint64_t* set, int b);
+
+// Chạy toàn bộ node của plan theo DAG trên workspace ctx, trả về khi mọi node đã xong
+void node_dag_run(const NodeDag* dag, const ExecPlan* plan, RunContext* ctx);
+
+#endif // SCHEDULER_H
@@ -2,16 +2,84 @@
 #define TENSOR_H
 
 #include <stdlib.h>
+#include <stdint.h>
 
-// Định dạng NCHW (Batch, Channel, Height, Width)
+// Số channel trong một block của layout NCHWc (= số float trong một thanh ghi AVX2)
+#define TENSOR_BLOCK_C 8
+
+// Số chiều tối đa của một tensor
+#define TENSOR_MAX_RANK 8
+
+// Căn lề (byte) của data do tensor_create / tensor_create_nd cấp phát
+#define TENSOR_ALIGNMENT 64
+
+// Layout bộ nhớ của tensor. n, c, h, w luôn là kích thước logic (C chưa làm tròn).
+typedef enum {
+    TENSOR_LAYOUT_NCHW = 0,  // [N, C, H, W]
+    TENSOR_LAYOUT_NCHWC      // [N, ceil(C / 8), H, W, 8]: channel đệm ở block cuối bằng 0
+} TensorLayout;
+
+// Kiểu phần tử. Activation luôn là float32; int64 chỉ gặp ở initializer (shape, axes...)
+typedef enum {
+    TENSOR_FLOAT32 = 0,
+    TENSOR_INT64
+} TensorDType;
+
+/**
+ * Tensor rank-N: shape (dims) và strides (tính theo số phần tử) là nguồn chính.
+ * strides[i] = 0 nghĩa là chiều i được broadcast; view / transpose chỉ đổi dims + strides,
+ * dùng chung data. Tensor do tensor_set_shape tạo luôn liên tục (row-major).
+ *
+ * n, c, h, w là view 4 chiều của dims cho các kernel NCHW (Conv, Pool, NCHWc...):
+ * dims được căn phải, thiếu thì đệm 1 ở đầu, rank > 4 thì các chiều đầu được gộp vào n.
+ *   [K] -> (1, 1, 1, K)    [M, K] -> (1, 1, M, K)    [N, C, H, W] -> (N, C, H, W)
+ */
 typedef struct {
     char* name;      // Tên tensor (để lookup)
-    int n, c, h, w;  // Kích thước
-    float* data;     // Dữ liệu thực
+    int rank;
+    int dims[TENSOR_MAX_RANK];
+    size_t strides[TENSOR_MAX_RANK];
+    TensorDType dtype;
+    int n, c, h, w;  // View 4 chiều của dims (xem trên)
+    float* data;     // Dữ liệu thực (tensor int64: đọc qua tensor_int64_at)
+    TensorLayout layout;
 } Tensor;
 
+// Tensor 4 chiều [n, c, h, w] float32
 Tensor* tensor_create(const char* name, int n, int c, int h, int w);
+// Tensor rank-N, data căn lề TENSOR_ALIGNMENT và được đặt về 0
+Tensor* tensor_create_nd(const char* name, int rank, const int* dims, TensorDType dtype);
 void tensor_free(Tensor* t);
-Tensor* tensor_wrap(const char* name, int n, int c, int h, int w, float* raw_data);
+// Bản copy liên tục (data mới) của tensor t (layout NCHW), cùng tên, shape và dtype
+Tensor* tensor_clone(const Tensor* t);
+
+// Đặt shape mới (strides liên tục, cập nhật n, c, h, w); không cấp phát lại data
+void tensor_set_shape(Tensor* t, int rank, const int* dims);
+
+size_t tensor_numel(const Tensor* t);
+size_t tensor_dtype_size(TensorDType dtype);
+int tensor_is_contiguous(const Tensor* t);
+
+// Xem tensor như ma trận 2D: [tích các chiều trừ chiều cuối, chiều cuối] (Gemm, MatMul)
+void tensor_matrix_dims(const Tensor* t, int* rows, int* cols);
+
+// Phần tử thứ i (theo thứ tự row-major của dữ liệu liên tục) dưới dạng số nguyên, đọc được cả
+// tensor float32 lẫn int64 (dùng cho input shape / axes)
+int64_t tensor_int64_at(const Tensor* t, size_t i);
+
+// Hoán vị chiều không copy: dst->dims[i] = src->dims[perm[i]], dst dùng chung data với src
+void tensor_permute_view(Tensor* dst, const Tensor* src, const int* perm);
+
+/**
+ * Broadcast theo quy tắc NumPy / ONNX (căn phải, chiều 1 được kéo dãn).
+ * tensor_broadcast_shape: shape chung của a và b, trả về rank hoặc -1 nếu không tương thích
+ * tensor_broadcast_strides: strides để đọc t như tensor có shape (rank, dims), chiều bị kéo
+ *   dãn có stride 0; trả về -1 nếu t không broadcast được tới shape đó
+ */
+int tensor_broadcast_shape(const Tensor* a, const Tensor* b, int* dims);
+int tensor_broadcast_strides(const Tensor* t, int rank, const int* dims, size_t* strides);
+
+// Số float tensor chiếm trong bộ nhớ (kể cả channel đệm của layout NCHWc)
+size_t tensor_storage_size(const Tensor* t);
 
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <pthread.h>
 #include <math.h> 
 
 
@@ -9,9 +10,11 @@
 #include "include/onnx_parser.h"
 #include "include/tensor.h"
 #include "include/utils.h"
-
-// Prototype engine
-Tensor* engine_run(OnnxModel* model, Tensor* input_img);
+#include "include/engine.h"
+#include "include/pass_manager.h"
+#include "include/thread_pool.h"
+#include "include/batch_queue.h"
+#include "include/async_session.h"
 
 // --- HÀM LOAD RAW BINARY ---
 Tensor* load_tensor_raw(const char* filename, const char* tensor_name, int n, int c, int h, int w) {
@@ -21,11 +24,16 @@ Tensor* load_tensor_raw(const char* filename, const char* tensor_name, int n, in
         fprintf(stderr, "    -> Warning: Khong mo duoc file %s\n", filename);
         return NULL;
     }
-    int num_elements = n * c * h * w;
+    size_t sample_elements = (size_t)c * h * w;
+    size_t num_elements = (size_t)n * sample_elements;
     Tensor* t = tensor_create(tensor_name, n, c, h, w);
     size_t read_count = fread(t->data, sizeof(float), num_elements, f);
     fclose(f);
-    if (read_count != num_elements) {
+    if (read_count == sample_elements && n > 1) {
+        // File chỉ có một ảnh: nhân bản cho đủ batch
+        printf("    -> 1 sample in file, replicated to batch %d\n", n);
+        for (int b = 1; b < n; b++) memcpy(t->data + b * sample_elements, t->data, sample_elements * sizeof(float));
+    } else if (read_count != num_elements) {
         fprintf(stderr, "    -> Error: Doc thieu du lieu.\n");
         tensor_free(t); return NULL;
     }
@@ -44,22 +52,28 @@ void softmax(float* data, int n) {
     for(int i=0; i<n; i++) data[i] /= sum;
 }
 
+// Top 5 của từng ảnh trong batch (mỗi hàng của output là một ảnh)
 void print_top5(Tensor* out) {
-    int size = out->c * out->h * out->w; 
+    int batch = out->dims[0];
+    int size = (int)(tensor_numel(out) / batch); 
     printf("\nOutput Size: %d classes\n", size);
-    softmax(out->data, size);
-    printf("=== TOP 5 PREDICTIONS ===\n");
-    for (int k = 0; k < 5; k++) {
-        float max_val = -1.0f; int max_idx = -1;
-        for (int i = 0; i < size; i++) {
-            if (out->data[i] > max_val) { max_val = out->data[i]; max_idx = i; }
-        }
-        if (max_idx != -1) {
-            printf("#%d: Class ID %4d | Probability: %.2f%%\n", k+1, max_idx, max_val * 100.0f);
-            out->data[max_idx] = -1.0f; 
+    for (int b = 0; b < batch; b++) {
+        float* data = out->data + (size_t)b * size;
+        softmax(data, size);
+        if (batch > 1) printf("=== TOP 5 PREDICTIONS (sample %d) ===\n", b);
+        else printf("=== TOP 5 PREDICTIONS ===\n");
+        for (int k = 0; k < 5; k++) {
+            float max_val = -1.0f; int max_idx = -1;
+            for (int i = 0; i < size; i++) {
+                if (data[i] > max_val) { max_val = data[i]; max_idx = i; }
+            }
+            if (max_idx != -1) {
+                printf("#%d: Class ID %4d | Probability: %.2f%%\n", k+1, max_idx, max_val * 100.0f);
+                data[max_idx] = -1.0f; 
+            }
         }
+        printf("=========================\n");
     }
-    printf("=========================\n");
 }
 
 Tensor* create_random_input(const char* name, int n, int c, int h, int w) {
@@ -68,13 +82,158 @@ Tensor* create_random_input(const char* name, int n, int c, int h, int w) {
     return t;
 }
 
+// Thời gian thực (clock() cộng dồn CPU time của mọi thread nên không dùng được khi chạy song song)
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// --- DYNAMIC BATCHING: NHIỀU CLIENT, MỖI CLIENT GỬI TỪNG ẢNH MỘT ---
+typedef struct {
+    BatchQueue* queue;
+    const Tensor* input;
+    int n_requests;
+    Tensor* output;     // Kết quả của request cuối cùng (thuộc về client)
+} ClientArgs;
+
+static void* client_main(void* arg) {
+    ClientArgs* c = (ClientArgs*)arg;
+    for (int r = 0; r < c->n_requests; r++) {
+        Tensor* out = batch_queue_run(c->queue, c->input);
+        tensor_free(c->output);
+        c->output = out;
+    }
+    return NULL;
+}
+
+// n_clients thread cùng gửi ảnh đầu tiên của input qua batch queue, trả về output của client 0
+// (caller giải phóng bằng tensor_free)
+static Tensor* run_clients(EngineSession* session, const Tensor* input, int n_clients, int n_requests,
+                           int max_batch, int timeout_us) {
+    BatchQueue* queue = batch_queue_create(session, max_batch, timeout_us);
+    if (!queue) return NULL;
+
+    // View [1, C, H, W] của ảnh đầu tiên, dùng chung data với input
+    Tensor sample = *input;
+    int dims[TENSOR_MAX_RANK];
+    memcpy(dims, input->dims, sizeof(dims));
+    dims[0] = 1;
+    tensor_set_shape(&sample, input->rank, dims);
+
+    pthread_t* threads = (pthread_t*)malloc(n_clients * sizeof(pthread_t));
+    int* started = (int*)calloc(n_clients, sizeof(int));
+    ClientArgs* clients = (ClientArgs*)calloc(n_clients, sizeof(ClientArgs));
+    double start = now_seconds();
+    for (int i = 0; i < n_clients; i++) {
+        clients[i] = (ClientArgs){ queue, &sample, n_requests, NULL };
+        started[i] = (pthread_create(&threads[i], NULL, client_main, &clients[i]) == 0);
+        if (!started[i]) client_main(&clients[i]);
+    }
+    for (int i = 0; i < n_clients; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+    double elapsed = now_seconds() - start;
+    batch_queue_free(queue);
+    printf("%d clients x %d requests: %.4f seconds (%.1f images/s)\n",
+           n_clients, n_requests, elapsed, n_clients * n_requests / elapsed);
+
+    Tensor* output = clients[0].output;
+    for (int i = 1; i < n_clients; i++) tensor_free(clients[i].output);
+    free(clients);
+    free(started);
+    free(threads);
+    return output;
+}
+
+// --- ASYNC: n_requests REQUEST, TỐI ĐA max_in_flight REQUEST CHẠY CHỒNG NHAU ---
+// Trả về bản copy output của request cuối cùng (caller giải phóng bằng tensor_free)
+static Tensor* run_async(EngineSession* session, const Tensor* input, int n_requests, int max_in_flight) {
+    AsyncSession* async = async_session_create(session, max_in_flight);
+    if (!async) return NULL;
+
+    AsyncRequest** reqs = (AsyncRequest**)calloc(n_requests, sizeof(AsyncRequest*));
+    int oldest = 0;
+    double start = now_seconds();
+    for (int r = 0; r < n_requests; r++) {
+        // Đủ max_in_flight request đang chạy: đợi request cũ nhất rồi submit lại
+        while ((reqs[r] = async_session_submit(async, input)) == NULL) async_request_wait(reqs[oldest++]);
+    }
+    for (int r = oldest; r < n_requests; r++) async_request_wait(reqs[r]);
+    double elapsed = now_seconds() - start;
+    printf("%d async requests (max %d in flight): %.4f seconds (%.1f images/s)\n",
+           n_requests, max_in_flight, elapsed, n_requests * input->dims[0] / elapsed);
+
+    Tensor* last = async_request_wait(reqs[n_requests - 1]);
+    Tensor* output = last ? tensor_clone(last) : NULL;
+    for (int r = 0; r < n_requests; r++) async_request_free(reqs[r]);
+    free(reqs);
+    async_session_free(async);
+    return output;
+}
+
 // --- MAIN ---
 int main(int argc, char* argv[]) {
     const char* model_path = "model/resnet50-v1-12.onnx";
     const char* input_path = "model/input.bin"; 
+    int n_runs = 1;
+    int batch = 1;
+    int n_clients = 0;          // > 0: chạy qua batch queue thay vì gọi session trực tiếp
+    int max_batch = 8;
+    int batch_timeout_us = 1000;
+    int async_in_flight = 0;    // > 0: chạy n_runs request qua async API
 
-    if (argc > 1) model_path = argv[1];
-    if (argc > 2) input_path = argv[2];
+    // Tham số theo vị trí: [model] [input] [n_runs]; tùy chọn:
+    //   --disable-pass NAME (lặp lại được), --list-passes, --threads N (mặc định: số core),
+    //   --batch N (số ảnh mỗi lần chạy, file input có một ảnh thì được nhân bản),
+    //   --clients N (N thread gửi từng ảnh qua dynamic batching, mỗi thread n_runs request),
+    //   --max-batch N (mặc định 8), --batch-timeout US (mặc định 1000 micro giây),
+    //   --async N (submit n_runs request bất đồng bộ, tối đa N request chạy chồng nhau)
+    int n_positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--list-passes") == 0) {
+            graph_pass_list();
+            return 0;
+        }
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            thread_pool_set_size(atoi(argv[++i]));
+            continue;
+        }
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            n_clients = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--max-batch") == 0 && i + 1 < argc) {
+            max_batch = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--batch-timeout") == 0 && i + 1 < argc) {
+            batch_timeout_us = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--async") == 0 && i + 1 < argc) {
+            async_in_flight = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--disable-pass") == 0) {
+            if (i + 1 >= argc || graph_pass_set_enabled(argv[i + 1], 0) != 0) {
+                fprintf(stderr, "Unknown graph pass: %s (see --list-passes)\n", i + 1 < argc ? argv[i + 1] : "");
+                return -1;
+            }
+            i++;
+            continue;
+        }
+        if (n_positional == 0) model_path = argv[i];
+        else if (n_positional == 1) input_path = argv[i];
+        else if (n_positional == 2) n_runs = atoi(argv[i]);
+        n_positional++;
+    }
+    if (n_runs < 1) n_runs = 1;
+    if (batch < 1) batch = 1;
 
     printf("=== Custom Zero-Dependency ONNX Engine ===\n");
 
@@ -85,23 +244,43 @@ int main(int argc, char* argv[]) {
 
     // 2. LOAD INPUT
     char* input_name = (model->graph->input_name) ? model->graph->input_name : "data";
-    Tensor* input = load_tensor_raw(input_path, input_name, 1, 3, 224, 224);
+    Tensor* input = load_tensor_raw(input_path, input_name, batch, 3, 224, 224);
     if (!input) {
         printf("    -> Creating Random Input...\n");
-        input = create_random_input(input_name, 1, 3, 224, 224);
+        input = create_random_input(input_name, batch, 3, 224, 224);
     }
 
-    // 3. INFERENCE
-    printf("[3] Running Inference...\n");
-    clock_t start = clock();
-    Tensor* output = engine_run(model, input);
-    double time_taken = ((double)(clock() - start)) / CLOCKS_PER_SEC;
-    printf("Time: %.4f seconds\n", time_taken);
+    // 3. TẠO SESSION (load weights một lần)
+    double start = now_seconds();
+    EngineSession* session = engine_session_create(model);
+    if (!session) { fprintf(stderr, "Create Session Failed\n"); return -1; }
+    printf("[3] Session Ready. Time: %.4f seconds\n", now_seconds() - start);
+
+    // 4. INFERENCE (các lần chạy sau chỉ xử lý activations)
+    Tensor* output = NULL;
+    Tensor* owned_output = NULL;    // Output của batch queue / async API thuộc về caller
+    if (n_clients > 0) {
+        printf("[4] Running Inference (%d clients x %d request(s), dynamic batching)...\n", n_clients, n_runs);
+        output = owned_output = run_clients(session, input, n_clients, n_runs, max_batch, batch_timeout_us);
+    } else if (async_in_flight > 0) {
+        printf("[4] Running Inference (%d async request(s), batch %d)...\n", n_runs, batch);
+        output = owned_output = run_async(session, input, n_runs, async_in_flight);
+    } else {
+        printf("[4] Running Inference (%d run(s), batch %d)...\n", n_runs, batch);
+    }
+    for (int r = 0; r < n_runs && n_clients <= 0 && async_in_flight <= 0; r++) {
+        start = now_seconds();
+        output = engine_session_run(session, input);
+        double time_taken = now_seconds() - start;
+        printf("Run %d Time: %.4f seconds (%.1f images/s)\n", r + 1, time_taken, batch / time_taken);
+    }
 
-    // 4. OUTPUT
+    // 5. OUTPUT
     if (output) print_top5(output);
 
     // CLEANUP
+    tensor_free(owned_output);
+    engine_session_free(session);
     tensor_free(input);
     free_onnx_model(model); // Hàm mới
     return 0;
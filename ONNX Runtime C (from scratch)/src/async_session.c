@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "../include/tensor.h"
+#include "../include/engine.h"
+#include "../include/async_session.h"
+
+// ============================================================
+// 1. CẤU TRÚC
+// ============================================================
+
+struct AsyncRequest {
+    Tensor* input;              // Bản copy của input, giải phóng ngay sau khi chạy
+    Tensor* output;             // Bản copy của output (arena của ctx bị lần chạy sau ghi đè)
+    AsyncCallback callback;     // NULL: caller dùng poll / wait
+    void* user_data;
+    atomic_int done;
+    AsyncSession* owner;
+    struct AsyncRequest* next;
+};
+
+// Hàng đợi FIFO dạng danh sách liên kết
+typedef struct {
+    AsyncRequest* head;
+    AsyncRequest* tail;
+} RequestList;
+
+struct AsyncSession {
+    const EngineSession* session;
+    RunContext* ctx;            // Workspace của executor
+    int max_in_flight;
+    int n_in_flight;            // Đã submit, chưa xong (với callback: chưa gọi xong callback)
+
+    pthread_t executor;         // Chạy session
+    pthread_t completer;        // Gọi callback
+    pthread_mutex_t lock;
+    pthread_cond_t has_pending;     // Executor đợi request mới
+    pthread_cond_t has_finished;    // Completion thread đợi request đã chạy xong
+    pthread_cond_t has_result;      // Caller của async_request_wait đợi kết quả
+    RequestList pending;        // Đợi chạy
+    RequestList finished;       // Đã chạy, đợi callback
+    int stop_executor;
+    int stop_completer;
+};
+
+static void list_push(RequestList* l, AsyncRequest* r) {
+    r->next = NULL;
+    if (l->tail) l->tail->next = r;
+    else l->head = r;
+    l->tail = r;
+}
+
+static AsyncRequest* list_pop(RequestList* l) {
+    AsyncRequest* r = l->head;
+    if (r) {
+        l->head = r->next;
+        if (l->head == NULL) l->tail = NULL;
+    }
+    return r;
+}
+
+// ============================================================
+// 2. THREAD EXECUTOR VÀ COMPLETION
+// ============================================================
+
+static void* executor_main(void* arg) {
+    AsyncSession* a = (AsyncSession*)arg;
+
+    pthread_mutex_lock(&a->lock);
+    for (;;) {
+        while (a->pending.head == NULL && !a->stop_executor) pthread_cond_wait(&a->has_pending, &a->lock);
+        AsyncRequest* req = list_pop(&a->pending);
+        if (req == NULL) break;
+        pthread_mutex_unlock(&a->lock);
+
+        // Output nằm trong arena của ctx: copy ra trước khi chạy request kế tiếp
+        Tensor* out = engine_session_run_context(a->session, a->ctx, req->input);
+        req->output = out ? tensor_clone(out) : NULL;
+        tensor_free(req->input);
+        req->input = NULL;
+
+        pthread_mutex_lock(&a->lock);
+        if (req->callback) {
+            // Callback chạy trên thread completion, executor chuyển ngay sang request kế tiếp
+            list_push(&a->finished, req);
+            pthread_cond_signal(&a->has_finished);
+        } else {
+            atomic_store(&req->done, 1);
+            a->n_in_flight--;
+            pthread_cond_broadcast(&a->has_result);
+        }
+    }
+    pthread_mutex_unlock(&a->lock);
+    return NULL;
+}
+
+static void* completer_main(void* arg) {
+    AsyncSession* a = (AsyncSession*)arg;
+
+    pthread_mutex_lock(&a->lock);
+    for (;;) {
+        while (a->finished.head == NULL && !a->stop_completer) pthread_cond_wait(&a->has_finished, &a->lock);
+        AsyncRequest* req = list_pop(&a->finished);
+        if (req == NULL) break;
+        pthread_mutex_unlock(&a->lock);
+
+        // Output thuộc về callback, request tự giải phóng
+        req->callback(req->output, req->user_data);
+        free(req);
+
+        pthread_mutex_lock(&a->lock);
+        a->n_in_flight--;
+    }
+    pthread_mutex_unlock(&a->lock);
+    return NULL;
+}
+
+// ============================================================
+// 3. SESSION
+// ============================================================
+
+AsyncSession* async_session_create(EngineSession* session, int max_in_flight) {
+    AsyncSession* a = (AsyncSession*)calloc(1, sizeof(AsyncSession));
+    a->session = session;
+    a->ctx = engine_context_create(session);
+    a->max_in_flight = (max_in_flight > 0) ? max_in_flight : 0;
+    pthread_mutex_init(&a->lock, NULL);
+    pthread_cond_init(&a->has_pending, NULL);
+    pthread_cond_init(&a->has_finished, NULL);
+    pthread_cond_init(&a->has_result, NULL);
+
+    if (pthread_create(&a->executor, NULL, executor_main, a) != 0) {
+        fprintf(stderr, "[Error] Cannot start async executor thread\n");
+        goto fail;
+    }
+    if (pthread_create(&a->completer, NULL, completer_main, a) != 0) {
+        fprintf(stderr, "[Error] Cannot start async completion thread\n");
+        pthread_mutex_lock(&a->lock);
+        a->stop_executor = 1;
+        pthread_cond_signal(&a->has_pending);
+        pthread_mutex_unlock(&a->lock);
+        pthread_join(a->executor, NULL);
+        goto fail;
+    }
+    return a;
+
+fail:
+    pthread_cond_destroy(&a->has_pending);
+    pthread_cond_destroy(&a->has_finished);
+    pthread_cond_destroy(&a->has_result);
+    pthread_mutex_destroy(&a->lock);
+    engine_context_free(a->ctx);
+    free(a);
+    return NULL;
+}
+
+void async_session_free(AsyncSession* a) {
+    if (!a) return;
+
+    // Executor chạy hết hàng đợi rồi mới dừng, sau đó completion thread gọi hết callback
+    pthread_mutex_lock(&a->lock);
+    a->stop_executor = 1;
+    pthread_cond_signal(&a->has_pending);
+    pthread_mutex_unlock(&a->lock);
+    pthread_join(a->executor, NULL);
+
+    pthread_mutex_lock(&a->lock);
+    a->stop_completer = 1;
+    pthread_cond_signal(&a->has_finished);
+    pthread_mutex_unlock(&a->lock);
+    pthread_join(a->completer, NULL);
+
+    pthread_cond_destroy(&a->has_pending);
+    pthread_cond_destroy(&a->has_finished);
+    pthread_cond_destroy(&a->has_result);
+    pthread_mutex_destroy(&a->lock);
+    engine_context_free(a->ctx);
+    free(a);
+}
+
+// ============================================================
+// 4. SUBMIT / POLL / WAIT
+// ============================================================
+
+static AsyncRequest* submit(AsyncSession* a, const Tensor* input, AsyncCallback callback, void* user_data) {
+    pthread_mutex_lock(&a->lock);
+    if (a->max_in_flight > 0 && a->n_in_flight >= a->max_in_flight) {
+        pthread_mutex_unlock(&a->lock);
+        return NULL;
+    }
+    a->n_in_flight++;
+    pthread_mutex_unlock(&a->lock);
+
+    // Copy input ngoài lock, trên thread của caller (chồng lên request đang chạy)
+    AsyncRequest* req = (AsyncRequest*)calloc(1, sizeof(AsyncRequest));
+    req->input = tensor_clone(input);
+    req->callback = callback;
+    req->user_data = user_data;
+    req->owner = a;
+
+    pthread_mutex_lock(&a->lock);
+    list_push(&a->pending, req);
+    pthread_cond_signal(&a->has_pending);
+    pthread_mutex_unlock(&a->lock);
+    return req;
+}
+
+AsyncRequest* async_session_submit(AsyncSession* a, const Tensor* input) {
+    return submit(a, input, NULL, NULL);
+}
+
+int async_session_submit_callback(AsyncSession* a, const Tensor* input,
+                                  AsyncCallback callback, void* user_data) {
+    if (callback == NULL) return -1;
+    return submit(a, input, callback, user_data) ? 0 : -1;
+}
+
+int async_request_poll(const AsyncRequest* req) {
+    return atomic_load(&req->done);
+}
+
+Tensor* async_request_wait(AsyncRequest* req) {
+    if (!atomic_load(&req->done)) {
+        AsyncSession* a = req->owner;
+        pthread_mutex_lock(&a->lock);
+        while (!atomic_load(&req->done)) pthread_cond_wait(&a->has_result, &a->lock);
+        pthread_mutex_unlock(&a->lock);
+    }
+    return req->output;
+}
+
+void async_request_free(AsyncRequest* req) {
+    if (!req) return;
+    tensor_free(req->output);
+    free(req);
+}
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "../include/tensor.h"
+#include "../include/engine.h"
+#include "../include/batch_queue.h"
+
+// ============================================================
+// 1. CẤU TRÚC HÀNG ĐỢI
+// ============================================================
+
+// Request nằm trên stack của caller, caller đợi tới khi done = 1
+typedef struct BatchRequest {
+    const Tensor* input;
+    Tensor* output;
+    int done;
+    struct timespec arrival;
+    struct BatchRequest* next;
+} BatchRequest;
+
+struct BatchQueue {
+    const EngineSession* session;
+    RunContext* ctx;                // Workspace của dispatcher
+    int max_batch;
+    int timeout_us;
+
+    pthread_t dispatcher;
+    pthread_mutex_t lock;
+    pthread_cond_t has_request;     // Dispatcher đợi request mới
+    pthread_cond_t has_result;      // Caller đợi kết quả
+    BatchRequest* head;             // FIFO các request đang chờ
+    BatchRequest* tail;
+    int n_pending;                  // Tổng số ảnh đang chờ
+    int stop;
+
+    Tensor* batch_input;            // Input ghép, dùng lại giữa các batch (chỉ dispatcher truy cập)
+    size_t batch_capacity;          // Số float đã cấp phát cho batch_input->data
+
+    long n_requests;                // Thống kê
+    long n_batches;
+};
+
+// Số ảnh của một tensor (chiều đầu tiên)
+static int tensor_batch(const Tensor* t) {
+    return (t->rank > 0) ? t->dims[0] : 1;
+}
+
+// Hai input ghép được theo chiều batch nếu các chiều còn lại giống nhau
+static int same_sample_shape(const Tensor* a, const Tensor* b) {
+    if (a->rank != b->rank || a->dtype != b->dtype) return 0;
+    for (int i = 1; i < a->rank; i++) {
+        if (a->dims[i] != b->dims[i]) return 0;
+    }
+    return 1;
+}
+
+// Hạn chót của batch: thời điểm request cũ nhất đến + timeout_us
+static struct timespec deadline_after(const struct timespec* t, int timeout_us) {
+    struct timespec d = *t;
+    d.tv_sec += timeout_us / 1000000;
+    d.tv_nsec += (long)(timeout_us % 1000000) * 1000;
+    if (d.tv_nsec >= 1000000000L) {
+        d.tv_sec++;
+        d.tv_nsec -= 1000000000L;
+    }
+    return d;
+}
+
+// ============================================================
+// 2. DISPATCHER
+// ============================================================
+
+// Lấy ra đầu hàng đợi một nhóm request cùng shape, tổng không quá max_batch ảnh
+// (request đầu tiên luôn được lấy kể cả khi tự nó đã lớn hơn max_batch). Gọi khi giữ lock.
+static BatchRequest* take_batch(BatchQueue* q, int* n_images) {
+    BatchRequest* first = q->head;
+    BatchRequest* last = first;
+    int n = tensor_batch(first->input);
+    while (last->next && same_sample_shape(first->input, last->next->input) &&
+           n + tensor_batch(last->next->input) <= q->max_batch) {
+        last = last->next;
+        n += tensor_batch(last->input);
+    }
+    q->head = last->next;
+    if (q->head == NULL) q->tail = NULL;
+    last->next = NULL;
+    q->n_pending -= n;
+    *n_images = n;
+    return first;
+}
+
+// Ghép input của các request theo chiều batch vào q->batch_input
+static Tensor* gather_inputs(BatchQueue* q, BatchRequest* batch, int n_images) {
+    const Tensor* first = batch->input;
+    int dims[TENSOR_MAX_RANK];
+    memcpy(dims, first->dims, first->rank * sizeof(int));
+    dims[0] = n_images;
+
+    size_t sample = tensor_numel(first) / tensor_batch(first);
+    size_t total = sample * n_images;
+    size_t elem = tensor_dtype_size(first->dtype);
+    if (q->batch_input == NULL || total * elem > q->batch_capacity * sizeof(float)) {
+        tensor_free(q->batch_input);
+        q->batch_input = tensor_create_nd(first->name, first->rank, dims, first->dtype);
+        q->batch_capacity = (total * elem + sizeof(float) - 1) / sizeof(float);
+    }
+    Tensor* t = q->batch_input;
+    tensor_set_shape(t, first->rank, dims);
+    t->dtype = first->dtype;
+
+    char* dst = (char*)t->data;
+    for (BatchRequest* r = batch; r; r = r->next) {
+        size_t bytes = tensor_numel(r->input) * elem;
+        memcpy(dst, r->input->data, bytes);
+        dst += bytes;
+    }
+    return t;
+}
+
+// Tách output của batch thành một tensor riêng cho mỗi request
+static void scatter_outputs(BatchRequest* batch, const Tensor* out) {
+    size_t sample = (out && out->rank > 0 && out->dims[0] > 0) ? tensor_numel(out) / out->dims[0] : 0;
+    size_t elem = out ? tensor_dtype_size(out->dtype) : 0;
+    size_t offset = 0;
+
+    for (BatchRequest* r = batch; r; r = r->next) {
+        if (out == NULL) {
+            r->output = NULL;
+            continue;
+        }
+        int dims[TENSOR_MAX_RANK];
+        memcpy(dims, out->dims, out->rank * sizeof(int));
+        dims[0] = tensor_batch(r->input);
+        r->output = tensor_create_nd(out->name, out->rank, dims, out->dtype);
+        memcpy(r->output->data, (const char*)out->data + offset * elem, sample * dims[0] * elem);
+        offset += sample * dims[0];
+    }
+}
+
+static void* dispatcher_main(void* arg) {
+    BatchQueue* q = (BatchQueue*)arg;
+
+    pthread_mutex_lock(&q->lock);
+    for (;;) {
+        while (q->head == NULL && !q->stop) pthread_cond_wait(&q->has_request, &q->lock);
+        if (q->head == NULL) break;
+
+        // Đợi thêm request cho tới khi đủ max_batch ảnh hoặc request cũ nhất hết thời gian chờ
+        struct timespec deadline = deadline_after(&q->head->arrival, q->timeout_us);
+        while (q->n_pending < q->max_batch && !q->stop) {
+            if (pthread_cond_timedwait(&q->has_request, &q->lock, &deadline) == ETIMEDOUT) break;
+        }
+
+        int n_images;
+        BatchRequest* batch = take_batch(q, &n_images);
+        pthread_mutex_unlock(&q->lock);
+
+        // Chạy ngoài lock: caller mới vẫn xếp hàng được trong lúc batch này chạy
+        Tensor* input = gather_inputs(q, batch, n_images);
+        Tensor* out = engine_session_run_context(q->session, q->ctx, input);
+        scatter_outputs(batch, out);
+
+        pthread_mutex_lock(&q->lock);
+        for (BatchRequest* r = batch; r; r = r->next) {
+            r->done = 1;
+            q->n_requests++;
+        }
+        q->n_batches++;
+        pthread_cond_broadcast(&q->has_result);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+// ============================================================
+// 3. API
+// ============================================================
+
+BatchQueue* batch_queue_create(EngineSession* session, int max_batch, int timeout_us) {
+    BatchQueue* q = (BatchQueue*)calloc(1, sizeof(BatchQueue));
+    q->session = session;
+    q->ctx = engine_context_create(session);
+    q->max_batch = (max_batch > 0) ? max_batch : 1;
+    q->timeout_us = (timeout_us > 0) ? timeout_us : 0;
+    pthread_mutex_init(&q->lock, NULL);
+
+    // timedwait đo theo CLOCK_MONOTONIC để không bị ảnh hưởng khi giờ hệ thống bị chỉnh
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&q->has_request, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_cond_init(&q->has_result, NULL);
+
+    if (pthread_create(&q->dispatcher, NULL, dispatcher_main, q) != 0) {
+        fprintf(stderr, "[Error] Cannot start batch queue dispatcher\n");
+        pthread_cond_destroy(&q->has_request);
+        pthread_cond_destroy(&q->has_result);
+        pthread_mutex_destroy(&q->lock);
+        engine_context_free(q->ctx);
+        free(q);
+        return NULL;
+    }
+    printf("[BatchQueue] max batch %d, timeout %d us\n", q->max_batch, q->timeout_us);
+    return q;
+}
+
+Tensor* batch_queue_run(BatchQueue* q, const Tensor* input) {
+    BatchRequest req = { input, NULL, 0, { 0, 0 }, NULL };
+    clock_gettime(CLOCK_MONOTONIC, &req.arrival);
+
+    pthread_mutex_lock(&q->lock);
+    if (q->tail) q->tail->next = &req;
+    else q->head = &req;
+    q->tail = &req;
+    q->n_pending += tensor_batch(input);
+    pthread_cond_signal(&q->has_request);
+
+    while (!req.done) pthread_cond_wait(&q->has_result, &q->lock);
+    pthread_mutex_unlock(&q->lock);
+    return req.output;
+}
+
+void batch_queue_free(BatchQueue* q) {
+    if (!q) return;
+    pthread_mutex_lock(&q->lock);
+    q->stop = 1;
+    pthread_cond_signal(&q->has_request);
+    pthread_mutex_unlock(&q->lock);
+    pthread_join(q->dispatcher, NULL);
+
+    if (q->n_batches > 0) {
+        printf("[BatchQueue] %ld requests in %ld batches (%.2f requests / batch)\n",
+               q->n_requests, q->n_batches, (double)q->n_requests / q->n_batches);
+    }
+    tensor_free(q->batch_input);
+    engine_context_free(q->ctx);
+    pthread_cond_destroy(&q->has_request);
+    pthread_cond_destroy(&q->has_result);
+    pthread_mutex_destroy(&q->lock);
+    free(q);
+}
@@ -4,45 +4,31 @@
 #include <math.h>
 
 // [CHANGE] Thay thư viện protobuf-c bằng struct tự định nghĩa
-#include "../include/onnx_structs.h" 
+#include "../include/onnx_structs.h"
 #include "../include/tensor.h"
 #include "../include/operators.h"
-
-#define MAX_TENSORS 2000 
+#include "../include/exec_plan.h"
+#include "../include/op_registry.h"
+#include "../include/memory_planner.h"
+#include "../include/pass_manager.h"
+#include "../include/kernels.h"
+#include "../include/thread_pool.h"
+#include "../include/scheduler.h"
+#include "../include/engine.h"
 
 // ============================================================
-// 1. QUẢN LÝ TENSOR (SYMBOL TABLE)
+// 1. QUẢN LÝ SLOT (CHỈ DÙNG LÚC COMPILE)
 // ============================================================
 
-typedef struct {
-    char* name;
-    Tensor* tensor;
-} NamedTensor;
-
-typedef struct {
-    NamedTensor entries[MAX_TENSORS];
-    int count;
-} TensorTable;
-
-Tensor* get_tensor(TensorTable* table, char* name) {
-    for (int i = 0; i < table->count; i++) {
-        if (strcmp(table->entries[i].name, name) == 0) {
-            return table->entries[i].tensor;
-        }
-    }
-    fprintf(stderr, "[Error] Tensor not found: %s\n", name);
-    exit(1);
-    return NULL;
-}
-
-void register_tensor(TensorTable* table, char* name, Tensor* t) {
-    if (table->count >= MAX_TENSORS) {
-        fprintf(stderr, "[Error] Tensor table overflow!\n");
+// Resolve tên input của node thành slot. Tên rỗng = input optional bị bỏ trống.
+static int resolve_input(ExecPlan* plan, const char* name) {
+    if (name == NULL || name[0] == '\0') return -1;
+    int slot = exec_plan_find_slot(plan, name);
+    if (slot < 0) {
+        fprintf(stderr, "[Error] Tensor not found: %s\n", name);
         exit(1);
     }
-    table->entries[table->count].name = strdup(name);
-    table->entries[table->count].tensor = t;
-    table->count++;
+    return slot;
 }
 
 // ============================================================
@@ -81,211 +67,257 @@ float get_attr_float(OnnxNode* node, const char* name, float default_val) {
     return (attr) ? attr->f : default_val;
 }
 
-int calc_out_dim(int input_dim, int kernel, int stride, int pad, int dilation) {
-    return (input_dim + 2 * pad - dilation * (kernel - 1) - 1) / stride + 1;
+// Trích xuất toàn bộ attribute cần thiết một lần duy nhất
+static void extract_attrs(OnnxNode* node, NodeAttrs* a) {
+    a->kernel_shape[0] = a->kernel_shape[1] = 1;
+    a->strides[0] = a->strides[1] = 1;
+    a->pads[0] = a->pads[1] = a->pads[2] = a->pads[3] = 0;
+    a->dilations[0] = a->dilations[1] = 1;
+
+    get_attr_ints(node, "kernel_shape", a->kernel_shape, 2);
+    get_attr_ints(node, "strides", a->strides, 2);
+    get_attr_ints(node, "pads", a->pads, 4);
+    get_attr_ints(node, "dilations", a->dilations, 2);
+    a->group = get_attr_int(node, "group", 1);
+    a->epsilon = get_attr_float(node, "epsilon", 1e-5f);
+    a->alpha = get_attr_float(node, "alpha", 1.0f);
+    a->beta = get_attr_float(node, "beta", 1.0f);
+    a->transA = get_attr_int(node, "transA", 0);
+    a->transB = get_attr_int(node, "transB", 0);
+    a->axis = get_attr_int(node, "axis", 1);
+    OnnxAttribute* axes = find_attr(node, "axes");
+    a->n_axes = axes ? (axes->n_ints < 4 ? (int)axes->n_ints : 4) : 0;
+    get_attr_ints(node, "axes", a->axes, 4);
+    OnnxAttribute* perm = find_attr(node, "perm");
+    a->n_perm = perm ? (perm->n_ints < TENSOR_MAX_RANK ? (int)perm->n_ints : TENSOR_MAX_RANK) : 0;
+    get_attr_ints(node, "perm", a->perm, TENSOR_MAX_RANK);
 }
 
 // ============================================================
 // 3. HÀM CHUYỂN ĐỔI INITIALIZER (WEIGHTS)
 // ============================================================
-void load_initializers(TensorTable* table, OnnxGraph* graph) {
+void load_initializers(ExecPlan* plan, OnnxGraph* graph) {
     printf("Loading %d initializers...\n", graph->n_initializers);
-    
+
     for (int i = 0; i < graph->n_initializers; i++) {
         // [CHANGE] Dùng struct OnnxTensor mới
         OnnxTensor* init = graph->initializers[i];
-        
-        int n = 1, c = 1, h = 1, w = 1;
-        if (init->n_dims == 4) {
-            n = (int)init->dims[0]; c = (int)init->dims[1]; h = (int)init->dims[2]; w = (int)init->dims[3];
-        } else if (init->n_dims == 3) {
-            n = 1; c = (int)init->dims[0]; h = (int)init->dims[1]; w = (int)init->dims[2];
-        } else if (init->n_dims == 2) {
-            n = 1; c = 1; h = (int)init->dims[0]; w = (int)init->dims[1];
-        } else if (init->n_dims == 1) {
-            n = 1; c = 1; h = 1; w = (int)init->dims[0];
-        }
 
-        Tensor* t = tensor_create(init->name, n, c, h, w);
+        int dims[TENSOR_MAX_RANK];
+        int rank = (init->n_dims < TENSOR_MAX_RANK) ? init->n_dims : TENSOR_MAX_RANK;
+        for (int d = 0; d < rank; d++) dims[d] = (int)init->dims[d];
 
-        // [CHANGE] Parser mới đã convert sẵn raw_data sang float_data
-        if (init->float_data && init->n_float_data > 0) {
-            memcpy(t->data, init->float_data, init->n_float_data * sizeof(float));
+        Tensor* t;
+        if (init->int64_data) {
+            // Tensor số nguyên (shape của Reshape, axes...) giữ nguyên kiểu int64
+            t = tensor_create_nd(init->name, rank, dims, TENSOR_INT64);
+            size_t count = tensor_numel(t) < (size_t)init->n_int64_data ? tensor_numel(t) : (size_t)init->n_int64_data;
+            memcpy(t->data, init->int64_data, count * sizeof(int64_t));
         } else {
-            // Fallback nếu parser chưa xử lý raw data (tùy implementation parser)
-            // Nhưng với code parser ở bước trước, float_data luôn sẵn sàng.
-            fprintf(stderr, "[Warning] Initializer %s has no float data\n", init->name);
+            t = tensor_create_nd(init->name, rank, dims, TENSOR_FLOAT32);
+            if (init->float_data && init->n_float_data > 0) {
+                size_t count = tensor_numel(t) < (size_t)init->n_float_data ? tensor_numel(t) : (size_t)init->n_float_data;
+                memcpy(t->data, init->float_data, count * sizeof(float));
+            } else {
+                fprintf(stderr, "[Warning] Initializer %s has no float data\n", init->name);
+            }
         }
-        
-        register_tensor(table, init->name, t);
+
+        exec_plan_add_slot(plan, init->name, t);
     }
 }
 
 // ============================================================
-// 4. ENGINE CHÍNH (INFERENCE LOOP)
+// 4. COMPILE: GRAPH -> EXECUTION PLAN
 // ============================================================
 
-// [CHANGE] Tham số đầu vào là OnnxModel* mới
-Tensor* engine_run(OnnxModel* model, Tensor* input_img) {
-    TensorTable table = {0};
-    OnnxGraph* graph = model->graph;
-
-    // B1: Đăng ký Input Image
+// Resolve toàn bộ tên tensor thành slot và trích xuất attributes.
+// Sau bước này vòng lặp chạy không còn thao tác chuỗi nào.
+static int compile_plan(ExecPlan* plan, OnnxGraph* graph) {
     // [CHANGE] Trong parser mới, ta đã lưu tên input vào graph->input_name
-    if (graph->input_name) {
-        register_tensor(&table, graph->input_name, input_img);
-    } else {
-        // Fallback: Lấy input của node đầu tiên
-        register_tensor(&table, graph->nodes[0]->inputs[0], input_img);
-    }
+    // Fallback: Lấy input của node đầu tiên
+    const char* input_name = (graph->input_name) ? graph->input_name : graph->nodes[0]->inputs[0];
+    plan->input_slot = exec_plan_add_slot(plan, input_name, NULL);
 
-    // B2: Load Weights
-    load_initializers(&table, graph);
+    plan->nodes = (ExecNode*)calloc(graph->n_nodes, sizeof(ExecNode));
+    plan->n_nodes = graph->n_nodes;
 
-    printf("Starting Inference Loop on %d nodes...\n", graph->n_nodes);
-
-    // B3: Duyệt tuần tự các layer
     for (int i = 0; i < graph->n_nodes; i++) {
-        // [CHANGE] Struct node mới
         OnnxNode* node = graph->nodes[i];
-        char* op = node->op_type;
-        
-        // --- CONVOLUTION ---
-        if (strcmp(op, "Conv") == 0) {
-            // [CHANGE] Truy cập inputs mảng char**
-            Tensor* X = get_tensor(&table, node->inputs[0]);
-            Tensor* W = get_tensor(&table, node->inputs[1]);
-            Tensor* B = (node->n_inputs > 2) ? get_tensor(&table, node->inputs[2]) : NULL;
-
-            int pads[2] = {0, 0};
-            int strides[2] = {1, 1};
-            int dilations[2] = {1, 1};
-            int group = get_attr_int(node, "group", 1);
-            
-            get_attr_ints(node, "pads", pads, 2); 
-            get_attr_ints(node, "strides", strides, 2);
-            get_attr_ints(node, "dilations", dilations, 2);
-            
-            int pad_val = pads[0]; 
-
-            int out_h = calc_out_dim(X->h, W->h, strides[0], pad_val, dilations[0]);
-            int out_w = calc_out_dim(X->w, W->w, strides[1], pad_val, dilations[1]);
-            
-            // [CHANGE] Truy cập outputs mảng char**
-            Tensor* Y = tensor_create(node->outputs[0], X->n, W->n, out_h, out_w);
-            
-            op_conv2d(X, W, B, Y, strides[0], strides[1], pad_val, pad_val, dilations[0], dilations[1], group);
-            register_tensor(&table, node->outputs[0], Y);
-        }
-        
-        // --- BATCH NORMALIZATION ---
-        else if (strcmp(op, "BatchNormalization") == 0) {
-            Tensor* X = get_tensor(&table, node->inputs[0]);
-            Tensor* scale = get_tensor(&table, node->inputs[1]);
-            Tensor* B = get_tensor(&table, node->inputs[2]);
-            Tensor* mean = get_tensor(&table, node->inputs[3]);
-            Tensor* var = get_tensor(&table, node->inputs[4]);
-            
-            float epsilon = get_attr_float(node, "epsilon", 1e-5f);
-
-            Tensor* Y = tensor_create(node->outputs[0], X->n, X->c, X->h, X->w);
-            
-            op_batch_normalization(X, scale, B, mean, var, Y, epsilon);
-            register_tensor(&table, node->outputs[0], Y);
-        }
+        ExecNode* en = &plan->nodes[i];
 
-        // --- RELU ---
-        else if (strcmp(op, "Relu") == 0) {
-            Tensor* X = get_tensor(&table, node->inputs[0]);
-            Tensor* Y = tensor_create(node->outputs[0], X->n, X->c, X->h, X->w);
-            op_relu(X, Y);
-            register_tensor(&table, node->outputs[0], Y);
+        en->kernel = op_registry_find(node->op_type);
+        en->name = node->name;
+        if (en->kernel == NULL) {
+            fprintf(stderr, "[Error] Unsupported Operator: %s\n", node->op_type);
+            return -1;
         }
+        extract_attrs(node, &en->attrs);
 
-        // --- ADD ---
-        else if (strcmp(op, "Add") == 0) {
-            Tensor* A = get_tensor(&table, node->inputs[0]);
-            Tensor* B = get_tensor(&table, node->inputs[1]);
-            Tensor* Y = tensor_create(node->outputs[0], A->n, A->c, A->h, A->w);
-            op_add(A, B, Y);
-            register_tensor(&table, node->outputs[0], Y);
+        en->n_inputs = (node->n_inputs < MAX_NODE_IO) ? node->n_inputs : MAX_NODE_IO;
+        for (int j = 0; j < en->n_inputs; j++) {
+            en->inputs[j] = resolve_input(plan, node->inputs[j]);
         }
 
-        // --- MAX POOL ---
-        else if (strcmp(op, "MaxPool") == 0) {
-            Tensor* X = get_tensor(&table, node->inputs[0]);
-            
-            int kernel_shape[2] = {1, 1};
-            int strides[2] = {1, 1};
-            int pads[2] = {0, 0};
-            
-            get_attr_ints(node, "kernel_shape", kernel_shape, 2);
-            get_attr_ints(node, "strides", strides, 2);
-            get_attr_ints(node, "pads", pads, 2); 
-
-            int out_h = calc_out_dim(X->h, kernel_shape[0], strides[0], pads[0], 1);
-            int out_w = calc_out_dim(X->w, kernel_shape[1], strides[1], pads[0], 1);
-
-            Tensor* Y = tensor_create(node->outputs[0], X->n, X->c, out_h, out_w);
-            op_maxpool(X, Y, kernel_shape[0], kernel_shape[1], strides[0], strides[1], pads[0], pads[0]);
-            register_tensor(&table, node->outputs[0], Y);
+        // Mỗi output là một slot activation mới, Tensor được cấp phát khi chạy
+        en->n_outputs = (node->n_outputs < MAX_NODE_IO) ? node->n_outputs : MAX_NODE_IO;
+        for (int j = 0; j < en->n_outputs; j++) {
+            Tensor* t = (Tensor*)calloc(1, sizeof(Tensor));
+            t->name = strdup(node->outputs[j]);
+            en->outputs[j] = exec_plan_add_slot(plan, node->outputs[j], t);
         }
+    }
+
+    // [CHANGE] Lấy tên output từ graph parser mới
+    // Fallback: Lấy output của node cuối cùng
+    const char* output_name = (graph->output_name) ? graph->output_name
+                                                   : graph->nodes[graph->n_nodes - 1]->outputs[0];
+    plan->output_slot = resolve_input(plan, output_name);
+
+    printf("[Engine] Compiled %d nodes, %d tensor slots. Final Output Tensor: %s\n",
+           plan->n_nodes, plan->n_slots, output_name);
+    return 0;
+}
 
-        // --- GLOBAL AVERAGE POOL ---
-        else if (strcmp(op, "GlobalAveragePool") == 0) {
-            Tensor* X = get_tensor(&table, node->inputs[0]);
-            Tensor* Y = tensor_create(node->outputs[0], X->n, X->c, 1, 1);
-            op_global_average_pool(X, Y);
-            register_tensor(&table, node->outputs[0], Y);
+// Chèn copy cho view có stride, cấp slot scratch rồi gọi prepare của từng op một lần duy nhất
+// (pack weights, chọn thuật toán...)
+static int prepare_plan(ExecPlan* plan) {
+    exec_plan_add_contiguous_copies(plan);
+    exec_plan_add_scratch_slots(plan);
+    for (int i = 0; i < plan->n_nodes; i++) {
+        ExecNode* node = &plan->nodes[i];
+        node->kernels = plan->kernels;
+        if (node->kernel->prepare && node->kernel->prepare(node, plan->slots) != 0) {
+            fprintf(stderr, "[Error] Prepare failed at node %s (%s)\n", node->name, node->kernel->op_type);
+            return -1;
         }
+    }
+    return 0;
+}
+
+// ============================================================
+// 5. SESSION (LOAD WEIGHTS + COMPILE MỘT LẦN)
+// ============================================================
+
+struct EngineSession {
+    OnnxModel* model;
+    ExecPlan plan;
+    RunContext* default_ctx;    // Workspace của engine_session_run
+};
+
+EngineSession* engine_session_create(OnnxModel* model) {
+    return engine_session_create_isa(model, cpu_detect_isa());
+}
+
+EngineSession* engine_session_create_isa(OnnxModel* model, CpuIsa max_isa) {
+    EngineSession* session = (EngineSession*)calloc(1, sizeof(EngineSession));
+    session->model = model;
+
+    // Chọn bản kernel theo tập lệnh của CPU đang chạy (trước layout pass và prepare);
+    // bảng thuộc về plan nên session tạo sau không đổi kernel của session này
+    const KernelTable* kt = kernels_select(max_isa);
+    session->plan.kernels = kt;
+    printf("[Engine] CPU ISA: %s, kernels: %s\n", cpu_isa_name(cpu_detect_isa()), kt->name);
+    printf("[Engine] Threads: %d\n", thread_pool_size());
+
+    load_initializers(&session->plan, model->graph);
+    session->plan.n_weights = session->plan.n_slots;
+    if (compile_plan(&session->plan, model->graph) != 0 ||
+        graph_passes_run(&session->plan) != 0 ||
+        prepare_plan(&session->plan) != 0) {
+        engine_session_free(session);
+        return NULL;
+    }
 
-        // --- FLATTEN ---
-        else if (strcmp(op, "Flatten") == 0) {
-            Tensor* X = get_tensor(&table, node->inputs[0]);
-            int flatten_dim = X->c * X->h * X->w;
-            Tensor* Y = tensor_create(node->outputs[0], X->n, flatten_dim, 1, 1);
-            op_flatten(X, Y);
-            register_tensor(&table, node->outputs[0], Y);
+    // Nhiều thread: các node độc lập chạy song song theo DAG phụ thuộc dữ liệu (trước memory planner)
+    if (thread_pool_size() > 1) {
+        NodeDag* dag = node_dag_build(&session->plan);
+        if (dag) {
+            printf("[Engine] DAG scheduler: %d nodes, %d edges, %d roots, critical path %d nodes\n",
+                   dag->n_nodes, dag->n_edges, dag->n_roots, dag->depth);
         }
+        session->plan.dag = dag;
+    }
+    session->default_ctx = exec_plan_context_create(&session->plan);
+    return session;
+}
+
+void engine_session_free(EngineSession* session) {
+    if (!session) return;
+    ExecPlan* plan = &session->plan;
+    exec_plan_context_free(session->default_ctx);
+    for (int i = 0; i < plan->n_slots; i++) {
+        // Slot input thuộc về caller, tensor mẫu của activations không có data
+        if (i != plan->input_slot) tensor_free(plan->slots[i]);
+        free(plan->slot_names[i]);
+    }
+    node_dag_free(plan->dag);
+    for (int i = 0; i < plan->n_nodes; i++) {
+        ExecNode* node = &plan->nodes[i];
+        if (node->kernel && node->kernel->release) node->kernel->release(node);
+    }
+    free(plan->slots);
+    free(plan->slot_names);
+    free(plan->nodes);
+    free(session);
+}
 
-       // --- GEMM ---
-        else if (strcmp(op, "Gemm") == 0) {
-            Tensor* A = get_tensor(&table, node->inputs[0]);
-            Tensor* B = get_tensor(&table, node->inputs[1]);
-            Tensor* C = (node->n_inputs > 2) ? get_tensor(&table, node->inputs[2]) : NULL;
-
-            float alpha = get_attr_float(node, "alpha", 1.0f);
-            float beta = get_attr_float(node, "beta", 1.0f);
-            int transA = get_attr_int(node, "transA", 0);
-            int transB = get_attr_int(node, "transB", 0);
-
-            // [SỬA LỖI TẠI ĐÂY]
-            // Struct Tensor chỉ có h, w. Không có dims[].
-            // Hàm load_initializers đã map: h = rows, w = cols
-            int rows_B = B->h;
-            int cols_B = B->w; 
-
-            // Tính số lượng đầu ra dựa trên việc B có bị transpose hay không
-            int out_features = (transB) ? rows_B : cols_B; 
-
-            Tensor* Y = tensor_create(node->outputs[0], A->n, 1, 1, out_features);
-            op_gemm(A, B, C, Y, alpha, beta, transA, transB);
-            register_tensor(&table, node->outputs[0], Y);
+// Chạy infer_shape cho toàn bộ graph rồi lập kế hoạch bộ nhớ cho activations của ctx.
+// Chỉ gọi khi shape input thay đổi, arena được giữ lại giữa các lần chạy.
+static int infer_shapes(const ExecPlan* plan, RunContext* ctx) {
+    for (int i = 0; i < plan->n_nodes; i++) {
+        ExecNode* node = &plan->nodes[i];
+        if (node->kernel->infer_shape(node, ctx->slots) != 0) {
+            fprintf(stderr, "[Error] Shape inference failed at node %s (%s)\n", node->name, node->kernel->op_type);
+            return -1;
         }
-        else {
-            printf("[Warning] Unsupported Operator: %s\n", op);
+    }
+    return memory_plan_activations(plan, ctx);
+}
+
+RunContext* engine_context_create(const EngineSession* session) {
+    return exec_plan_context_create(&session->plan);
+}
+
+void engine_context_free(RunContext* ctx) {
+    exec_plan_context_free(ctx);
+}
+
+// ============================================================
+// 6. ENGINE CHÍNH (INFERENCE LOOP)
+// ============================================================
+
+Tensor* engine_session_run(EngineSession* session, Tensor* input_img) {
+    return engine_session_run_context(session, session->default_ctx, input_img);
+}
+
+Tensor* engine_session_run_context(const EngineSession* session, RunContext* ctx, Tensor* input_img) {
+    const ExecPlan* plan = &session->plan;
+    Tensor** slots = ctx->slots;
+
+    // B1: Gắn Input Image vào slot input
+    slots[plan->input_slot] = input_img;
+
+    // B2: Shape chỉ được tính lại khi shape input khác lần chạy trước trên ctx này
+    if (ctx->input_rank != input_img->rank ||
+        memcmp(ctx->input_dims, input_img->dims, input_img->rank * sizeof(int)) != 0) {
+        if (infer_shapes(plan, ctx) != 0) {
+            ctx->input_rank = -1;
+            return NULL;
         }
+        ctx->input_rank = input_img->rank;
+        memcpy(ctx->input_dims, input_img->dims, input_img->rank * sizeof(int));
     }
-    
-    // [CHANGE] Lấy tên output từ graph parser mới
-    char* output_name = NULL;
-    if (graph->output_name) {
-        output_name = graph->output_name;
+
+    // B3: Chạy các node theo DAG (nhiều thread) hoặc tuần tự, dispatch qua con trỏ hàm đã resolve sẵn
+    if (plan->dag) {
+        node_dag_run(plan->dag, plan, ctx);
     } else {
-        // Fallback: Lấy output của node cuối cùng
-        output_name = graph->nodes[graph->n_nodes - 1]->outputs[0];
+        for (int i = 0; i < plan->n_nodes; i++) {
+            ExecNode* node = &plan->nodes[i];
+            node->kernel->compute(node, slots);
+        }
     }
-    
-    printf("[Engine] Final Output Tensor: %s\n", output_name);
-    return get_tensor(&table, output_name);
-}
\ No newline at end of file
+
+    return slots[plan->output_slot];
+}
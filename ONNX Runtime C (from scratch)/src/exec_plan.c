@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/exec_plan.h"
+#include "../include/op_registry.h"
+
+// ============================================================
+// SLOT
+// ============================================================
+
+int exec_plan_add_slot(ExecPlan* plan, const char* name, Tensor* t) {
+    if (plan->n_slots >= plan->cap_slots) {
+        plan->cap_slots = (plan->cap_slots > 0) ? plan->cap_slots * 2 : 256;
+        plan->slots = (Tensor**)realloc(plan->slots, plan->cap_slots * sizeof(Tensor*));
+        plan->slot_names = (char**)realloc(plan->slot_names, plan->cap_slots * sizeof(char*));
+    }
+    plan->slot_names[plan->n_slots] = strdup(name);
+    plan->slots[plan->n_slots] = t;
+    return plan->n_slots++;
+}
+
+int exec_plan_find_slot(const ExecPlan* plan, const char* name) {
+    for (int i = 0; i < plan->n_slots; i++) {
+        if (strcmp(plan->slot_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Slot liên tục thay cho slot có stride `slot`, chèn node Contiguous nếu chưa có
+static int get_contiguous(ExecPlan* plan, int slot, int* copied, ExecNode* nodes, int* n_nodes) {
+    if (copied[slot] >= 0) return copied[slot];
+
+    char name[256];
+    snprintf(name, sizeof(name), "%s_contiguous", plan->slot_names[slot]);
+    Tensor* t = (Tensor*)calloc(1, sizeof(Tensor));
+    t->name = strdup(name);
+    int out = exec_plan_add_slot(plan, name, t);
+
+    ExecNode* node = &nodes[(*n_nodes)++];
+    memset(node, 0, sizeof(ExecNode));
+    node->kernel = op_registry_contiguous_kernel();
+    node->name = plan->slot_names[out];
+    node->inputs[0] = slot;
+    node->n_inputs = 1;
+    node->outputs[0] = out;
+    node->n_outputs = 1;
+
+    copied[slot] = out;
+    return out;
+}
+
+void exec_plan_add_contiguous_copies(ExecPlan* plan) {
+    int n_orig_slots = plan->n_slots;
+    char* strided = (char*)calloc(n_orig_slots, 1);
+    int* copied = (int*)malloc(n_orig_slots * sizeof(int));
+    for (int i = 0; i < n_orig_slots; i++) copied[i] = -1;
+    ExecNode* nodes = (ExecNode*)calloc(plan->n_nodes + n_orig_slots + 1, sizeof(ExecNode));
+    int n_nodes = 0;
+
+    for (int i = 0; i < plan->n_nodes; i++) {
+        ExecNode node = plan->nodes[i];
+        unsigned flags = node.kernel->flags;
+        if (!(flags & OP_FLAG_STRIDED)) {
+            for (int j = 0; j < node.n_inputs; j++) {
+                int s = node.inputs[j];
+                if (s >= 0 && s < n_orig_slots && strided[s]) node.inputs[j] = get_contiguous(plan, s, copied, nodes, &n_nodes);
+            }
+        }
+        // View nhận input có stride thì output cũng có thể có stride (Transpose luôn vậy)
+        if ((flags & (OP_FLAG_VIEW | OP_FLAG_STRIDED)) == (OP_FLAG_VIEW | OP_FLAG_STRIDED)) strided[node.outputs[0]] = 1;
+        nodes[n_nodes++] = node;
+    }
+
+    // Caller đọc output của graph như dữ liệu liên tục
+    if (strided[plan->output_slot]) plan->output_slot = get_contiguous(plan, plan->output_slot, copied, nodes, &n_nodes);
+
+    free(plan->nodes);
+    plan->nodes = nodes;
+    plan->n_nodes = n_nodes;
+    free(strided);
+    free(copied);
+}
+
+void exec_plan_add_scratch_slots(ExecPlan* plan) {
+    for (int i = 0; i < plan->n_nodes; i++) {
+        ExecNode* node = &plan->nodes[i];
+        node->scratch_slot = -1;
+        if (!(node->kernel->flags & OP_FLAG_SCRATCH)) continue;
+
+        char name[256];
+        snprintf(name, sizeof(name), "%s:scratch", node->n_outputs > 0 ? plan->slot_names[node->outputs[0]] : "node");
+        Tensor* t = (Tensor*)calloc(1, sizeof(Tensor));
+        t->name = strdup(name);
+        node->scratch_slot = exec_plan_add_slot(plan, name, t);
+    }
+}
+
+// ============================================================
+// RUN CONTEXT
+// ============================================================
+
+RunContext* exec_plan_context_create(const ExecPlan* plan) {
+    int first = plan->n_weights;
+    RunContext* ctx = (RunContext*)calloc(1, sizeof(RunContext));
+    ctx->slots = (Tensor**)calloc(plan->n_slots, sizeof(Tensor*));
+    ctx->tensors = (Tensor*)calloc(plan->n_slots - first, sizeof(Tensor));
+    ctx->input_rank = -1;
+
+    // Weights dùng chung; activation copy tensor mẫu của plan (tên, layout), data do planner gán
+    for (int s = 0; s < first; s++) ctx->slots[s] = plan->slots[s];
+    for (int s = first; s < plan->n_slots; s++) {
+        if (s == plan->input_slot) continue;
+        ctx->tensors[s - first] = *plan->slots[s];
+        ctx->tensors[s - first].data = NULL;
+        ctx->slots[s] = &ctx->tensors[s - first];
+    }
+    if (plan->dag) ctx->pending = (atomic_int*)calloc(plan->n_nodes, sizeof(atomic_int));
+    return ctx;
+}
+
+void exec_plan_context_free(RunContext* ctx) {
+    if (!ctx) return;
+    free(ctx->arena);
+    free(ctx->pending);
+    free(ctx->tensors);
+    free(ctx->slots);
+    free(ctx);
+}
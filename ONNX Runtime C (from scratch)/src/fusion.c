@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../include/tensor.h"
+#include "../include/exec_plan.h"
+#include "../include/op_registry.h"
+#include "../include/graph.h"
+#include "../include/fusion.h"
+
+// Vị trí cố định trong inputs[] của Conv đã fuse: [X, W, B, scale, B_bn, mean, var, residual]
+#define FUSED_BN_INPUT 3
+#define FUSED_RESIDUAL_INPUT 7
+
+// ============================================================
+// 1. HELPER FUNCTIONS
+// ============================================================
+
+static int is_op(const ExecNode* node, const char* op_type) {
+    return strcmp(node->kernel->op_type, op_type) == 0;
+}
+
+static int has_fused(const ExecNode* node) {
+    return node->fused.bn_input != 0 || node->fused.residual_input != 0 || node->fused.relu;
+}
+
+// Tham số BatchNorm phải là initializer có đúng `channels` phần tử (được gộp lúc prepare)
+static int bn_params_ok(const ExecPlan* plan, const ExecNode* bn, int channels) {
+    if (bn->n_inputs != 5 || bn->n_outputs != 1) return 0;
+    for (int k = 1; k < 5; k++) {
+        int s = bn->inputs[k];
+        if (s < 0 || s >= plan->n_weights || plan->slots[s] == NULL) return 0;
+        const Tensor* t = plan->slots[s];
+        if ((size_t)t->n * t->c * t->h * t->w != (size_t)channels) return 0;
+    }
+    return 1;
+}
+
+// Slot là initializer chỉ được đúng một node đọc (được phép sửa dữ liệu tại chỗ)
+static int private_weight(const GraphIndex* g, int slot) {
+    const ExecPlan* plan = g->plan;
+    return slot >= 0 && slot < plan->n_weights && plan->slots[slot] != NULL && g->use_count[slot] == 1;
+}
+
+// Các input chưa dùng tới vị trí n được đánh dấu bỏ trống
+static void extend_inputs(ExecNode* node, int n) {
+    for (int k = node->n_inputs; k < n; k++) node->inputs[k] = -1;
+    if (node->n_inputs < n) node->n_inputs = n;
+}
+
+// ============================================================
+// 2. BATCHNORM FOLDING
+// ============================================================
+// y = (W * x + b - mean) * gamma / sqrt(var + eps) + beta
+//   = (W * s) * x + (b - mean) * s + beta,   s = gamma / sqrt(var + eps) theo từng output channel
+
+
+static const PatternStep conv_bn_pattern[] = {
+    { "BatchNormalization", 0, 0 },
+};
+
+int fusion_fold_batchnorm(ExecPlan* plan) {
+    if (plan->n_nodes <= 0) return 0;
+    GraphIndex g;
+    graph_index_build(&g, plan);
+    int n_folded = 0;
+
+    for (int i = 0; i < plan->n_nodes; i++) {
+        const ExecNode* conv = &plan->nodes[i];
+        if (g.removed[i] || !is_op(conv, "Conv") || conv->n_outputs != 1 || !private_weight(&g, conv->inputs[1])) continue;
+        Tensor* W = plan->slots[conv->inputs[1]];
+
+        int m[1];
+        if (graph_match_chain(&g, i, conv_bn_pattern, 1, m) < 1) continue;
+        const ExecNode* bn = &plan->nodes[m[0]];
+        if (!bn_params_ok(plan, bn, W->n)) continue;
+
+        // Bias sau khi gộp được ghi đè vào bias của Conv, hoặc vào beta của BN nếu Conv không có bias
+        int has_bias = (conv->n_inputs > 2 && conv->inputs[2] >= 0);
+        int bias_slot = has_bias ? conv->inputs[2] : bn->inputs[2];
+        if (!private_weight(&g, bias_slot)) continue;
+
+        const float* gamma = plan->slots[bn->inputs[1]]->data;
+        const float* beta = plan->slots[bn->inputs[2]]->data;
+        const float* mean = plan->slots[bn->inputs[3]]->data;
+        const float* var = plan->slots[bn->inputs[4]]->data;
+        float* bias = plan->slots[bias_slot]->data;
+        size_t w_per_oc = (size_t)W->c * W->h * W->w;
+
+        for (int oc = 0; oc < W->n; oc++) {
+            float s = gamma[oc] / sqrtf(var[oc] + bn->attrs.epsilon);
+            float* w = W->data + (size_t)oc * w_per_oc;
+            for (size_t k = 0; k < w_per_oc; k++) w[k] *= s;
+            float b = has_bias ? bias[oc] : 0.0f;
+            bias[oc] = (b - mean[oc]) * s + beta[oc];
+        }
+
+        // Conv ghi thẳng vào output của BN (mọi node đọc output đó đều nằm sau BN)
+        ExecNode folded = *conv;
+        extend_inputs(&folded, 3);
+        folded.inputs[2] = bias_slot;
+        folded.outputs[0] = bn->outputs[0];
+        graph_remove_node(&g, m[0]);
+        graph_set_node(&g, i, &folded);
+        n_folded++;
+    }
+
+    int n_removed = graph_compact(&g);
+    if (n_folded > 0) {
+        printf("[Fusion] %d BatchNorm folded into Conv weights\n", n_folded);
+    }
+
+    graph_index_free(&g);
+    return n_removed;
+}
+
+// ============================================================
+// 3. FUSION PASS
+// ============================================================
+
+enum { STEP_BN = 0, STEP_ADD, STEP_RELU, N_EPILOGUE_STEPS };
+
+// Conv -> [BatchNormalization] -> [Add(residual)] -> [Relu]
+static const PatternStep conv_epilogue_pattern[N_EPILOGUE_STEPS] = {
+    { "BatchNormalization", 1, 0 },
+    { "Add",                1, 1 },
+    { "Relu",               1, 0 },
+};
+
+int fusion_apply(ExecPlan* plan) {
+    if (plan->n_nodes <= 0) return 0;
+    GraphIndex g;
+    graph_index_build(&g, plan);
+    // Shape được suy ra trên plan trước khi fuse (slot không đổi khi node được gộp)
+    GraphShapes* shapes = graph_shapes_build(plan);
+
+    int n_conv = 0, n_bn = 0, n_add = 0, n_relu = 0;
+    for (int i = 0; i < plan->n_nodes; i++) {
+        ExecNode node = plan->nodes[i];
+        // Node đã fuse ở lượt trước (được dời tới vị trí này) không xét lại
+        if (g.removed[i] || !(node.kernel->flags & OP_FLAG_FUSE_EPILOGUE) || has_fused(&node)) continue;
+        if (node.n_inputs > FUSED_BN_INPUT || node.n_outputs != 1) continue;
+
+        int m[N_EPILOGUE_STEPS];
+        if (graph_match_chain(&g, i, conv_epilogue_pattern, N_EPILOGUE_STEPS, m) <= 0) continue;
+
+        // Điều kiện ngoài op_type: chuỗi bị cắt tại bước đầu tiên không thỏa
+        const Tensor* W = plan->slots[node.inputs[1]];
+        if (m[STEP_BN] >= 0 && (W == NULL || !bn_params_ok(plan, &plan->nodes[m[STEP_BN]], W->n))) {
+            m[STEP_BN] = m[STEP_ADD] = m[STEP_RELU] = -1;
+        }
+        int cur = (m[STEP_BN] >= 0) ? plan->nodes[m[STEP_BN]].outputs[0] : node.outputs[0];
+        int other = -1;
+        if (m[STEP_ADD] >= 0) {
+            const ExecNode* add = &plan->nodes[m[STEP_ADD]];
+            other = (add->inputs[0] == cur) ? add->inputs[1] : add->inputs[0];
+            // Toán hạng là initializer thường là bias được broadcast, không phải residual.
+            // Epilogue cộng residual theo từng phần tử: chỉ gộp khi chắc chắn cùng shape với output
+            // của Conv, Add có broadcast giữ nguyên là node riêng (op_add_broadcast)
+            if (add->n_inputs != 2 || other < plan->n_weights || other == cur ||
+                !graph_shapes_equal(shapes, other, cur)) {
+                m[STEP_ADD] = m[STEP_RELU] = -1;
+            }
+        }
+
+        if (m[STEP_BN] >= 0) {
+            const ExecNode* bn = &plan->nodes[m[STEP_BN]];
+            extend_inputs(&node, FUSED_BN_INPUT + 4);
+            for (int k = 0; k < 4; k++) node.inputs[FUSED_BN_INPUT + k] = bn->inputs[1 + k];
+            node.fused.bn_input = FUSED_BN_INPUT;
+            node.fused.bn_epsilon = bn->attrs.epsilon;
+            n_bn++;
+        }
+        if (m[STEP_ADD] >= 0) {
+            extend_inputs(&node, FUSED_RESIDUAL_INPUT + 1);
+            node.inputs[FUSED_RESIDUAL_INPUT] = other;
+            node.fused.residual_input = FUSED_RESIDUAL_INPUT;
+            n_add++;
+        }
+        if (m[STEP_RELU] >= 0) {
+            node.fused.relu = 1;
+            n_relu++;
+        }
+
+        int last = i;
+        for (int k = 0; k < N_EPILOGUE_STEPS; k++) {
+            if (m[k] < 0) continue;
+            node.outputs[0] = plan->nodes[m[k]].outputs[0];
+            graph_remove_node(&g, m[k]);
+            last = m[k];
+        }
+        if (last == i) continue;
+
+        // Conv ghi thẳng vào output của cả chuỗi, chạy tại vị trí của node cuối
+        graph_remove_node(&g, i);
+        graph_set_node(&g, last, &node);
+        n_conv++;
+    }
+
+    int n_before = plan->n_nodes;
+    int n_removed = graph_compact(&g);
+    if (n_conv > 0) {
+        printf("[Fusion] %d Conv fused (%d BatchNorm, %d Add, %d Relu): %d -> %d nodes\n",
+               n_conv, n_bn, n_add, n_relu, n_before, plan->n_nodes);
+    }
+
+    graph_shapes_free(shapes);
+    graph_index_free(&g);
+    return n_removed;
+}
@@ -0,0 +1,345 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../include/gemm.h"
+#include "../include/kernels.h" // GEMM_MR, GEMM_NR và micro-kernel theo ISA
+#include "../include/thread_pool.h"
+
+// Kích thước block cache: A (MC x KC) nằm trong L2, panel B (KC x NR) nằm trong L1
+#define GEMM_MC 96
+#define GEMM_KC 256
+#define GEMM_NC 2048
+
+#define GEMM_ALIGN 64
+
+// Dưới ngưỡng này (số phép tính) SGEMM / GEMV chạy trên một thread
+#define GEMM_PARALLEL_MIN_FLOPS (1 << 18)
+
+// ============================================================
+// 1. BUFFER PACKING (mỗi thread một bộ, cấp phát một lần)
+// ============================================================
+
+// Một khối cho cả hai buffer; thread kết thúc thì destructor của pack_key giải phóng khối này
+// (dispatcher của batch queue, executor async, thread của caller đều có thể thoát trước chương trình)
+static _Thread_local float* pack_a = NULL;
+static _Thread_local float* pack_b = NULL;
+static pthread_key_t pack_key;
+static pthread_once_t pack_key_once = PTHREAD_ONCE_INIT;
+
+static void free_pack_buffers(void* block) {
+    free(block);
+}
+
+static void create_pack_key(void) {
+    pthread_key_create(&pack_key, free_pack_buffers);
+}
+
+static void ensure_pack_buffers(void) {
+    if (pack_a) return;
+    pthread_once(&pack_key_once, create_pack_key);
+    // GEMM_MC * GEMM_KC float là bội của GEMM_ALIGN nên pack_b vẫn được căn lề
+    float* block = (float*)aligned_alloc(GEMM_ALIGN, (GEMM_MC * GEMM_KC + GEMM_KC * GEMM_NC) * sizeof(float));
+    pthread_setspecific(pack_key, block);
+    pack_a = block;
+    pack_b = block + GEMM_MC * GEMM_KC;
+}
+
+// Nguồn dữ liệu của A: op(A) = A hoặc A^T (trans = 1: A lưu dạng [K, M])
+typedef struct {
+    const float* data;
+    int lda;
+    int trans;
+} ASource;
+
+// Pack block op(A)[ic : ic + mc, pc : pc + kc] thành các panel MR hàng: panel[p * MR + i] = op(A)[i][p]
+// Hàng thiếu ở panel cuối được điền 0 để micro-kernel luôn chạy đủ MR x NR
+static void pack_block_a(const ASource* src, int ic, int mc, int pc, int kc, float* dst) {
+    for (int i0 = 0; i0 < mc; i0 += GEMM_MR) {
+        int mr = (mc - i0 < GEMM_MR) ? mc - i0 : GEMM_MR;
+
+        if (!src->trans) {
+            const float* a = src->data + (size_t)(ic + i0) * src->lda + pc;
+            for (int p = 0; p < kc; p++) {
+                for (int i = 0; i < mr; i++) dst[i] = a[(size_t)i * src->lda + p];
+                for (int i = mr; i < GEMM_MR; i++) dst[i] = 0.0f;
+                dst += GEMM_MR;
+            }
+        } else {
+            // A^T: MR phần tử của một cột op(A) nằm liên tiếp trên một hàng của A
+            const float* a = src->data + (size_t)pc * src->lda + ic + i0;
+            for (int p = 0; p < kc; p++) {
+                for (int i = 0; i < mr; i++) dst[i] = a[i];
+                for (int i = mr; i < GEMM_MR; i++) dst[i] = 0.0f;
+                a += src->lda;
+                dst += GEMM_MR;
+            }
+        }
+    }
+}
+
+// Nguồn dữ liệu của B: ma trận dense (op(B) = B hoặc B^T) hoặc view có stride
+typedef struct {
+    const float* data;
+    int ldb;                    // Dùng khi strided == NULL
+    int trans;                  // 1: B lưu dạng [N, K]
+    const GemmStridedB* strided;
+} BSource;
+
+// Pack block op(B)[pc : pc + kc, jc : jc + nc] thành các panel NR cột: panel[p * NR + j] = op(B)[p][j]
+static void pack_block_b(const BSource* src, int pc, int kc, int jc, int nc, float* dst) {
+    for (int j0 = 0; j0 < nc; j0 += GEMM_NR) {
+        int nr = (nc - j0 < GEMM_NR) ? nc - j0 : GEMM_NR;
+
+        if (src->strided == NULL && src->trans) {
+            // B^T: mỗi cột op(B) là một hàng liên tiếp của B
+            const float* b = src->data + (size_t)(jc + j0) * src->ldb + pc;
+            for (int j = 0; j < nr; j++) {
+                const float* b_j = b + (size_t)j * src->ldb;
+                for (int p = 0; p < kc; p++) dst[p * GEMM_NR + j] = b_j[p];
+            }
+            for (int j = nr; j < GEMM_NR; j++) {
+                for (int p = 0; p < kc; p++) dst[p * GEMM_NR + j] = 0.0f;
+            }
+            dst += (size_t)kc * GEMM_NR;
+        } else if (src->strided == NULL) {
+            const float* b = src->data + (size_t)pc * src->ldb + jc + j0;
+            for (int p = 0; p < kc; p++) {
+                if (nr == GEMM_NR) {
+                    memcpy(dst, b, GEMM_NR * sizeof(float));
+                } else {
+                    for (int j = 0; j < nr; j++) dst[j] = b[j];
+                    for (int j = nr; j < GEMM_NR; j++) dst[j] = 0.0f;
+                }
+                b += src->ldb;
+                dst += GEMM_NR;
+            }
+        } else {
+            // Tính offset của từng cột trong panel một lần, dùng lại cho cả kc hàng
+            const GemmStridedB* v = src->strided;
+            size_t col_offset[GEMM_NR];
+            for (int j = 0; j < nr; j++) {
+                int col = jc + j0 + j;
+                col_offset[j] = (size_t)(col / v->n_cols) * v->row_stride + (size_t)(col % v->n_cols) * v->col_stride;
+            }
+            const float* b = v->data + (size_t)pc * v->k_stride;
+            for (int p = 0; p < kc; p++) {
+                for (int j = 0; j < nr; j++) dst[j] = b[col_offset[j]];
+                for (int j = nr; j < GEMM_NR; j++) dst[j] = 0.0f;
+                b += v->k_stride;
+                dst += GEMM_NR;
+            }
+        }
+    }
+}
+
+// ============================================================
+// 2. SGEMM (GOTO-STYLE LOOP NEST, CHIA KHỐI C CHO THREAD POOL)
+// ============================================================
+
+// Epilogue của tile bắt đầu tại hàng row, cột col của C
+static GemmEpilogue tile_epilogue(const GemmEpilogue* ep, int row, int col) {
+    GemmEpilogue t = *ep;
+    if (t.bias) t.bias += row;
+    if (t.scale) {
+        t.scale += row;
+        t.shift += row;
+    }
+    if (t.residual) t.residual += (size_t)row * ep->ldr + col;
+    return t;
+}
+
+// Tính khối C[m0 : m1, n0 : n1] (chỉ số tuyệt đối) với buffer pack của thread hiện tại
+static void sgemm_block(const KernelTable* k, int K, float alpha, const ASource* A, const BSource* B,
+                        float beta, float* C, int ldc, const GemmEpilogue* ep,
+                        int m0, int m1, int n0, int n1) {
+    ensure_pack_buffers();
+
+    for (int jc = n0; jc < n1; jc += GEMM_NC) {
+        int nc = (n1 - jc < GEMM_NC) ? n1 - jc : GEMM_NC;
+
+        for (int pc = 0; pc < K; pc += GEMM_KC) {
+            int kc = (K - pc < GEMM_KC) ? K - pc : GEMM_KC;
+            // Block K đầu tiên áp dụng beta, các block sau cộng dồn vào C; epilogue chỉ ở block cuối
+            float beta_block = (pc == 0) ? beta : 1.0f;
+            int last_block = (pc + kc >= K);
+
+            pack_block_b(B, pc, kc, jc, nc, pack_b);
+
+            for (int ic = m0; ic < m1; ic += GEMM_MC) {
+                int mc = (m1 - ic < GEMM_MC) ? m1 - ic : GEMM_MC;
+                pack_block_a(A, ic, mc, pc, kc, pack_a);
+
+                for (int jr = 0; jr < nc; jr += GEMM_NR) {
+                    int nr = (nc - jr < GEMM_NR) ? nc - jr : GEMM_NR;
+                    for (int ir = 0; ir < mc; ir += GEMM_MR) {
+                        int mr = (mc - ir < GEMM_MR) ? mc - ir : GEMM_MR;
+                        GemmEpilogue tile_ep;
+                        if (ep != NULL && last_block) tile_ep = tile_epilogue(ep, ic + ir, jc + jr);
+                        k->gemm_micro(kc, pack_a + (size_t)ir * kc, pack_b + (size_t)jr * kc,
+                                      C + (size_t)(ic + ir) * ldc + jc + jr, ldc,
+                                      mr, nr, alpha, beta_block,
+                                      (ep != NULL && last_block) ? &tile_ep : NULL);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Một lời gọi SGEMM chia thành lưới tm x tn khối C, mỗi khối là một việc của thread pool
+typedef struct {
+    const KernelTable* kt;
+    int M, N, K;
+    float alpha, beta;
+    const ASource* A;
+    const BSource* B;
+    float* C;
+    int ldc;
+    const GemmEpilogue* ep;
+    int tm, tn;
+    int m_step, n_step;     // Kích thước khối (bội của MR / NR)
+} SgemmTask;
+
+static void sgemm_task_run(void* arg, size_t begin, size_t end) {
+    const SgemmTask* t = (const SgemmTask*)arg;
+    for (size_t i = begin; i < end; i++) {
+        int m0 = (int)(i / t->tn) * t->m_step, n0 = (int)(i % t->tn) * t->n_step;
+        int m1 = (m0 + t->m_step < t->M) ? m0 + t->m_step : t->M;
+        int n1 = (n0 + t->n_step < t->N) ? n0 + t->n_step : t->N;
+        if (m0 < m1 && n0 < n1) {
+            sgemm_block(t->kt, t->K, t->alpha, t->A, t->B, t->beta, t->C, t->ldc, t->ep, m0, m1, n0, n1);
+        }
+    }
+}
+
+// Chia M thành tm phần, N thành tn phần (tm * tn <= threads). Mỗi khối tự pack phần A và B
+// của nó nên tổng lượng pack tỉ lệ với tn * M + tm * N: chọn cách chia nhỏ nhất,
+// không chia nhỏ hơn một tile micro-kernel.
+static void sgemm_grid(int M, int N, int threads, int* tm, int* tn) {
+    int max_m = (M + GEMM_MR - 1) / GEMM_MR, max_n = (N + GEMM_NR - 1) / GEMM_NR;
+    double best = -1.0;
+    *tm = *tn = 1;
+    for (int a = 1; a <= threads && a <= max_m; a++) {
+        int b = threads / a;
+        if (b > max_n) b = max_n;
+        double cost = (double)b * M + (double)a * N;
+        // Ưu tiên dùng nhiều thread nhất, sau đó là ít pack nhất
+        if (best < 0 || a * b > *tm * *tn || (a * b == *tm * *tn && cost < best)) {
+            best = cost;
+            *tm = a;
+            *tn = b;
+        }
+    }
+}
+
+static void sgemm_impl(const KernelTable* kt, int M, int N, int K,
+                       float alpha, const ASource* A,
+                       const BSource* B,
+                       float beta, float* C, int ldc,
+                       const GemmEpilogue* ep) {
+    if (M <= 0 || N <= 0) return;
+
+    // K == 0: C = beta * C
+    if (K <= 0) {
+        for (int i = 0; i < M; i++) {
+            float* c = C + (size_t)i * ldc;
+            for (int j = 0; j < N; j++) c[j] = (beta == 0.0f) ? 0.0f : beta * c[j];
+        }
+        return;
+    }
+
+    // GEMM nhỏ: chi phí đánh thức thread lớn hơn phần việc chia được
+    double flops = 2.0 * M * N * K;
+    int threads = (flops < GEMM_PARALLEL_MIN_FLOPS) ? 1 : thread_pool_size();
+    int tm = 1, tn = 1;
+    if (threads > 1) sgemm_grid(M, N, threads, &tm, &tn);
+    if (tm * tn <= 1) {
+        sgemm_block(kt, K, alpha, A, B, beta, C, ldc, ep, 0, M, 0, N);
+        return;
+    }
+
+    SgemmTask task = { kt, M, N, K, alpha, beta, A, B, C, ldc, ep, tm, tn, 0, 0 };
+    int m_tiles = (M + GEMM_MR - 1) / GEMM_MR, n_tiles = (N + GEMM_NR - 1) / GEMM_NR;
+    task.m_step = (m_tiles + tm - 1) / tm * GEMM_MR;
+    task.n_step = (n_tiles + tn - 1) / tn * GEMM_NR;
+    parallel_for((size_t)tm * tn, 1, sgemm_task_run, &task);
+}
+
+void sgemm(const KernelTable* kt, int M, int N, int K,
+           float alpha, const float* A, int lda,
+           const float* B, int ldb,
+           float beta, float* C, int ldc) {
+    sgemm_ex(kt, 0, 0, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+void sgemm_ex(const KernelTable* kt, int transA, int transB, int M, int N, int K,
+              float alpha, const float* A, int lda,
+              const float* B, int ldb,
+              float beta, float* C, int ldc) {
+    ASource a_src = { A, lda, transA };
+    BSource b_src = { B, ldb, transB, NULL };
+    sgemm_impl(kt, M, N, K, alpha, &a_src, &b_src, beta, C, ldc, NULL);
+}
+
+void sgemm_epilogue(const KernelTable* kt, int M, int N, int K,
+                    const float* A, int lda,
+                    const float* B, int ldb,
+                    float* C, int ldc,
+                    const GemmEpilogue* ep) {
+    ASource a_src = { A, lda, 0 };
+    BSource b_src = { B, ldb, 0, NULL };
+    sgemm_impl(kt, M, N, K, 1.0f, &a_src, &b_src, 0.0f, C, ldc, ep);
+}
+
+void sgemm_strided_b(const KernelTable* kt, int M, int N, int K,
+                     float alpha, const float* A, int lda,
+                     const GemmStridedB* B,
+                     float beta, float* C, int ldc,
+                     const GemmEpilogue* ep) {
+    ASource a_src = { A, lda, 0 };
+    BSource b_src = { NULL, 0, 0, B };
+    sgemm_impl(kt, M, N, K, alpha, &a_src, &b_src, beta, C, ldc, ep);
+}
+
+// ============================================================
+// 3. GEMV (BATCH 1, op(B) ĐÃ PACK SẴN)
+// ============================================================
+
+size_t sgemv_packed_size(int N, int K) {
+    size_t panels = (size_t)(N + GEMV_NR - 1) / GEMV_NR;
+    return panels * (size_t)K * GEMV_NR;
+}
+
+// panel jb: dst[(jb * K + p) * GEMV_NR + j] = op(B)[p][jb * GEMV_NR + j], cột thiếu điền 0
+void sgemv_pack_b(int transB, int N, int K, const float* B, int ldb, float* dst) {
+    for (int j0 = 0; j0 < N; j0 += GEMV_NR) {
+        int nr = (N - j0 < GEMV_NR) ? N - j0 : GEMV_NR;
+        for (int p = 0; p < K; p++) {
+            for (int j = 0; j < nr; j++) {
+                dst[j] = transB ? B[(size_t)(j0 + j) * ldb + p] : B[(size_t)p * ldb + j0 + j];
+            }
+            for (int j = nr; j < GEMV_NR; j++) dst[j] = 0.0f;
+            dst += GEMV_NR;
+        }
+    }
+}
+
+void sgemv_packed(const KernelTable* kt, int N, int K,
+                  float alpha, const float* x, const float* packed_b,
+                  float beta, float* y, int n_begin, int n_end) {
+    if (n_end > N) n_end = N;
+
+    float out[GEMV_NR];
+    for (int j0 = n_begin - n_begin % GEMV_NR; j0 < n_end; j0 += GEMV_NR) {
+        kt->gemv_panel(K, x, packed_b + (size_t)j0 * K, out);
+
+        // Chỉ ghi phần panel nằm trong [n_begin, n_end)
+        int lo = (j0 < n_begin) ? n_begin : j0;
+        int hi = (j0 + GEMV_NR < n_end) ? j0 + GEMV_NR : n_end;
+        for (int j = lo; j < hi; j++) {
+            float v = alpha * out[j - j0];
+            y[j] = (beta == 0.0f) ? v : v + beta * y[j];
+        }
+    }
+}
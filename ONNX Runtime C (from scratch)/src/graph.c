@@ -0,0 +1,330 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/tensor.h"
+#include "../include/exec_plan.h"
+#include "../include/op_registry.h"
+#include "../include/graph.h"
+
+// ============================================================
+// 1. CHỈ MỤC PRODUCER / CONSUMER
+// ============================================================
+
+void graph_index_build(GraphIndex* g, ExecPlan* plan) {
+    g->plan = plan;
+    g->producer = (int*)malloc((plan->n_slots + 1) * sizeof(int));
+    g->use_count = (int*)calloc(plan->n_slots + 1, sizeof(int));
+    g->removed = (int*)calloc(plan->n_nodes + 1, sizeof(int));
+    for (int s = 0; s < plan->n_slots; s++) g->producer[s] = -1;
+
+    for (int i = 0; i < plan->n_nodes; i++) {
+        const ExecNode* n = &plan->nodes[i];
+        for (int k = 0; k < n->n_inputs; k++) {
+            if (n->inputs[k] >= 0) g->use_count[n->inputs[k]]++;
+        }
+        for (int k = 0; k < n->n_outputs; k++) g->producer[n->outputs[k]] = i;
+    }
+}
+
+void graph_index_free(GraphIndex* g) {
+    free(g->producer);
+    free(g->use_count);
+    free(g->removed);
+    memset(g, 0, sizeof(GraphIndex));
+}
+
+int graph_consumer(const GraphIndex* g, int slot, int from) {
+    const ExecPlan* plan = g->plan;
+    for (int j = from + 1; j < plan->n_nodes; j++) {
+        if (g->removed[j]) continue;
+        const ExecNode* n = &plan->nodes[j];
+        for (int k = 0; k < n->n_inputs; k++) {
+            if (n->inputs[k] == slot) return j;
+        }
+    }
+    return -1;
+}
+
+int graph_sole_consumer(const GraphIndex* g, int slot, int from) {
+    if (slot < 0 || slot == g->plan->output_slot || g->use_count[slot] != 1) return -1;
+    return graph_consumer(g, slot, from);
+}
+
+void graph_remove_node(GraphIndex* g, int node) {
+    if (g->removed[node]) return;
+    const ExecNode* n = &g->plan->nodes[node];
+    for (int k = 0; k < n->n_inputs; k++) {
+        if (n->inputs[k] >= 0) g->use_count[n->inputs[k]]--;
+    }
+    g->removed[node] = 1;
+}
+
+void graph_set_node(GraphIndex* g, int pos, const ExecNode* node) {
+    graph_remove_node(g, pos);
+    g->plan->nodes[pos] = *node;
+    g->removed[pos] = 0;
+    for (int k = 0; k < node->n_inputs; k++) {
+        if (node->inputs[k] >= 0) g->use_count[node->inputs[k]]++;
+    }
+    for (int k = 0; k < node->n_outputs; k++) g->producer[node->outputs[k]] = pos;
+}
+
+void graph_replace_uses(GraphIndex* g, int old_slot, int new_slot) {
+    ExecPlan* plan = g->plan;
+    for (int i = 0; i < plan->n_nodes; i++) {
+        if (g->removed[i]) continue;
+        ExecNode* n = &plan->nodes[i];
+        for (int k = 0; k < n->n_inputs; k++) {
+            if (n->inputs[k] != old_slot) continue;
+            n->inputs[k] = new_slot;
+            g->use_count[old_slot]--;
+            g->use_count[new_slot]++;
+        }
+    }
+    if (plan->output_slot == old_slot) plan->output_slot = new_slot;
+}
+
+int graph_compact(GraphIndex* g) {
+    ExecPlan* plan = g->plan;
+    int n_nodes = 0;
+    for (int i = 0; i < plan->n_nodes; i++) {
+        if (!g->removed[i]) plan->nodes[n_nodes++] = plan->nodes[i];
+    }
+    int n_removed = plan->n_nodes - n_nodes;
+    plan->n_nodes = n_nodes;
+    return n_removed;
+}
+
+// ============================================================
+// 2. PATTERN MATCHING
+// ============================================================
+
+static int node_reads(const ExecNode* n, int slot, int any_input) {
+    if (!any_input) return n->n_inputs > 0 && n->inputs[0] == slot;
+    for (int k = 0; k < n->n_inputs; k++) {
+        if (n->inputs[k] == slot) return 1;
+    }
+    return 0;
+}
+
+int graph_match_chain(const GraphIndex* g, int start, const PatternStep* steps, int n_steps, int* matched) {
+    const ExecPlan* plan = g->plan;
+    for (int k = 0; k < n_steps; k++) matched[k] = -1;
+    if (plan->nodes[start].n_outputs < 1) return -1;
+
+    int cur = plan->nodes[start].outputs[0];
+    int pos = start;
+    int count = 0;
+    for (int k = 0; k < n_steps; k++) {
+        int j = graph_sole_consumer(g, cur, pos);
+        const ExecNode* n = (j >= 0) ? &plan->nodes[j] : NULL;
+        int ok = n != NULL && n->n_outputs >= 1 &&
+                 strcmp(n->kernel->op_type, steps[k].op_type) == 0 &&
+                 node_reads(n, cur, steps[k].any_input);
+        if (!ok) {
+            if (steps[k].optional) continue;
+            return -1;
+        }
+        matched[k] = j;
+        cur = n->outputs[0];
+        pos = j;
+        count++;
+    }
+    return count;
+}
+
+// ============================================================
+// 3. SHAPE KÝ HIỆU
+// ============================================================
+
+#define SHAPE_MAX_MAPS 16
+
+// H -> (H + a) / s + 1 (chia lấy phần nguyên, H + a >= 0 với mọi shape hợp lệ)
+typedef struct {
+    int a, s;
+} SpatialMap;
+
+// Một chiều không gian: hằng số (value > 0) hoặc chuỗi maps áp dụng lên chiều của input,
+// các map stride 1 liên tiếp được gộp thành offset cộng vào map kế tiếp (dạng chuẩn để so sánh)
+typedef struct {
+    int value;
+    int n_maps;
+    SpatialMap maps[SHAPE_MAX_MAPS];
+    int offset;
+} SymDim;
+
+typedef struct {
+    int known;
+    int channels;       // -1: bằng số channel của input graph
+    SymDim dims[2];     // H, W
+} SymShape;
+
+struct GraphShapes {
+    SymShape* slots;
+    int n_slots;
+};
+
+// Áp dụng phép trượt cửa sổ (kernel k, stride s, pad đầu + cuối, dilation d), 0 nếu vượt giới hạn
+static int sym_dim_window(SymDim* dim, int k, int s, int pads, int d) {
+    int a = pads - d * (k - 1) - 1;
+    if (s < 1) return 0;
+    if (dim->value > 0) {
+        if (dim->value + a < 0) return 0;
+        dim->value = (dim->value + a) / s + 1;
+        return 1;
+    }
+    if (s == 1) {
+        dim->offset += a + 1;
+        return 1;
+    }
+    if (dim->n_maps >= SHAPE_MAX_MAPS) return 0;
+    dim->maps[dim->n_maps].a = a + dim->offset;
+    dim->maps[dim->n_maps].s = s;
+    dim->n_maps++;
+    dim->offset = 0;
+    return 1;
+}
+
+static int sym_dim_equal(const SymDim* x, const SymDim* y) {
+    if (x->value != y->value) return 0;
+    if (x->value > 0) return 1;
+    if (x->n_maps != y->n_maps || x->offset != y->offset) return 0;
+    for (int i = 0; i < x->n_maps; i++) {
+        if (x->maps[i].a != y->maps[i].a || x->maps[i].s != y->maps[i].s) return 0;
+    }
+    return 1;
+}
+
+static int sym_shape_equal(const SymShape* x, const SymShape* y) {
+    return x->known && y->known && x->channels == y->channels &&
+           sym_dim_equal(&x->dims[0], &y->dims[0]) && sym_dim_equal(&x->dims[1], &y->dims[1]);
+}
+
+// Shape output 0 của node từ shape các input, known = 0 nếu không suy ra được
+static SymShape sym_node_output(const ExecPlan* plan, const SymShape* slots, const ExecNode* n) {
+    SymShape out;
+    memset(&out, 0, sizeof(out));
+    if (n->n_inputs < 1 || n->inputs[0] < 0) return out;
+    const SymShape* x = &slots[n->inputs[0]];
+    if (!x->known) return out;
+    const char* op = n->kernel->op_type;
+    const NodeAttrs* a = &n->attrs;
+
+    if (strcmp(op, "Conv") == 0) {
+        int w = (n->n_inputs > 1) ? n->inputs[1] : -1;
+        if (w < 0 || w >= plan->n_weights || plan->slots[w] == NULL || plan->slots[w]->rank != 4) return out;
+        const Tensor* W = plan->slots[w];
+        out = *x;
+        out.channels = W->n;
+        out.known = sym_dim_window(&out.dims[0], W->h, a->strides[0], a->pads[0] + a->pads[2], a->dilations[0]) &&
+                    sym_dim_window(&out.dims[1], W->w, a->strides[1], a->pads[1] + a->pads[3], a->dilations[1]);
+    } else if (strcmp(op, "MaxPool") == 0) {
+        out = *x;
+        out.known = sym_dim_window(&out.dims[0], a->kernel_shape[0], a->strides[0], a->pads[0] + a->pads[2], 1) &&
+                    sym_dim_window(&out.dims[1], a->kernel_shape[1], a->strides[1], a->pads[1] + a->pads[3], 1);
+    } else if (strcmp(op, "GlobalAveragePool") == 0) {
+        out = *x;
+        memset(out.dims, 0, sizeof(out.dims));
+        out.dims[0].value = out.dims[1].value = 1;
+    } else if (strcmp(op, "BatchNormalization") == 0 || strcmp(op, "Relu") == 0 ||
+               strcmp(op, "Identity") == 0 || strcmp(op, "Dropout") == 0) {
+        out = *x;
+    } else if (strcmp(op, "Add") == 0) {
+        // Chỉ khi hai toán hạng chắc chắn cùng shape (không broadcast)
+        if (n->n_inputs == 2 && n->inputs[1] >= 0 && sym_shape_equal(x, &slots[n->inputs[1]])) out = *x;
+    }
+    return out;
+}
+
+GraphShapes* graph_shapes_build(const ExecPlan* plan) {
+    GraphShapes* shapes = (GraphShapes*)malloc(sizeof(GraphShapes));
+    shapes->n_slots = plan->n_slots;
+    shapes->slots = (SymShape*)calloc(plan->n_slots + 1, sizeof(SymShape));
+
+    // Input của graph: mọi chiều là ký hiệu (chuỗi rỗng)
+    if (plan->input_slot >= 0 && plan->input_slot < plan->n_slots) {
+        SymShape* in = &shapes->slots[plan->input_slot];
+        in->known = 1;
+        in->channels = -1;
+    }
+    // Node theo thứ tự topo nên input luôn được suy ra trước output;
+    // output thứ hai trở đi (Dropout mask...) là không biết
+    for (int i = 0; i < plan->n_nodes; i++) {
+        const ExecNode* n = &plan->nodes[i];
+        if (n->n_outputs < 1 || n->outputs[0] < 0 || n->outputs[0] >= plan->n_slots) continue;
+        shapes->slots[n->outputs[0]] = sym_node_output(plan, shapes->slots, n);
+    }
+    return shapes;
+}
+
+void graph_shapes_free(GraphShapes* shapes) {
+    if (!shapes) return;
+    free(shapes->slots);
+    free(shapes);
+}
+
+int graph_shapes_equal(const GraphShapes* shapes, int slot_a, int slot_b) {
+    if (slot_a < 0 || slot_b < 0 || slot_a >= shapes->n_slots || slot_b >= shapes->n_slots) return 0;
+    return sym_shape_equal(&shapes->slots[slot_a], &shapes->slots[slot_b]);
+}
+
+// ============================================================
+// 4. VERIFIER
+// ============================================================
+
+#define VERIFY_FAIL(...) do { \
+        fprintf(stderr, "[Error] Graph invalid after %s: ", stage); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        free(defined); \
+        return -1; \
+    } while (0)
+
+int graph_verify(const ExecPlan* plan, const char* stage) {
+    // defined[s]: slot s đã có giá trị tại thời điểm node hiện tại chạy
+    int* defined = (int*)calloc(plan->n_slots + 1, sizeof(int));
+    for (int s = 0; s < plan->n_weights; s++) defined[s] = 1;
+    if (plan->input_slot >= 0 && plan->input_slot < plan->n_slots) defined[plan->input_slot] = 1;
+
+    for (int i = 0; i < plan->n_nodes; i++) {
+        const ExecNode* n = &plan->nodes[i];
+        const char* name = n->name ? n->name : "?";
+        if (n->kernel == NULL) VERIFY_FAIL("node %d (%s) has no kernel", i, name);
+        if (n->n_inputs < 0 || n->n_inputs > MAX_NODE_IO || n->n_outputs < 1 || n->n_outputs > MAX_NODE_IO) {
+            VERIFY_FAIL("node %s has %d inputs / %d outputs", name, n->n_inputs, n->n_outputs);
+        }
+
+        for (int k = 0; k < n->n_inputs; k++) {
+            int s = n->inputs[k];
+            if (s == -1) continue;
+            if (s < 0 || s >= plan->n_slots) VERIFY_FAIL("node %s input %d: bad slot %d", name, k, s);
+            if (!defined[s]) {
+                VERIFY_FAIL("node %s reads %s before it is produced", name, plan->slot_names[s]);
+            }
+        }
+        const FusedEpilogue* f = &n->fused;
+        if (f->bn_input < 0 || f->bn_input + 3 >= MAX_NODE_IO || f->residual_input < 0 ||
+            (f->bn_input && f->bn_input + 3 >= n->n_inputs) ||
+            (f->residual_input && f->residual_input >= n->n_inputs)) {
+            VERIFY_FAIL("node %s has fused inputs out of range", name);
+        }
+
+        for (int k = 0; k < n->n_outputs; k++) {
+            int s = n->outputs[k];
+            if (s < plan->n_weights || s >= plan->n_slots || s == plan->input_slot) {
+                VERIFY_FAIL("node %s output %d: bad slot %d", name, k, s);
+            }
+            if (defined[s]) VERIFY_FAIL("node %s writes %s, which already has a producer", name, plan->slot_names[s]);
+            defined[s] = 1;
+        }
+    }
+
+    if (plan->output_slot < 0 || plan->output_slot >= plan->n_slots || !defined[plan->output_slot]) {
+        VERIFY_FAIL("graph output is never produced");
+    }
+    free(defined);
+    return 0;
+}
+
+#undef VERIFY_FAIL
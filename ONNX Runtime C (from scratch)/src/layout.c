@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/tensor.h"
+#include "../include/exec_plan.h"
+#include "../include/op_registry.h"
+#include "../include/layout.h"
+#include "../include/graph.h"
+#include "../include/kernels.h"
+
+// File này KHÔNG được biên dịch với -mavx2: nó quyết định có dùng nchwc.c hay không
+
+int nchwc_cpu_supported(const KernelTable* kt) {
+    // Theo bảng kernel đã chọn cho session (có thể bị giới hạn thấp hơn CPU thật)
+    return kt->isa >= CPU_ISA_AVX2;
+}
+
+static TensorLayout slot_layout(const ExecPlan* plan, int slot) {
+    Tensor* t = plan->slots[slot];
+    return (t != NULL) ? t->layout : TENSOR_LAYOUT_NCHW; // Slot input chưa được gắn lúc compile
+}
+
+// Trả về slot chứa dữ liệu của `slot` ở layout `target`, chèn node reorder nếu chưa có.
+// converted[s]: slot đã chuyển layout của slot s (mỗi slot chỉ có một layout khác để chuyển sang)
+static int get_converted(ExecPlan* plan, int slot, TensorLayout target,
+                         int* converted, ExecNode* nodes, int* n_nodes) {
+    if (converted[slot] >= 0) return converted[slot];
+
+    int to_blocked = (target == TENSOR_LAYOUT_NCHWC);
+    char name[256];
+    snprintf(name, sizeof(name), "%s%s", plan->slot_names[slot], to_blocked ? "_nchwc" : "_nchw");
+
+    Tensor* t = (Tensor*)calloc(1, sizeof(Tensor));
+    t->name = strdup(name);
+    t->layout = target;
+    int out = exec_plan_add_slot(plan, name, t);
+
+    ExecNode* node = &nodes[(*n_nodes)++];
+    memset(node, 0, sizeof(ExecNode));
+    node->kernel = op_registry_reorder_kernel(to_blocked);
+    node->name = plan->slot_names[out];
+    node->inputs[0] = slot;
+    node->n_inputs = 1;
+    node->outputs[0] = out;
+    node->n_outputs = 1;
+
+    converted[slot] = out;
+    return out;
+}
+
+int layout_assign_nchwc(ExecPlan* plan) {
+    if (!nchwc_cpu_supported(plan->kernels)) return 0;
+
+    // Mỗi slot gốc được chuyển layout nhiều nhất một lần (+1 cho output của graph)
+    int n_orig_slots = plan->n_slots;
+    int* converted = (int*)malloc(n_orig_slots * sizeof(int));
+    for (int i = 0; i < n_orig_slots; i++) converted[i] = -1;
+    ExecNode* nodes = (ExecNode*)calloc(plan->n_nodes + n_orig_slots + 1, sizeof(ExecNode));
+    int n_nodes = 0, n_blocked = 0;
+    GraphShapes* shapes = graph_shapes_build(plan);
+
+    for (int i = 0; i < plan->n_nodes; i++) {
+        ExecNode node = plan->nodes[i];
+        const OpKernel* blocked = op_registry_find_nchwc(&node);
+        // Add blocked chỉ cộng hai tensor cùng shape: Add có thể broadcast ở lại layout NCHW
+        if (blocked && strcmp(node.kernel->op_type, "Add") == 0 &&
+            !graph_shapes_equal(shapes, node.inputs[0], node.inputs[1])) {
+            blocked = NULL;
+        }
+        TensorLayout want = blocked ? TENSOR_LAYOUT_NCHWC : TENSOR_LAYOUT_NCHW;
+
+        // Chỉ activations đổi layout, weights luôn ở dạng gốc (kernel tự pack lúc prepare)
+        for (int j = 0; j < node.n_inputs; j++) {
+            int s = node.inputs[j];
+            if (s < plan->n_weights || s >= n_orig_slots) continue;
+            if (slot_layout(plan, s) != want) {
+                node.inputs[j] = get_converted(plan, s, want, converted, nodes, &n_nodes);
+            }
+        }
+
+        if (blocked) {
+            node.kernel = blocked;
+            for (int j = 0; j < node.n_outputs; j++) plan->slots[node.outputs[j]]->layout = TENSOR_LAYOUT_NCHWC;
+            n_blocked++;
+        }
+        nodes[n_nodes++] = node;
+    }
+
+    // Output của graph luôn trả về cho caller ở layout NCHW
+    if (slot_layout(plan, plan->output_slot) != TENSOR_LAYOUT_NCHW) {
+        plan->output_slot = get_converted(plan, plan->output_slot, TENSOR_LAYOUT_NCHW, converted, nodes, &n_nodes);
+    }
+
+    if (n_blocked > 0) {
+        printf("[Layout] NCHW%dc: %d/%d nodes blocked, %d reorders inserted\n",
+               TENSOR_BLOCK_C, n_blocked, plan->n_nodes, n_nodes - plan->n_nodes);
+    }
+
+    graph_shapes_free(shapes);
+    free(plan->nodes);
+    plan->nodes = nodes;
+    plan->n_nodes = n_nodes;
+    free(converted);
+    return n_blocked;
+}
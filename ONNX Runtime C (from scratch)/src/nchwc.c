@@ -0,0 +1,407 @@
+#include <string.h>
+#include <float.h>
+#include <immintrin.h>
+
+#include "../include/nchwc.h"
+#include "../include/thread_pool.h"
+
+// File này được biên dịch với -mavx2 -mfma (xem Makefile)
+
+#define BLK TENSOR_BLOCK_C
+
+// ============================================================
+// 1. CHUYỂN LAYOUT
+// ============================================================
+
+// Tham số của các op một input, một output (chuyển layout, element-wise, pooling)
+typedef struct {
+    const Tensor* X;
+    const Tensor* B;        // Input thứ hai (Add), NULL nếu không có
+    Tensor* Y;
+    const float* scale;
+    const float* shift;
+    int kernel_h, kernel_w;
+    int stride_h, stride_w;
+    int pad_h, pad_w;
+} BlockedArgs;
+
+// Các block (batch, block channel) thứ [begin, end)
+static void reorder_to_blocked_range(void* arg, size_t begin, size_t end) {
+    const BlockedArgs* a = (const BlockedArgs*)arg;
+    const Tensor* X = a->X;
+    int blocks = nchwc_blocks(X->c);
+    size_t spatial = (size_t)X->h * X->w;
+
+    for (size_t bcb = begin; bcb < end; bcb++) {
+        int b = (int)(bcb / blocks), cb = (int)(bcb % blocks);
+        float* y = a->Y->data + bcb * spatial * BLK;
+        for (int ci = 0; ci < BLK; ci++) {
+            int c = cb * BLK + ci;
+            if (c >= X->c) {
+                for (size_t i = 0; i < spatial; i++) y[i * BLK + ci] = 0.0f;
+                continue;
+            }
+            const float* x = X->data + ((size_t)b * X->c + c) * spatial;
+            for (size_t i = 0; i < spatial; i++) y[i * BLK + ci] = x[i];
+        }
+    }
+}
+
+void nchwc_reorder_to_blocked(const Tensor* X, Tensor* Y) {
+    BlockedArgs args = { X, NULL, Y };
+    size_t spatial = (size_t)X->h * X->w;
+    parallel_for((size_t)X->n * nchwc_blocks(X->c), parallel_grain(spatial * BLK), reorder_to_blocked_range, &args);
+}
+
+// Các channel (batch, channel) thứ [begin, end) của output
+static void reorder_to_plain_range(void* arg, size_t begin, size_t end) {
+    const BlockedArgs* a = (const BlockedArgs*)arg;
+    const Tensor* X = a->X;
+    int blocks = nchwc_blocks(X->c);
+    size_t spatial = (size_t)X->h * X->w;
+
+    for (size_t bc = begin; bc < end; bc++) {
+        int b = (int)(bc / X->c), c = (int)(bc % X->c);
+        const float* x = X->data + ((size_t)b * blocks + c / BLK) * spatial * BLK + c % BLK;
+        float* y = a->Y->data + bc * spatial;
+        for (size_t i = 0; i < spatial; i++) y[i] = x[i * BLK];
+    }
+}
+
+void nchwc_reorder_to_plain(const Tensor* X, Tensor* Y) {
+    BlockedArgs args = { X, NULL, Y };
+    size_t spatial = (size_t)X->h * X->w;
+    parallel_for((size_t)X->n * X->c, parallel_grain(spatial), reorder_to_plain_range, &args);
+}
+
+// ============================================================
+// 2. CONVOLUTION TRỰC TIẾP
+// ============================================================
+
+void nchwc_conv_pack_weights(const Tensor* W, float* dst) {
+    int out_blocks = nchwc_blocks(W->n);
+    int in_blocks = nchwc_blocks(W->c);
+    int k_size = W->h * W->w;
+
+    for (int ocb = 0; ocb < out_blocks; ocb++) {
+        for (int icb = 0; icb < in_blocks; icb++) {
+            for (int k = 0; k < k_size; k++) {
+                for (int ici = 0; ici < BLK; ici++) {
+                    for (int oci = 0; oci < BLK; oci++) {
+                        int oc = ocb * BLK + oci, ic = icb * BLK + ici;
+                        *dst++ = (oc < W->n && ic < W->c)
+                                 ? W->data[((size_t)oc * W->c + ic) * k_size + k] : 0.0f;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Tham số chung của một lần gọi conv (tránh danh sách đối số dài cho các tile)
+typedef struct {
+    int in_blocks, in_h, in_w;
+    int kernel_h, kernel_w;
+    int stride_w, dilation_h, dilation_w;
+} ConvGeom;
+
+// Epilogue của một nhóm block output channel (con trỏ đã trỏ tới block đầu tiên của nhóm)
+typedef struct {
+    const float* scale;     // NULL: không có scale/shift
+    const float* shift;
+    int relu;
+} RowEpilogue;
+
+// Tính T điểm output liên tiếp trên một hàng cho OB block output channel (OB * 8 channel).
+// Mỗi (block, điểm) giữ một accumulator __m256; với mỗi input channel: nạp OB vector weight,
+// broadcast giá trị input của từng điểm rồi FMA -> OB * T FMA cho OB + T lần nạp.
+// check_w = 0: mọi tap theo chiều W đều nằm trong ảnh (vùng interior, không kiểm tra biên)
+// check_w = 1: chỉ dùng với T = 1 ở vùng border, bỏ qua tap nằm ngoài ảnh
+static inline __attribute__((always_inline))
+void conv_tile(const ConvGeom* g, const float* x_b, const float* w_ocb, size_t w_block,
+               const float* bias, float* y, size_t y_block,
+               int ih0, int iw0, int kh_lo, int kh_hi,
+               const int OB, const int T, const int check_w) {
+    __m256 acc[2][6];
+    for (int o = 0; o < OB; o++) {
+        for (int t = 0; t < T; t++) acc[o][t] = _mm256_loadu_ps(bias + o * BLK);
+    }
+
+    size_t x_plane = (size_t)g->in_h * g->in_w * BLK;
+    size_t w_plane = (size_t)g->kernel_h * g->kernel_w * BLK * BLK;
+    int x_step = g->stride_w * BLK;
+
+    for (int icb = 0; icb < g->in_blocks; icb++) {
+        const float* x_c = x_b + icb * x_plane;
+        const float* w_c = w_ocb + icb * w_plane;
+
+        for (int kh = kh_lo; kh < kh_hi; kh++) {
+            const float* x_row = x_c + ((size_t)(ih0 + kh * g->dilation_h) * g->in_w) * BLK;
+            const float* w_k = w_c + (size_t)kh * g->kernel_w * BLK * BLK;
+
+            for (int kw = 0; kw < g->kernel_w; kw++) {
+                int iw = iw0 + kw * g->dilation_w;
+                if (check_w && (iw < 0 || iw >= g->in_w)) continue;
+                const float* xp = x_row + (ptrdiff_t)iw * BLK;
+                const float* wp = w_k + kw * BLK * BLK;
+
+                for (int ic = 0; ic < BLK; ic++) {
+                    __m256 wv[2];
+                    for (int o = 0; o < OB; o++) wv[o] = _mm256_loadu_ps(wp + o * w_block + ic * BLK);
+                    for (int t = 0; t < T; t++) {
+                        __m256 xv = _mm256_broadcast_ss(xp + t * x_step + ic);
+                        for (int o = 0; o < OB; o++) acc[o][t] = _mm256_fmadd_ps(xv, wv[o], acc[o][t]);
+                    }
+                }
+            }
+        }
+    }
+
+    for (int o = 0; o < OB; o++) {
+        for (int t = 0; t < T; t++) _mm256_storeu_ps(y + o * y_block + t * BLK, acc[o][t]);
+    }
+}
+
+// Một hàng output cho OB block output channel: border (có kiểm tra) + interior theo tile 6/4/2/1
+static inline __attribute__((always_inline))
+void conv_row(const ConvGeom* g, const float* x_b, const float* w_ocb, size_t w_block,
+              const float* bias, float* y_row, size_t y_block,
+              int ih0, int kh_lo, int kh_hi, int out_w, int ow_lo, int ow_hi, int pad_w,
+              const int OB) {
+#define TILE(ow, T, CHECK) \
+    conv_tile(g, x_b, w_ocb, w_block, bias, y_row + (size_t)(ow) * BLK, y_block, \
+              ih0, (ow) * g->stride_w - pad_w, kh_lo, kh_hi, OB, T, CHECK)
+    int ow = 0;
+    for (; ow < ow_lo; ow++) TILE(ow, 1, 1);
+    for (; ow + 6 <= ow_hi; ow += 6) TILE(ow, 6, 0);
+    if (ow + 4 <= ow_hi) { TILE(ow, 4, 0); ow += 4; }
+    if (ow + 2 <= ow_hi) { TILE(ow, 2, 0); ow += 2; }
+    if (ow < ow_hi) { TILE(ow, 1, 0); ow++; }
+    for (; ow < out_w; ow++) TILE(ow, 1, 1);
+#undef TILE
+}
+
+// Epilogue cho hàng output vừa tính (OB block, còn nằm trong L1): scale/shift, residual r_row
+// (cùng layout với y_row), ReLU. Tách khỏi conv_tile để không tranh thanh ghi với accumulator.
+static void row_epilogue(const RowEpilogue* e, float* y_row, const float* r_row, size_t y_block,
+                         int out_w, int OB) {
+    const __m256 zero = _mm256_setzero_ps();
+    for (int o = 0; o < OB; o++) {
+        float* y = y_row + o * y_block;
+        const float* r = r_row ? r_row + o * y_block : NULL;
+        __m256 sc = e->scale ? _mm256_loadu_ps(e->scale + o * BLK) : zero;
+        __m256 sh = e->scale ? _mm256_loadu_ps(e->shift + o * BLK) : zero;
+        for (int ow = 0; ow < out_w; ow++) {
+            __m256 v = _mm256_loadu_ps(y + ow * BLK);
+            if (e->scale) v = _mm256_fmadd_ps(v, sc, sh);
+            if (r) v = _mm256_add_ps(v, _mm256_loadu_ps(r + ow * BLK));
+            if (e->relu) v = _mm256_max_ps(v, zero);
+            _mm256_storeu_ps(y + ow * BLK, v);
+        }
+    }
+}
+
+typedef struct {
+    ConvGeom g;
+    const Tensor* X;
+    const float* packed_w;
+    const float* bias;
+    Tensor* Y;
+    int kernel_h;
+    int stride_h, pad_h, pad_w;
+    int ow_lo, ow_hi;
+    const ConvEpilogue* ep;
+} NchwcConvArgs;
+
+// Đơn vị việc u = (cặp block output channel, ảnh b, hàng output oh), oh chạy nhanh nhất rồi tới b
+// nên một đoạn liên tiếp dùng lại cùng weights của một cặp block cho mọi ảnh trong batch
+// (weights chỉ được nạp vào cache một lần cho cả batch thay vì một lần cho mỗi ảnh)
+static void conv2d_range(void* arg, size_t begin, size_t end) {
+    const NchwcConvArgs* a = (const NchwcConvArgs*)arg;
+    const ConvGeom* g = &a->g;
+    const Tensor* X = a->X;
+    Tensor* Y = a->Y;
+    const ConvEpilogue* ep = a->ep;
+    int kernel_h = a->kernel_h;
+    int out_blocks = nchwc_blocks(Y->c);
+    size_t w_block = (size_t)g->in_blocks * kernel_h * g->kernel_w * BLK * BLK;
+    size_t y_block = (size_t)Y->h * Y->w * BLK;
+
+    for (size_t u = begin; u < end; u++) {
+        int oh = (int)(u % Y->h);
+        int b = (int)(u / Y->h % Y->n);
+        int pair = (int)(u / Y->h / Y->n);
+        int ocb = pair * 2;
+
+        // Mỗi lượt xử lý 2 block output channel (dùng chung các giá trị input đã broadcast)
+        const float* x_b = X->data + (size_t)b * g->in_blocks * X->h * X->w * BLK;
+        const float* w_ocb = a->packed_w + ocb * w_block;
+        size_t c_offset = ((size_t)b * out_blocks + ocb) * y_block;
+        const float* bias_b = a->bias + ocb * BLK;
+        RowEpilogue e = { NULL, NULL, ep ? ep->relu : 0 };
+        if (ep && ep->scale) {
+            e.scale = ep->scale + ocb * BLK;
+            e.shift = ep->shift + ocb * BLK;
+        }
+
+        // Các hàng kernel nằm ngoài ảnh được loại bỏ một lần cho cả hàng output
+        int ih0 = oh * a->stride_h - a->pad_h;
+        int kh_lo = 0, kh_hi = kernel_h;
+        while (kh_lo < kernel_h && ih0 + kh_lo * g->dilation_h < 0) kh_lo++;
+        while (kh_hi > kh_lo && ih0 + (kh_hi - 1) * g->dilation_h >= X->h) kh_hi--;
+
+        size_t row_offset = c_offset + (size_t)oh * Y->w * BLK;
+        float* y_row = Y->data + row_offset;
+        const float* r_row = (ep && ep->residual) ? ep->residual->data + row_offset : NULL;
+        int ob = (ocb + 2 <= out_blocks) ? 2 : 1;
+        if (ob == 2) {
+            conv_row(g, x_b, w_ocb, w_block, bias_b, y_row, y_block,
+                     ih0, kh_lo, kh_hi, Y->w, a->ow_lo, a->ow_hi, a->pad_w, 2);
+        } else {
+            conv_row(g, x_b, w_ocb, w_block, bias_b, y_row, y_block,
+                     ih0, kh_lo, kh_hi, Y->w, a->ow_lo, a->ow_hi, a->pad_w, 1);
+        }
+        if (ep != NULL) row_epilogue(&e, y_row, r_row, y_block, Y->w, ob);
+    }
+}
+
+void nchwc_conv2d(const Tensor* X, const float* packed_w, const float* bias, Tensor* Y,
+                  int kernel_h, int kernel_w,
+                  int stride_h, int stride_w,
+                  int pad_h, int pad_w,
+                  int dilation_h, int dilation_w,
+                  const ConvEpilogue* ep) {
+    ConvGeom g = { nchwc_blocks(X->c), X->h, X->w, kernel_h, kernel_w, stride_w, dilation_h, dilation_w };
+
+    // [ow_lo, ow_hi): mọi tap theo chiều W nằm trong ảnh -> interior
+    int ow_lo = (pad_w + stride_w - 1) / stride_w;
+    int last = X->w - 1 - (kernel_w - 1) * dilation_w + pad_w; // iw của tap cuối <= W - 1
+    int ow_hi = (last < 0) ? 0 : last / stride_w + 1;
+    if (ow_lo > Y->w) ow_lo = Y->w;
+    if (ow_hi > Y->w) ow_hi = Y->w;
+    if (ow_hi < ow_lo) ow_hi = ow_lo;
+
+    NchwcConvArgs args = { g, X, packed_w, bias, Y, kernel_h, stride_h, pad_h, pad_w, ow_lo, ow_hi, ep };
+    int n_pairs = (nchwc_blocks(Y->c) + 1) / 2;
+    size_t row_work = (size_t)Y->w * 2 * BLK * g.in_blocks * BLK * kernel_h * kernel_w;
+    parallel_for((size_t)n_pairs * X->n * Y->h, parallel_grain(row_work), conv2d_range, &args);
+}
+
+// ============================================================
+// 3. ELEMENT-WISE
+// ============================================================
+
+static void scale_shift_range(void* arg, size_t begin, size_t end) {
+    const BlockedArgs* a = (const BlockedArgs*)arg;
+    int blocks = nchwc_blocks(a->X->c);
+    size_t spatial = (size_t)a->X->h * a->X->w;
+
+    for (size_t bcb = begin; bcb < end; bcb++) {
+        int cb = (int)(bcb % blocks);
+        size_t offset = bcb * spatial * BLK;
+        const float* x = a->X->data + offset;
+        float* y = a->Y->data + offset;
+        __m256 s = _mm256_loadu_ps(a->scale + cb * BLK);
+        __m256 t = _mm256_loadu_ps(a->shift + cb * BLK);
+        for (size_t i = 0; i < spatial; i++) {
+            _mm256_storeu_ps(y + i * BLK, _mm256_fmadd_ps(_mm256_loadu_ps(x + i * BLK), s, t));
+        }
+    }
+}
+
+void nchwc_scale_shift(const Tensor* X, const float* scale, const float* shift, Tensor* Y) {
+    BlockedArgs args = { X, NULL, Y, scale, shift };
+    size_t spatial = (size_t)X->h * X->w;
+    parallel_for((size_t)X->n * nchwc_blocks(X->c), parallel_grain(spatial * BLK), scale_shift_range, &args);
+}
+
+// Storage NCHWc luôn là bội số của 8 nên không có phần dư; chia việc theo đơn vị 8 float
+static void relu_range(void* arg, size_t begin, size_t end) {
+    const BlockedArgs* a = (const BlockedArgs*)arg;
+    __m256 zero = _mm256_setzero_ps();
+    for (size_t i = begin * BLK; i < end * BLK; i += BLK) {
+        _mm256_storeu_ps(a->Y->data + i, _mm256_max_ps(_mm256_loadu_ps(a->X->data + i), zero));
+    }
+}
+
+void nchwc_relu(const Tensor* X, Tensor* Y) {
+    BlockedArgs args = { X, NULL, Y };
+    parallel_for(tensor_storage_size(X) / BLK, parallel_grain(BLK), relu_range, &args);
+}
+
+static void add_range(void* arg, size_t begin, size_t end) {
+    const BlockedArgs* a = (const BlockedArgs*)arg;
+    for (size_t i = begin * BLK; i < end * BLK; i += BLK) {
+        _mm256_storeu_ps(a->Y->data + i, _mm256_add_ps(_mm256_loadu_ps(a->X->data + i), _mm256_loadu_ps(a->B->data + i)));
+    }
+}
+
+void nchwc_add(const Tensor* A, const Tensor* B, Tensor* Y) {
+    BlockedArgs args = { A, B, Y };
+    parallel_for(tensor_storage_size(A) / BLK, parallel_grain(BLK), add_range, &args);
+}
+
+// ============================================================
+// 4. POOLING
+// ============================================================
+
+// Các block (batch, block channel) thứ [begin, end)
+static void maxpool_range(void* arg, size_t begin, size_t end) {
+    const BlockedArgs* a = (const BlockedArgs*)arg;
+    const Tensor* X = a->X;
+    Tensor* Y = a->Y;
+
+    for (size_t bcb = begin; bcb < end; bcb++) {
+        const float* x = X->data + bcb * X->h * X->w * BLK;
+        float* y = Y->data + bcb * Y->h * Y->w * BLK;
+
+        for (int oh = 0; oh < Y->h; oh++) {
+            int ih0 = oh * a->stride_h - a->pad_h;
+            int kh_lo = (ih0 < 0) ? -ih0 : 0;
+            int kh_hi = (ih0 + a->kernel_h > X->h) ? X->h - ih0 : a->kernel_h;
+
+            for (int ow = 0; ow < Y->w; ow++) {
+                int iw0 = ow * a->stride_w - a->pad_w;
+                int kw_lo = (iw0 < 0) ? -iw0 : 0;
+                int kw_hi = (iw0 + a->kernel_w > X->w) ? X->w - iw0 : a->kernel_w;
+
+                __m256 m = _mm256_set1_ps(-FLT_MAX);
+                for (int kh = kh_lo; kh < kh_hi; kh++) {
+                    const float* x_row = x + ((size_t)(ih0 + kh) * X->w + iw0) * BLK;
+                    for (int kw = kw_lo; kw < kw_hi; kw++) {
+                        m = _mm256_max_ps(m, _mm256_loadu_ps(x_row + kw * BLK));
+                    }
+                }
+                _mm256_storeu_ps(y + ((size_t)oh * Y->w + ow) * BLK, m);
+            }
+        }
+    }
+}
+
+void nchwc_maxpool(const Tensor* X, Tensor* Y,
+                   int kernel_h, int kernel_w,
+                   int stride_h, int stride_w,
+                   int pad_h, int pad_w) {
+    BlockedArgs args = { X, NULL, Y, NULL, NULL, kernel_h, kernel_w, stride_h, stride_w, pad_h, pad_w };
+    size_t work = (size_t)Y->h * Y->w * kernel_h * kernel_w * BLK;
+    parallel_for((size_t)X->n * nchwc_blocks(X->c), parallel_grain(work), maxpool_range, &args);
+}
+
+static void global_average_pool_range(void* arg, size_t begin, size_t end) {
+    const BlockedArgs* a = (const BlockedArgs*)arg;
+    size_t spatial = (size_t)a->X->h * a->X->w;
+    __m256 inv = _mm256_set1_ps(1.0f / (float)spatial);
+
+    for (size_t bcb = begin; bcb < end; bcb++) {
+        const float* x = a->X->data + bcb * spatial * BLK;
+        __m256 sum = _mm256_setzero_ps();
+        for (size_t i = 0; i < spatial; i++) sum = _mm256_add_ps(sum, _mm256_loadu_ps(x + i * BLK));
+        _mm256_storeu_ps(a->Y->data + bcb * BLK, _mm256_mul_ps(sum, inv));
+    }
+}
+
+void nchwc_global_average_pool(const Tensor* X, Tensor* Y) {
+    BlockedArgs args = { X, NULL, Y };
+    size_t spatial = (size_t)X->h * X->w;
+    parallel_for((size_t)X->n * nchwc_blocks(X->c), parallel_grain(spatial * BLK), global_average_pool_range, &args);
+}
@@ -36,8 +36,8 @@ char* pb_read_string(PbReader* r, size_t len) {
 // --- ONNX PARSING HELPERS ---
 
 // Field IDs trong ONNX Proto (Tra cứu từ documentation)
-#define ID_MODEL_GRAPH 1
-#define ID_GRAPH_NODE 11
+#define ID_MODEL_GRAPH 7
+#define ID_GRAPH_NODE 1
 #define ID_GRAPH_NAME 2
 #define ID_GRAPH_INIT 5
 #define ID_GRAPH_INPUT 11
@@ -50,16 +50,16 @@ char* pb_read_string(PbReader* r, size_t len) {
 #define ID_NODE_ATTR 5
 
 #define ID_ATTR_NAME 1
-#define ID_ATTR_FLOAT 4
-#define ID_ATTR_INT 2
-#define ID_ATTR_INTS 7
+#define ID_ATTR_FLOAT 2
+#define ID_ATTR_INT 3
+#define ID_ATTR_INTS 8
 #define ID_ATTR_TYPE 20
 
 #define ID_TENSOR_DIMS 1
 #define ID_TENSOR_TYPE 2
 #define ID_TENSOR_FLOAT_DATA 4
 #define ID_TENSOR_RAW_DATA 9
-#define ID_TENSOR_NAME 1
+#define ID_TENSOR_NAME 8
 
 // Helper: Skip một field nếu không cần thiết
 void pb_skip(PbReader* r, int wire_type) {
@@ -107,9 +107,11 @@ OnnxAttribute* parse_attribute(PbReader* r, size_t limit) {
                 attr->ints = malloc(sizeof(int64_t) * count);
                 attr->n_ints = count;
                 for(int i=0; i<count; i++) attr->ints[i] = pb_read_varint(r);
+            } else if (wire == 0) {
+                // Repeated không packed (proto2 mặc định): mỗi phần tử là một field riêng
+                attr->ints = realloc(attr->ints, sizeof(int64_t) * (attr->n_ints + 1));
+                attr->ints[attr->n_ints++] = (int64_t)pb_read_varint(r);
             } else {
-                // Repeated (wire=0), handled by parent loop usually, but attribute ints is defined as 'repeated int64'
-                // Mini parser simplification: only supports packed ints for now
                 pb_skip(r, wire); 
             }
         } else {
@@ -153,8 +155,31 @@ OnnxNode* parse_node(PbReader* r, size_t limit) {
     return node;
 }
 
+// Giải mã raw_data (little endian) theo data_type: float -> float_data,
+// số nguyên (shape của Reshape, axes...) -> int64_data.
+static void tensor_decode_raw(OnnxTensor* t, const uint8_t* raw, size_t len) {
+    if (t->data_type == ONNX_DTYPE_INT64 || t->data_type == ONNX_DTYPE_INT32) {
+        size_t elem = (t->data_type == ONNX_DTYPE_INT64) ? 8 : 4;
+        t->n_int64_data = (int)(len / elem);
+        t->int64_data = malloc(t->n_int64_data * sizeof(int64_t));
+        for (int i = 0; i < t->n_int64_data; i++) {
+            int64_t v64; int32_t v32;
+            if (elem == 8) { memcpy(&v64, raw + i * elem, 8); t->int64_data[i] = v64; }
+            else { memcpy(&v32, raw + i * elem, 4); t->int64_data[i] = v32; }
+        }
+    } else if (t->data_type == ONNX_DTYPE_FLOAT || t->data_type == 0) {
+        t->n_float_data = (int)(len / 4);
+        t->float_data = malloc(len);
+        memcpy(t->float_data, raw, len);
+    } else {
+        fprintf(stderr, "[Warning] Tensor %s: unsupported data_type %d\n", t->name ? t->name : "?", t->data_type);
+    }
+}
+
 OnnxTensor* parse_tensor(PbReader* r, size_t limit) {
     OnnxTensor* t = calloc(1, sizeof(OnnxTensor));
+    const uint8_t* raw = NULL;
+    size_t raw_len = 0;
     
     while (r->pos < limit) {
         uint64_t key = pb_read_varint(r);
@@ -173,16 +198,19 @@ OnnxTensor* parse_tensor(PbReader* r, size_t limit) {
                  // Logic packed dims... (simplified skipped)
                  pb_skip(r, wire);
             }
+        } else if (field == ID_TENSOR_TYPE) {
+            t->data_type = (int32_t)pb_read_varint(r);
         } else if (field == ID_TENSOR_RAW_DATA) {
             uint64_t len = pb_read_varint(r);
-            t->n_float_data = len / 4;
-            t->float_data = malloc(len);
-            memcpy(t->float_data, r->data + r->pos, len);
+            raw = r->data + r->pos;
+            raw_len = len;
             r->pos += len;
         } else {
              pb_skip(r, wire);
         }
     }
+    // data_type có thể nằm sau raw_data trong message nên chỉ giải mã khi đã đọc hết
+    if (raw) tensor_decode_raw(t, raw, raw_len);
     return t;
 }
 
@@ -1,4 +1,7 @@
 #include "../include/operators.h"
+#include "../include/gemm.h"
+#include "../include/kernels.h"
+#include "../include/thread_pool.h"
 #include <stdio.h>
 #include <math.h>
 #include <float.h>
@@ -7,19 +10,82 @@
 // Macro hỗ trợ tính index mảng 1 chiều từ 4 chiều (N, C, H, W)
 #define INDEX(n, c, h, w, C, H, W) ((((n) * (C) + (c)) * (H) + (h)) * (W) + (w))
 
+// Khoảng [lo, hi) của chỉ số kernel k sao cho start + k * dilation nằm trong [0, size).
+// Điểm output ở vùng interior có [0, kernel) nên vòng lặp kernel không cần kiểm tra biên;
+// chỉ các điểm ở border (chạm vùng pad) mới bị cắt bớt khoảng này.
+static void kernel_valid_range(int start, int size, int kernel, int dilation, int* lo, int* hi) {
+    int l = (start < 0) ? (-start + dilation - 1) / dilation : 0;
+    int h = (size - 1 - start < 0) ? 0 : (size - 1 - start) / dilation + 1;
+    if (h > kernel) h = kernel;
+    if (l > h) l = h;
+    *lo = l;
+    *hi = h;
+}
+
+// Epilogue có bước nào cần áp dụng không
+static int conv_has_epilogue(const ConvEpilogue* ep) {
+    return ep != NULL && (ep->scale != NULL || ep->residual != NULL || ep->relu);
+}
+
+// Epilogue cho một giá trị output của channel c, res: giá trị residual tương ứng
+static inline float conv_epilogue_value(const ConvEpilogue* ep, int c, float v, const float* res) {
+    if (ep->scale) v = v * ep->scale[c] + ep->shift[c];
+    if (res) v += *res;
+    if (ep->relu && v < 0.0f) v = 0.0f;
+    return v;
+}
+
+// Epilogue cho n giá trị liên tiếp của channel c (hàng vừa tính, còn nằm trong cache)
+static void conv_epilogue_row(const KernelTable* k, const ConvEpilogue* ep, int c,
+                              float* y, const float* res, size_t n) {
+    if (ep->scale) k->scale_shift(y, ep->scale[c], ep->shift[c], y, n);
+    if (res) k->add(y, res, y, n);
+    if (ep->relu) k->relu(y, y, n);
+}
+
+// Epilogue của GEMM cho các channel [c0, c0 + rows) của ảnh b, output ở dạng [rows, spatial]
+static GemmEpilogue conv_gemm_epilogue(const ConvEpilogue* ep, const Tensor* B, int b, int c0, int spatial) {
+    GemmEpilogue g = { 0 };
+    if (B != NULL) g.bias = B->data + c0;
+    if (ep != NULL) {
+        if (ep->scale) {
+            g.scale = ep->scale + c0;
+            g.shift = ep->shift + c0;
+        }
+        if (ep->residual) {
+            g.residual = ep->residual->data + ((size_t)b * ep->residual->c + c0) * spatial;
+            g.ldr = spatial;
+        }
+        g.relu = ep->relu;
+    }
+    return g;
+}
+
+// Tham số của một lần gọi Conv, dùng chung cho các đoạn chạy song song
+typedef struct {
+    Tensor* X;
+    Tensor* W;
+    Tensor* B;
+    Tensor* Y;
+    int stride_h, stride_w;
+    int pad_h, pad_w;
+    int dilation_h, dilation_w;
+    int group;
+    const ConvEpilogue* ep;
+} ConvArgs;
+
 // ============================================================
 // 1. Convolution 2D
 // ============================================================
-void op_conv2d(Tensor* X, Tensor* W, Tensor* B, Tensor* Y, 
-               int stride_h, int stride_w, 
-               int pad_h, int pad_w, 
-               int dilation_h, int dilation_w, 
-               int group) {
-    
-    // Reset toàn bộ bộ nhớ Output về 0 trước khi cộng dồn
-    memset(Y->data, 0, Y->n * Y->c * Y->h * Y->w * sizeof(float));
 
-    int batch_size = X->n;
+// Các cặp (batch, output channel) thứ [begin, end)
+static void conv2d_direct_range(void* arg, size_t begin, size_t end) {
+    const ConvArgs* a = (const ConvArgs*)arg;
+    Tensor* X = a->X;
+    Tensor* W = a->W;
+    Tensor* Y = a->Y;
+    const ConvEpilogue* ep = a->ep;
+
     int in_channels = X->c;
     int out_channels = Y->c; // Số lượng filters
     int out_h = Y->h;
@@ -27,236 +93,887 @@ void op_conv2d(Tensor* X, Tensor* W, Tensor* B, Tensor* Y,
     int kernel_h = W->h;
     int kernel_w = W->w;
 
-    // Loop 1: Batch
-    for (int b = 0; b < batch_size; b++) {
-        // Loop 2: Output Channels (Filters)
-        for (int oc = 0; oc < out_channels; oc++) {
-            
-            // Khởi tạo giá trị ban đầu bằng Bias (nếu có)
-            float bias_val = (B != NULL) ? B->data[oc] : 0.0f;
-
-            // Loop 3 & 4: Output Spatial (Height & Width)
-            for (int oh = 0; oh < out_h; oh++) {
-                for (int ow = 0; ow < out_w; ow++) {
-                    
-                    float sum = bias_val;
-
-                    // Loop 5: Input Channels
-                    // Lưu ý: Với Group Conv, in_channels duyệt sẽ khác, ở đây làm bản chuẩn group=1
-                    for (int ic = 0; ic < in_channels; ic++) {
-                        
-                        // Loop 6 & 7: Kernel Spatial
-                        for (int kh = 0; kh < kernel_h; kh++) {
-                            for (int kw = 0; kw < kernel_w; kw++) {
-                                
-                                // Tính vị trí tương ứng trên Input
-                                int ih = oh * stride_h - pad_h + kh * dilation_h;
-                                int iw = ow * stride_w - pad_w + kw * dilation_w;
-
-                                // Kiểm tra biên (Padding = 0)
-                                if (ih >= 0 && ih < X->h && iw >= 0 && iw < X->w) {
-                                    // Lấy input tại (b, ic, ih, iw)
-                                    int in_idx = INDEX(b, ic, ih, iw, X->c, X->h, X->w);
-                                    
-                                    // Lấy weight tại (oc, ic, kh, kw)
-                                    // Lưu ý: Shape weight là [OutC, InC, KH, KW]
-                                    int w_idx = INDEX(oc, ic, kh, kw, in_channels, kernel_h, kernel_w);
-                                    
-                                    sum += X->data[in_idx] * W->data[w_idx];
-                                }
-                            }
+    // Mỗi group: in_channels / group channel input -> out_channels / group filter
+    int group_in = in_channels / a->group;   // = W->c
+    int group_out = out_channels / a->group;
+
+    // Loop 1 & 2: Batch x Output Channels (Filters)
+    for (size_t bo = begin; bo < end; bo++) {
+        int b = (int)(bo / out_channels);
+        int oc = (int)(bo % out_channels);
+
+        // Khởi tạo giá trị ban đầu bằng Bias (nếu có)
+        float bias_val = (a->B != NULL) ? a->B->data[oc] : 0.0f;
+        int ic_start = (oc / group_out) * group_in; // Channel input đầu tiên của group chứa oc
+
+        // Loop 3 & 4: Output Spatial (Height & Width)
+        for (int oh = 0; oh < out_h; oh++) {
+            // Các hàng kernel nằm ngoài ảnh (vùng pad) bị loại bỏ một lần cho cả hàng
+            int ih0 = oh * a->stride_h - a->pad_h;
+            int kh_lo, kh_hi;
+            kernel_valid_range(ih0, X->h, kernel_h, a->dilation_h, &kh_lo, &kh_hi);
+
+            for (int ow = 0; ow < out_w; ow++) {
+                int iw0 = ow * a->stride_w - a->pad_w;
+                int kw_lo, kw_hi;
+                kernel_valid_range(iw0, X->w, kernel_w, a->dilation_w, &kw_lo, &kw_hi);
+
+                float sum = bias_val;
+
+                // Loop 5: Input Channels (chỉ các channel thuộc group của oc)
+                for (int icg = 0; icg < group_in; icg++) {
+                    int ic = ic_start + icg;
+
+                    // Loop 6 & 7: Kernel Spatial (chỉ các tap nằm trong ảnh, không kiểm tra biên)
+                    for (int kh = kh_lo; kh < kh_hi; kh++) {
+                        // Hàng input tại (b, ic, ih) và hàng weight tại (oc, icg, kh)
+                        // Lưu ý: Shape weight là [OutC, InC / group, KH, KW]
+                        const float* x_row = X->data + INDEX(b, ic, ih0 + kh * a->dilation_h, 0, X->c, X->h, X->w);
+                        const float* w_row = W->data + INDEX(oc, icg, kh, 0, group_in, kernel_h, kernel_w);
+
+                        for (int kw = kw_lo; kw < kw_hi; kw++) {
+                            sum += x_row[iw0 + kw * a->dilation_w] * w_row[kw];
                         }
                     }
-                    
-                    // Ghi kết quả ra output
-                    int out_idx = INDEX(b, oc, oh, ow, Y->c, Y->h, Y->w);
-                    Y->data[out_idx] = sum;
                 }
+
+                // Ghi kết quả ra output (qua epilogue nếu có)
+                int out_idx = INDEX(b, oc, oh, ow, Y->c, Y->h, Y->w);
+                if (ep != NULL) {
+                    const float* res = ep->residual ? ep->residual->data + out_idx : NULL;
+                    sum = conv_epilogue_value(ep, oc, sum, res);
+                }
+                Y->data[out_idx] = sum;
             }
         }
     }
 }
 
+void op_conv2d(Tensor* X, Tensor* W, Tensor* B, Tensor* Y, 
+               int stride_h, int stride_w, 
+               int pad_h, int pad_w, 
+               int dilation_h, int dilation_w, 
+               int group, const ConvEpilogue* ep) {
+    if (!conv_has_epilogue(ep)) ep = NULL;
+    ConvArgs args = { X, W, B, Y, stride_h, stride_w, pad_h, pad_w, dilation_h, dilation_w, group, ep };
+
+    // Mỗi (batch, output channel) là một đơn vị việc: H_out * W_out * C_in / group * kH * kW phép nhân
+    size_t work = (size_t)Y->h * Y->w * W->c * W->h * W->w;
+    parallel_for((size_t)X->n * Y->c, parallel_grain(work), conv2d_direct_range, &args);
+}
+
+// ============================================================
+// 1b. Convolution 2D qua im2col + SGEMM
+// ============================================================
+
+typedef struct {
+    const float* x;
+    int height, width;
+    int kernel_h, kernel_w;
+    int stride_h, stride_w;
+    int pad_h, pad_w;
+    int dilation_h, dilation_w;
+    int out_h, out_w;
+    float* col;
+} Im2colArgs;
+
+// Các channel [begin, end) của im2col (mỗi channel ghi kH * kW hàng riêng của col)
+static void im2col_range(void* arg, size_t begin, size_t end) {
+    const Im2colArgs* a = (const Im2colArgs*)arg;
+    const float* x = a->x;
+    int height = a->height, width = a->width;
+    int kernel_h = a->kernel_h, kernel_w = a->kernel_w;
+    int stride_h = a->stride_h, stride_w = a->stride_w;
+    int pad_h = a->pad_h, pad_w = a->pad_w;
+    int dilation_h = a->dilation_h, dilation_w = a->dilation_w;
+    int out_h = a->out_h, out_w = a->out_w;
+    float* col = a->col;
+
+    for (int c = (int)begin; c < (int)end; c++) {
+        const float* x_c = x + (size_t)c * height * width;
+
+        for (int kh = 0; kh < kernel_h; kh++) {
+            for (int kw = 0; kw < kernel_w; kw++) {
+                float* dst = col + ((size_t)(c * kernel_h + kh) * kernel_w + kw) * out_h * out_w;
+
+                // iw = ow * stride_w + off nằm trong [0, width) khi ow thuộc [ow_lo, ow_hi)
+                int off = kw * dilation_w - pad_w;
+                int ow_lo = (off >= 0) ? 0 : (-off + stride_w - 1) / stride_w;
+                int ow_hi = (width - off <= 0) ? 0 : (width - off + stride_w - 1) / stride_w;
+                if (ow_lo > out_w) ow_lo = out_w;
+                if (ow_hi > out_w) ow_hi = out_w;
+                if (ow_hi < ow_lo) ow_hi = ow_lo;
+
+                for (int oh = 0; oh < out_h; oh++) {
+                    float* row = dst + (size_t)oh * out_w;
+                    int ih = oh * stride_h - pad_h + kh * dilation_h;
+
+                    if (ih < 0 || ih >= height) {
+                        memset(row, 0, out_w * sizeof(float));
+                        continue;
+                    }
+
+                    const float* src = x_c + (size_t)ih * width + off;
+                    for (int ow = 0; ow < ow_lo; ow++) row[ow] = 0.0f;
+                    if (stride_w == 1) {
+                        memcpy(row + ow_lo, src + ow_lo, (ow_hi - ow_lo) * sizeof(float));
+                    } else {
+                        for (int ow = ow_lo; ow < ow_hi; ow++) row[ow] = src[ow * stride_w];
+                    }
+                    for (int ow = ow_hi; ow < out_w; ow++) row[ow] = 0.0f;
+                }
+            }
+        }
+    }
+}
+
+// Duỗi ảnh x [C, H, W] thành col [C * kH * kW, H_out * W_out], song song theo channel.
+// Khoảng ow hợp lệ được tính trước cho từng hàng kernel nên vòng copy không cần kiểm tra biên.
+static void im2col(const float* x, int channels, int height, int width,
+                   int kernel_h, int kernel_w,
+                   int stride_h, int stride_w,
+                   int pad_h, int pad_w,
+                   int dilation_h, int dilation_w,
+                   int out_h, int out_w, float* col) {
+    Im2colArgs args = { x, height, width, kernel_h, kernel_w, stride_h, stride_w,
+                        pad_h, pad_w, dilation_h, dilation_w, out_h, out_w, col };
+    size_t work = (size_t)kernel_h * kernel_w * out_h * out_w;
+    parallel_for((size_t)channels, parallel_grain(work), im2col_range, &args);
+}
+
+void op_conv2d_im2col(const KernelTable* kt, Tensor* X, Tensor* W, Tensor* B, Tensor* Y,
+                      int stride_h, int stride_w,
+                      int pad_h, int pad_w,
+                      int dilation_h, int dilation_w,
+                      int group, float* col, const ConvEpilogue* ep) {
+    int out_channels = Y->c;
+    int out_spatial = Y->h * Y->w;
+    int in_spatial = X->h * X->w;
+    int group_in = X->c / group;            // = W->c
+    int group_out = out_channels / group;
+    int k_dim = group_in * W->h * W->w;     // Chiều K của GEMM
+
+    for (int b = 0; b < X->n; b++) {
+        const float* x_b = X->data + (size_t)b * X->c * in_spatial;
+        float* y_b = Y->data + (size_t)b * out_channels * out_spatial;
+
+        // Mỗi group là một GEMM độc lập, dùng lại cùng một buffer col
+        for (int g = 0; g < group; g++) {
+            im2col(x_b + (size_t)g * group_in * in_spatial, group_in, X->h, X->w, W->h, W->w,
+                   stride_h, stride_w, pad_h, pad_w, dilation_h, dilation_w,
+                   Y->h, Y->w, col);
+
+            // Y_g[OC_g, H_out * W_out] = epilogue(W_g[OC_g, K] * col[K, H_out * W_out])
+            GemmEpilogue gep = conv_gemm_epilogue(ep, B, b, g * group_out, out_spatial);
+            sgemm_epilogue(kt, group_out, out_spatial, k_dim,
+                           W->data + (size_t)g * group_out * k_dim, k_dim,
+                           col, out_spatial,
+                           y_b + (size_t)g * group_out * out_spatial, out_spatial, &gep);
+        }
+    }
+}
+
+// ============================================================
+// 1c. Convolution 1x1 (Pointwise) = GEMM trực tiếp
+// ============================================================
+
+void op_conv2d_1x1(const KernelTable* kt, Tensor* X, Tensor* W, Tensor* B, Tensor* Y,
+                   int stride_h, int stride_w, const ConvEpilogue* ep) {
+    int in_channels = X->c;
+    int out_channels = Y->c;
+    int in_spatial = X->h * X->w;
+    int out_spatial = Y->h * Y->w;
+
+    for (int b = 0; b < X->n; b++) {
+        const float* x_b = X->data + (size_t)b * in_channels * in_spatial;
+        float* y_b = Y->data + (size_t)b * out_channels * out_spatial;
+        GemmEpilogue gep = conv_gemm_epilogue(ep, B, b, 0, out_spatial);
+
+        if (stride_h == 1 && stride_w == 1) {
+            // Y[OC, H * W] = epilogue(W[OC, C_in] * X[C_in, H * W])
+            sgemm_epilogue(kt, out_channels, out_spatial, in_channels,
+                           W->data, in_channels,
+                           x_b, in_spatial,
+                           y_b, out_spatial, &gep);
+        } else {
+            // Cột j của B là điểm ảnh (oh * stride_h, ow * stride_w) của X
+            GemmStridedB view = { x_b, in_spatial, Y->w, stride_h * X->w, stride_w };
+            sgemm_strided_b(kt, out_channels, out_spatial, in_channels,
+                            1.0f, W->data, in_channels,
+                            &view,
+                            0.0f, y_b, out_spatial, &gep);
+        }
+    }
+}
+
+// ============================================================
+// 1d. Convolution Winograd F(4x4, 3x3)
+// ============================================================
+// Y = A^T * [(G * g * G^T) .* (B^T * d * B)] * A  (Lavin & Gray, 2015)
+// Điểm nội suy 0, +-1, +-2, vô cực.
+
+// u = G * g (G: 6 x 3)
+static void winograd_filter_1d(const float* g, int gs, float* u, int us) {
+    float g0 = g[0], g1 = g[gs], g2 = g[2 * gs];
+    u[0]      = g0 / 4.0f;
+    u[us]     = -(g0 + g1 + g2) / 6.0f;
+    u[2 * us] = -(g0 - g1 + g2) / 6.0f;
+    u[3 * us] = g0 / 24.0f + g1 / 12.0f + g2 / 6.0f;
+    u[4 * us] = g0 / 24.0f - g1 / 12.0f + g2 / 6.0f;
+    u[5 * us] = g2;
+}
+
+// t = B^T * d (B^T: 6 x 6)
+static void winograd_input_1d(const float* d, int ds, float* t, int ts) {
+    float d0 = d[0], d1 = d[ds], d2 = d[2 * ds], d3 = d[3 * ds], d4 = d[4 * ds], d5 = d[5 * ds];
+    t[0]      = 4.0f * d0 - 5.0f * d2 + d4;
+    t[ts]     = -4.0f * (d1 + d2) + d3 + d4;
+    t[2 * ts] = 4.0f * (d1 - d2) - d3 + d4;
+    t[3 * ts] = 2.0f * (d3 - d1) - d2 + d4;
+    t[4 * ts] = 2.0f * (d1 - d3) - d2 + d4;
+    t[5 * ts] = 4.0f * d1 - 5.0f * d3 + d5;
+}
+
+// o = A^T * m (A^T: 4 x 6)
+static void winograd_output_1d(const float* m, int ms, float* o, int os) {
+    float m0 = m[0], m1 = m[ms], m2 = m[2 * ms], m3 = m[3 * ms], m4 = m[4 * ms], m5 = m[5 * ms];
+    float p12 = m1 + m2, n12 = m1 - m2;
+    float p34 = m3 + m4, n34 = m3 - m4;
+    o[0]      = m0 + p12 + p34;
+    o[os]     = n12 + 2.0f * n34;
+    o[2 * os] = p12 + 4.0f * p34;
+    o[3 * os] = n12 + 8.0f * n34 + m5;
+}
+
+void op_winograd_transform_filter(const Tensor* W, float* U) {
+    int out_channels = W->n;
+    int in_channels = W->c;
+    size_t plane = (size_t)out_channels * in_channels; // Khoảng cách giữa 2 vị trí xi trong U
+
+    for (int oc = 0; oc < out_channels; oc++) {
+        for (int ic = 0; ic < in_channels; ic++) {
+            const float* g = W->data + ((size_t)oc * in_channels + ic) * 9;
+            float tmp[WINOGRAD_ALPHA * 3];
+            float u[WINOGRAD_ALPHA * WINOGRAD_ALPHA];
+
+            // Theo cột rồi theo hàng: u = G * g * G^T
+            for (int j = 0; j < 3; j++) winograd_filter_1d(g + j, 3, tmp + j, 3);
+            for (int i = 0; i < WINOGRAD_ALPHA; i++) {
+                winograd_filter_1d(tmp + i * 3, 1, u + i * WINOGRAD_ALPHA, 1);
+            }
+
+            for (int xi = 0; xi < WINOGRAD_ALPHA * WINOGRAD_ALPHA; xi++) {
+                U[xi * plane + (size_t)oc * in_channels + ic] = u[xi];
+            }
+        }
+    }
+}
+
+static int winograd_tile_block(int out_h, int out_w) {
+    int tiles = ((out_h + WINOGRAD_TILE - 1) / WINOGRAD_TILE) * ((out_w + WINOGRAD_TILE - 1) / WINOGRAD_TILE);
+    return (tiles < WINOGRAD_TILE_BLOCK) ? tiles : WINOGRAD_TILE_BLOCK;
+}
+
+size_t op_conv2d_winograd_scratch(int in_channels, int out_channels, int out_h, int out_w) {
+    // V: [36, C_in, tb] và M: [36, C_out, tb]
+    size_t tb = (size_t)winograd_tile_block(out_h, out_w);
+    return (size_t)WINOGRAD_ALPHA * WINOGRAD_ALPHA * (in_channels + out_channels) * tb;
+}
+
+// Trạng thái của một block tile (ảnh b, các tile [t0, t0 + nt)) dùng chung cho 3 bước song song
+typedef struct {
+    const KernelTable* kt;
+    Tensor* X;
+    const float* U;
+    Tensor* B;
+    Tensor* Y;
+    int pad_h, pad_w;
+    const ConvEpilogue* ep;
+    float* V;               // [36, C_in, tb]
+    float* M;               // [36, C_out, tb]
+    int tb, tiles_w;
+    int b, t0, nt;
+} WinogradArgs;
+
+// Input transform cho các input channel [begin, end): V[xi][ic][t] = (B^T * d * B)[xi]
+static void winograd_input_range(void* arg, size_t begin, size_t end) {
+    const WinogradArgs* a = (const WinogradArgs*)arg;
+    const Tensor* X = a->X;
+    int tb = a->tb, nt = a->nt, t0 = a->t0;
+    const float* x_b = X->data + (size_t)a->b * X->c * X->h * X->w;
+    size_t v_plane = (size_t)X->c * tb;
+
+    for (int ic = (int)begin; ic < (int)end; ic++) {
+        const float* x_c = x_b + (size_t)ic * X->h * X->w;
+        for (int t = 0; t < nt; t++) {
+            int ty = (t0 + t) / a->tiles_w, tx = (t0 + t) % a->tiles_w;
+            int iy0 = ty * WINOGRAD_TILE - a->pad_h;
+            int ix0 = tx * WINOGRAD_TILE - a->pad_w;
+
+            float tmp[WINOGRAD_ALPHA * WINOGRAD_ALPHA];
+            if (iy0 >= 0 && iy0 + WINOGRAD_ALPHA <= X->h && ix0 >= 0 && ix0 + WINOGRAD_ALPHA <= X->w) {
+                // Tile nằm trọn trong ảnh: transform đọc thẳng từ x, không cần copy
+                const float* d = x_c + (size_t)iy0 * X->w + ix0;
+                for (int j = 0; j < WINOGRAD_ALPHA; j++) {
+                    winograd_input_1d(d + j, X->w, tmp + j, WINOGRAD_ALPHA);
+                }
+            } else {
+                // Tile chạm biên: gom vào d, phần nằm trong vùng pad bằng 0
+                float d[WINOGRAD_ALPHA * WINOGRAD_ALPHA];
+                for (int i = 0; i < WINOGRAD_ALPHA; i++) {
+                    int iy = iy0 + i;
+                    for (int j = 0; j < WINOGRAD_ALPHA; j++) {
+                        int ix = ix0 + j;
+                        d[i * WINOGRAD_ALPHA + j] = (iy >= 0 && iy < X->h && ix >= 0 && ix < X->w)
+                                                    ? x_c[iy * X->w + ix] : 0.0f;
+                    }
+                }
+                for (int j = 0; j < WINOGRAD_ALPHA; j++) {
+                    winograd_input_1d(d + j, WINOGRAD_ALPHA, tmp + j, WINOGRAD_ALPHA);
+                }
+            }
+            float* v = a->V + (size_t)ic * tb + t;
+            for (int i = 0; i < WINOGRAD_ALPHA; i++) {
+                winograd_input_1d(tmp + i * WINOGRAD_ALPHA, 1,
+                                  v + (size_t)i * WINOGRAD_ALPHA * v_plane, (int)v_plane);
+            }
+        }
+    }
+}
+
+// Các phép nhân ma trận xi thuộc [begin, end): M[xi] = U[xi] * V[xi]
+static void winograd_gemm_range(void* arg, size_t begin, size_t end) {
+    const WinogradArgs* a = (const WinogradArgs*)arg;
+    int in_channels = a->X->c, out_channels = a->Y->c, tb = a->tb;
+    for (size_t xi = begin; xi < end; xi++) {
+        sgemm(a->kt, out_channels, a->nt, in_channels,
+              1.0f, a->U + xi * out_channels * in_channels, in_channels,
+              a->V + xi * in_channels * tb, tb,
+              0.0f, a->M + xi * out_channels * tb, tb);
+    }
+}
+
+// Output transform cho các output channel [begin, end): Y = A^T * M * A (+ bias, epilogue),
+// cắt phần tile vượt biên
+static void winograd_output_range(void* arg, size_t begin, size_t end) {
+    const WinogradArgs* a = (const WinogradArgs*)arg;
+    Tensor* Y = a->Y;
+    const ConvEpilogue* ep = a->ep;
+    int out_channels = Y->c, tb = a->tb, nt = a->nt, t0 = a->t0;
+    size_t m_plane = (size_t)out_channels * tb;
+
+    for (int oc = (int)begin; oc < (int)end; oc++) {
+        size_t c_offset = ((size_t)a->b * out_channels + oc) * Y->h * Y->w;
+        float* y_c = Y->data + c_offset;
+        const float* r_c = (ep && ep->residual) ? ep->residual->data + c_offset : NULL;
+        float bias = (a->B != NULL) ? a->B->data[oc] : 0.0f;
+        for (int t = 0; t < nt; t++) {
+            int ty = (t0 + t) / a->tiles_w, tx = (t0 + t) % a->tiles_w;
+            const float* m = a->M + (size_t)oc * tb + t;
+
+            float tmp[WINOGRAD_TILE * WINOGRAD_ALPHA];
+            for (int j = 0; j < WINOGRAD_ALPHA; j++) {
+                winograd_output_1d(m + j * m_plane, (int)(WINOGRAD_ALPHA * m_plane),
+                                   tmp + j, WINOGRAD_ALPHA);
+            }
+
+            int oy0 = ty * WINOGRAD_TILE, ox0 = tx * WINOGRAD_TILE;
+            int rows = (Y->h - oy0 < WINOGRAD_TILE) ? Y->h - oy0 : WINOGRAD_TILE;
+            int cols = (Y->w - ox0 < WINOGRAD_TILE) ? Y->w - ox0 : WINOGRAD_TILE;
+            for (int i = 0; i < rows; i++) {
+                float o[WINOGRAD_TILE];
+                winograd_output_1d(tmp + i * WINOGRAD_ALPHA, 1, o, 1);
+                size_t row_offset = (size_t)(oy0 + i) * Y->w + ox0;
+                float* y_row = y_c + row_offset;
+                if (ep == NULL) {
+                    for (int j = 0; j < cols; j++) y_row[j] = o[j] + bias;
+                } else {
+                    const float* r_row = r_c ? r_c + row_offset : NULL;
+                    for (int j = 0; j < cols; j++) {
+                        y_row[j] = conv_epilogue_value(ep, oc, o[j] + bias, r_row ? r_row + j : NULL);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void op_conv2d_winograd(const KernelTable* kt, Tensor* X, const float* U, Tensor* B, Tensor* Y,
+                        int pad_h, int pad_w, float* scratch,
+                        const ConvEpilogue* ep) {
+    if (!conv_has_epilogue(ep)) ep = NULL;
+    const int n_xi = WINOGRAD_ALPHA * WINOGRAD_ALPHA;
+    int in_channels = X->c;
+    int out_channels = Y->c;
+    int tiles_h = (Y->h + WINOGRAD_TILE - 1) / WINOGRAD_TILE;
+    int tiles_w = (Y->w + WINOGRAD_TILE - 1) / WINOGRAD_TILE;
+    int n_tiles = tiles_h * tiles_w;
+    int tb = winograd_tile_block(Y->h, Y->w);
+
+    WinogradArgs args = { kt, X, U, B, Y, pad_h, pad_w, ep,
+                          scratch, scratch + (size_t)n_xi * in_channels * tb,
+                          tb, tiles_w, 0, 0, 0 };
+
+    for (int b = 0; b < X->n; b++) {
+        for (int t0 = 0; t0 < n_tiles; t0 += tb) {
+            args.b = b;
+            args.t0 = t0;
+            args.nt = (n_tiles - t0 < tb) ? n_tiles - t0 : tb;
+
+            // Mỗi bước chia theo chiều không có phụ thuộc: input channel, điểm xi, output channel
+            size_t transform_work = (size_t)args.nt * n_xi * WINOGRAD_ALPHA;
+            parallel_for((size_t)in_channels, parallel_grain(transform_work), winograd_input_range, &args);
+            parallel_for((size_t)n_xi, parallel_grain((size_t)out_channels * args.nt * in_channels),
+                         winograd_gemm_range, &args);
+            parallel_for((size_t)out_channels, parallel_grain(transform_work), winograd_output_range, &args);
+        }
+    }
+}
+
+// ============================================================
+// 1e. Depthwise Convolution (group = C_in = C_out)
+// ============================================================
+// Mỗi channel chỉ có một filter kH x kW nên không có phép nhân ma trận để tận dụng;
+// kernel bị giới hạn bởi băng thông bộ nhớ. Mỗi hàng output được cộng dồn bằng các
+// phép axpy trên cả hàng (kt->axpy, vector hóa theo ISA), thay vì
+// tính từng điểm output với vòng kernel bên trong.
+
+typedef struct {
+    ConvArgs conv;
+    const KernelTable* kt;
+    const int* ow_lo;       // [kW]: khoảng ow hợp lệ cho từng cột kernel
+    const int* ow_hi;
+} DepthwiseArgs;
+
+// Các cặp (batch, channel) thứ [begin, end)
+static void depthwise_range(void* arg, size_t begin, size_t end) {
+    const DepthwiseArgs* d = (const DepthwiseArgs*)arg;
+    const ConvArgs* a = &d->conv;
+    const Tensor* X = a->X;
+    Tensor* Y = a->Y;
+    const ConvEpilogue* ep = a->ep;
+    int channels = X->c;
+    int kernel_h = a->W->h;
+    int kernel_w = a->W->w;
+
+    const KernelTable* k = d->kt;
+    for (size_t bc = begin; bc < end; bc++) {
+        int c = (int)(bc % channels);
+        const float* x_c = X->data + bc * X->h * X->w;
+        size_t c_offset = bc * Y->h * Y->w;
+        float* y_c = Y->data + c_offset;
+        const float* r_c = (ep && ep->residual) ? ep->residual->data + c_offset : NULL;
+        const float* w_c = a->W->data + (size_t)c * kernel_h * kernel_w;
+        float bias = (a->B != NULL) ? a->B->data[c] : 0.0f;
+
+        for (int oh = 0; oh < Y->h; oh++) {
+            float* y_row = y_c + (size_t)oh * Y->w;
+            for (int ow = 0; ow < Y->w; ow++) y_row[ow] = bias;
+
+            for (int kh = 0; kh < kernel_h; kh++) {
+                int ih = oh * a->stride_h - a->pad_h + kh * a->dilation_h;
+                if (ih < 0 || ih >= X->h) continue;
+                const float* x_row = x_c + (size_t)ih * X->w;
+
+                for (int kw = 0; kw < kernel_w; kw++) {
+                    int lo = d->ow_lo[kw], n = d->ow_hi[kw] - lo;
+                    if (n <= 0) continue;
+                    float wv = w_c[kh * kernel_w + kw];
+                    const float* src = x_row + lo * a->stride_w + kw * a->dilation_w - a->pad_w;
+                    if (a->stride_w == 1) {
+                        k->axpy(y_row + lo, src, wv, n);
+                    } else {
+                        k->axpy_strided(y_row + lo, src, wv, n, a->stride_w);
+                    }
+                }
+            }
+
+            // Hàng output vừa tính xong còn trong L1: áp dụng epilogue ngay
+            if (ep != NULL) {
+                conv_epilogue_row(k, ep, c, y_row, r_c ? r_c + (size_t)oh * Y->w : NULL, Y->w);
+            }
+        }
+    }
+}
+
+void op_conv2d_depthwise(const KernelTable* kt, Tensor* X, Tensor* W, Tensor* B, Tensor* Y,
+                         int stride_h, int stride_w,
+                         int pad_h, int pad_w,
+                         int dilation_h, int dilation_w,
+                         const ConvEpilogue* ep) {
+    if (!conv_has_epilogue(ep)) ep = NULL;
+    int kernel_w = W->w;
+
+    // Khoảng ow hợp lệ cho từng cột kernel (giống im2col), tính một lần cho mọi channel
+    int ow_lo[kernel_w], ow_hi[kernel_w];
+    for (int kw = 0; kw < kernel_w; kw++) {
+        int off = kw * dilation_w - pad_w;
+        int lo = (off >= 0) ? 0 : (-off + stride_w - 1) / stride_w;
+        int hi = (X->w - off <= 0) ? 0 : (X->w - off + stride_w - 1) / stride_w;
+        if (lo > Y->w) lo = Y->w;
+        if (hi > Y->w) hi = Y->w;
+        if (hi < lo) hi = lo;
+        ow_lo[kw] = lo;
+        ow_hi[kw] = hi;
+    }
+
+    DepthwiseArgs args = { { X, W, B, Y, stride_h, stride_w, pad_h, pad_w, dilation_h, dilation_w, X->c, ep },
+                           kt, ow_lo, ow_hi };
+    size_t work = (size_t)Y->h * Y->w * W->h * W->w;
+    parallel_for((size_t)X->n * X->c, parallel_grain(work), depthwise_range, &args);
+}
+
 // ============================================================
 // 2. Batch Normalization
 // Công thức: y = (x - mean) / sqrt(var + eps) * scale + B
 // ============================================================
-void op_batch_normalization(Tensor* X, Tensor* scale, Tensor* B, 
-                            Tensor* mean, Tensor* var, Tensor* Y, 
-                            float epsilon) {
-    
-    int batch_size = X->n;
-    int channels = X->c;
-    int height = X->h;
-    int width = X->w;
-    int spatial_size = height * width;
+typedef struct {
+    const KernelTable* kt;
+    Tensor* X;
+    Tensor* scale;
+    Tensor* B;
+    Tensor* mean;
+    Tensor* var;
+    Tensor* Y;
+    float epsilon;
+} BatchNormArgs;
 
-    for (int c = 0; c < channels; c++) {
+// Các plane (batch, channel) thứ [begin, end)
+static void batchnorm_range(void* arg, size_t begin, size_t end) {
+    const BatchNormArgs* a = (const BatchNormArgs*)arg;
+    int channels = a->X->c;
+    size_t spatial_size = (size_t)a->X->h * a->X->w;
+
+    for (size_t bc = begin; bc < end; bc++) {
+        int c = (int)(bc % channels);
         // Tối ưu: Tính toán trước các hệ số không đổi cho cả channel
         // factor = scale / sqrt(var + eps)
-        float inv_std = 1.0f / sqrtf(var->data[c] + epsilon);
-        float factor = scale->data[c] * inv_std;
-        
+        float inv_std = 1.0f / sqrtf(a->var->data[c] + a->epsilon);
+        float factor = a->scale->data[c] * inv_std;
+
         // offset = B - mean * factor
-        float offset = B->data[c] - mean->data[c] * factor;
-
-        // Áp dụng cho tất cả pixel thuộc channel này (trên mọi batch)
-        for (int b = 0; b < batch_size; b++) {
-            for (int hw = 0; hw < spatial_size; hw++) {
-                // Index input/output được tính phẳng để nhanh hơn
-                int idx = (b * channels + c) * spatial_size + hw;
-                
-                Y->data[idx] = X->data[idx] * factor + offset;
-            }
-        }
+        float offset = a->B->data[c] - a->mean->data[c] * factor;
+
+        // Index input/output được tính phẳng để nhanh hơn
+        size_t idx = bc * spatial_size;
+        a->kt->scale_shift(a->X->data + idx, factor, offset, a->Y->data + idx, spatial_size);
     }
 }
 
+void op_batch_normalization(const KernelTable* kt, Tensor* X, Tensor* scale, Tensor* B, 
+                            Tensor* mean, Tensor* var, Tensor* Y, 
+                            float epsilon) {
+    BatchNormArgs args = { kt, X, scale, B, mean, var, Y, epsilon };
+    size_t spatial_size = (size_t)X->h * X->w;
+    parallel_for((size_t)X->n * X->c, parallel_grain(spatial_size), batchnorm_range, &args);
+}
+
+// Tham số của op element-wise: y = f(a, b) trên các phần tử [begin, end)
+typedef struct {
+    const KernelTable* kt;
+    const float* a;
+    const float* b;
+    float* y;
+} EltwiseArgs;
+
 // ============================================================
 // 3. ReLU
 // ============================================================
-void op_relu(Tensor* X, Tensor* Y) {
+static void relu_range(void* arg, size_t begin, size_t end) {
+    const EltwiseArgs* e = (const EltwiseArgs*)arg;
+    e->kt->relu(e->a + begin, e->y + begin, end - begin);
+}
+
+void op_relu(const KernelTable* kt, Tensor* X, Tensor* Y) {
     // Vì ReLU là element-wise, ta coi Tensor như mảng 1 chiều khổng lồ
-    int total_elements = X->n * X->c * X->h * X->w;
-    for (int i = 0; i < total_elements; i++) {
-        Y->data[i] = (X->data[i] > 0.0f) ? X->data[i] : 0.0f;
-    }
+    size_t total_elements = (size_t)X->n * X->c * X->h * X->w;
+    EltwiseArgs args = { kt, X->data, NULL, Y->data };
+    parallel_for(total_elements, parallel_grain(1), relu_range, &args);
 }
 
 // ============================================================
 // 4. Element-wise Add (Residual Connection)
 // ============================================================
-void op_add(Tensor* A, Tensor* B, Tensor* Y) {
+static void add_range(void* arg, size_t begin, size_t end) {
+    const EltwiseArgs* e = (const EltwiseArgs*)arg;
+    e->kt->add(e->a + begin, e->b + begin, e->y + begin, end - begin);
+}
+
+void op_add(const KernelTable* kt, Tensor* A, Tensor* B, Tensor* Y) {
     // A và B phải cùng kích thước
-    int total_elements = Y->n * Y->c * Y->h * Y->w;
-    for (int i = 0; i < total_elements; i++) {
-        Y->data[i] = A->data[i] + B->data[i];
+    size_t total_elements = (size_t)Y->n * Y->c * Y->h * Y->w;
+    EltwiseArgs args = { kt, A->data, B->data, Y->data };
+    parallel_for(total_elements, parallel_grain(1), add_range, &args);
+}
+
+typedef struct {
+    const Tensor* A;
+    const Tensor* B;
+    Tensor* Y;
+    size_t sa[TENSOR_MAX_RANK];
+    size_t sb[TENSOR_MAX_RANK];
+} BroadcastArgs;
+
+// Các hàng (chiều trong cùng) thứ [begin, end) của Y
+static void add_broadcast_range(void* arg, size_t begin, size_t end) {
+    const BroadcastArgs* a = (const BroadcastArgs*)arg;
+    const Tensor* Y = a->Y;
+    const size_t* sa = a->sa;
+    const size_t* sb = a->sb;
+    int rank = Y->rank;
+
+    // Chiều trong cùng chạy liên tục, các chiều ngoài đếm như bộ đếm nhiều chữ số
+    int inner = (rank > 0) ? Y->dims[rank - 1] : 1;
+    size_t ia = (rank > 0) ? sa[rank - 1] : 0, ib = (rank > 0) ? sb[rank - 1] : 0;
+
+    // Khởi tạo bộ đếm tại hàng begin
+    int idx[TENSOR_MAX_RANK] = { 0 };
+    size_t off_a = 0, off_b = 0, rest = begin;
+    for (int d = rank - 2; d >= 0; d--) {
+        idx[d] = (int)(rest % Y->dims[d]);
+        rest /= Y->dims[d];
+        off_a += idx[d] * sa[d];
+        off_b += idx[d] * sb[d];
+    }
+    float* y = Y->data + begin * inner;
+
+    for (size_t o = begin; o < end; o++) {
+        const float* pa = a->A->data + off_a;
+        const float* pb = a->B->data + off_b;
+        for (int j = 0; j < inner; j++) y[j] = pa[j * ia] + pb[j * ib];
+        y += inner;
+
+        for (int d = rank - 2; d >= 0; d--) {
+            off_a += sa[d];
+            off_b += sb[d];
+            if (++idx[d] < Y->dims[d]) break;
+            off_a -= sa[d] * Y->dims[d];
+            off_b -= sb[d] * Y->dims[d];
+            idx[d] = 0;
+        }
     }
 }
 
+void op_add_broadcast(Tensor* A, Tensor* B, Tensor* Y) {
+    BroadcastArgs args;
+    args.A = A;
+    args.B = B;
+    args.Y = Y;
+    tensor_broadcast_strides(A, Y->rank, Y->dims, args.sa);
+    tensor_broadcast_strides(B, Y->rank, Y->dims, args.sb);
+
+    int inner = (Y->rank > 0) ? Y->dims[Y->rank - 1] : 1;
+    size_t n_outer = (inner > 0) ? tensor_numel(Y) / inner : 0;
+    parallel_for(n_outer, parallel_grain((size_t)inner), add_broadcast_range, &args);
+}
+
+// Tham số chung của Pooling
+typedef struct {
+    Tensor* X;
+    Tensor* Y;
+    int kernel_h, kernel_w;
+    int stride_h, stride_w;
+    int pad_h, pad_w;
+    const KernelTable* kt;  // Chỉ Global Average Pool dùng (MaxPool để NULL)
+} PoolArgs;
+
 // ============================================================
 // 5. Max Pooling
 // ============================================================
-void op_maxpool(Tensor* X, Tensor* Y, 
-                int kernel_h, int kernel_w,
-                int stride_h, int stride_w,
-                int pad_h, int pad_w) {
-    
-    int batch = Y->n;
-    int channels = Y->c; // Pooling hoạt động độc lập trên từng kênh
+
+// Pooling hoạt động độc lập trên từng kênh: các plane (batch, channel) thứ [begin, end)
+static void maxpool_range(void* arg, size_t begin, size_t end) {
+    const PoolArgs* a = (const PoolArgs*)arg;
+    const Tensor* X = a->X;
+    Tensor* Y = a->Y;
     int out_h = Y->h;
     int out_w = Y->w;
 
-    for (int b = 0; b < batch; b++) {
-        for (int c = 0; c < channels; c++) {
-            for (int oh = 0; oh < out_h; oh++) {
-                for (int ow = 0; ow < out_w; ow++) {
-                    
-                    float max_val = -FLT_MAX; // Khởi tạo giá trị rất nhỏ
-                    
-                    // Quét qua kernel window
-                    for (int kh = 0; kh < kernel_h; kh++) {
-                        for (int kw = 0; kw < kernel_w; kw++) {
-                            int ih = oh * stride_h - pad_h + kh;
-                            int iw = ow * stride_w - pad_w + kw;
-
-                            // Nếu nằm trong biên ảnh thì mới xét Max
-                            if (ih >= 0 && ih < X->h && iw >= 0 && iw < X->w) {
-                                int in_idx = INDEX(b, c, ih, iw, X->c, X->h, X->w);
-                                if (X->data[in_idx] > max_val) {
-                                    max_val = X->data[in_idx];
-                                }
-                            }
+    for (size_t bc = begin; bc < end; bc++) {
+        const float* x_c = X->data + bc * X->h * X->w;
+        float* y_c = Y->data + bc * out_h * out_w;
+
+        for (int oh = 0; oh < out_h; oh++) {
+            int ih0 = oh * a->stride_h - a->pad_h;
+            int kh_lo, kh_hi;
+            kernel_valid_range(ih0, X->h, a->kernel_h, 1, &kh_lo, &kh_hi);
+
+            for (int ow = 0; ow < out_w; ow++) {
+                int iw0 = ow * a->stride_w - a->pad_w;
+                int kw_lo, kw_hi;
+                kernel_valid_range(iw0, X->w, a->kernel_w, 1, &kw_lo, &kw_hi);
+
+                float max_val = -FLT_MAX; // Khởi tạo giá trị rất nhỏ
+
+                // Quét qua phần kernel window nằm trong ảnh (vùng pad không tham gia Max)
+                for (int kh = kh_lo; kh < kh_hi; kh++) {
+                    const float* x_row = x_c + (ih0 + kh) * X->w;
+                    for (int kw = kw_lo; kw < kw_hi; kw++) {
+                        if (x_row[iw0 + kw] > max_val) {
+                            max_val = x_row[iw0 + kw];
                         }
                     }
-                    
-                    int out_idx = INDEX(b, c, oh, ow, Y->c, Y->h, Y->w);
-                    Y->data[out_idx] = max_val;
                 }
+
+                y_c[oh * out_w + ow] = max_val;
             }
         }
     }
 }
 
+void op_maxpool(Tensor* X, Tensor* Y, 
+                int kernel_h, int kernel_w,
+                int stride_h, int stride_w,
+                int pad_h, int pad_w) {
+    PoolArgs args = { X, Y, kernel_h, kernel_w, stride_h, stride_w, pad_h, pad_w, NULL };
+    size_t work = (size_t)Y->h * Y->w * kernel_h * kernel_w;
+    parallel_for((size_t)Y->n * Y->c, parallel_grain(work), maxpool_range, &args);
+}
+
 // ============================================================
 // 6. Global Average Pooling
 // ============================================================
-void op_global_average_pool(Tensor* X, Tensor* Y) {
-    // Input: [N, C, H, W] -> Output: [N, C, 1, 1]
-    int spatial_size = X->h * X->w;
-    
-    for (int b = 0; b < X->n; b++) {
-        for (int c = 0; c < X->c; c++) {
-            float sum = 0.0f;
-            for (int i = 0; i < spatial_size; i++) {
-                // Tính tổng các điểm ảnh trong 1 channel
-                int in_idx = (b * X->c + c) * spatial_size + i;
-                sum += X->data[in_idx];
-            }
-            
-            // Ghi vào output (1x1)
-            int out_idx = b * Y->c + c; // Vì h=1, w=1
-            Y->data[out_idx] = sum / spatial_size;
-        }
+static void global_avgpool_range(void* arg, size_t begin, size_t end) {
+    const PoolArgs* a = (const PoolArgs*)arg;
+    size_t spatial_size = (size_t)a->X->h * a->X->w;
+
+    for (size_t bc = begin; bc < end; bc++) {
+        // Tính tổng các điểm ảnh trong 1 channel, ghi vào output (1x1)
+        float sum = a->kt->sum(a->X->data + bc * spatial_size, spatial_size);
+        a->Y->data[bc] = sum / spatial_size;
     }
 }
 
-// ============================================================
-// 7. Flatten
-// ============================================================
-void op_flatten(Tensor* X, Tensor* Y) {
-    // Copy dữ liệu từ X sang Y
-    // Trong thực tế nếu quản lý memory tốt, ta chỉ cần trỏ data của Y vào data của X
-    // Nhưng ở đây ta copy an toàn
-    size_t size = X->n * X->c * X->h * X->w * sizeof(float);
-    memcpy(Y->data, X->data, size);
+void op_global_average_pool(const KernelTable* kt, Tensor* X, Tensor* Y) {
+    // Input: [N, C, H, W] -> Output: [N, C, 1, 1]
+    PoolArgs args = { X, Y, 0, 0, 0, 0, 0, 0, kt };
+    parallel_for((size_t)X->n * X->c, parallel_grain((size_t)X->h * X->w), global_avgpool_range, &args);
 }
 
 // ============================================================
-// 8. Gemm (General Matrix Multiplication)
+// 7. Gemm (General Matrix Multiplication)
 // Y = alpha * A * B + beta * C
 // Thường dùng cho lớp Fully Connected cuối cùng
 // ============================================================
-void op_gemm(Tensor* A, Tensor* B, Tensor* C, Tensor* Y, 
+// Y[M, N] = beta * C, C broadcast một chiều theo ONNX tới [M, N] (theo shape của C, không theo số phần tử)
+static void gemm_fill_bias(const Tensor* C, float* Y, int M, int N, float beta) {
+    if (C == NULL) return;
+    int dims[2] = { M, N };
+    size_t strides[2];
+    if (tensor_broadcast_strides(C, 2, dims, strides) != 0) {
+        // infer_shape đã chặn trường hợp này, chỉ gặp khi gọi op trực tiếp
+        fprintf(stderr, "[Error] Gemm: bias %s cannot broadcast to [%d, %d]\n", C->name ? C->name : "?", M, N);
+        memset(Y, 0, (size_t)M * N * sizeof(float));
+        return;
+    }
+    for (int i = 0; i < M; i++) {
+        float* y = Y + (size_t)i * N;
+        const float* c = C->data + (size_t)i * strides[0];
+        for (int j = 0; j < N; j++) y[j] = beta * c[(size_t)j * strides[1]];
+    }
+}
+
+void op_gemm(const KernelTable* kt, Tensor* A, Tensor* B, Tensor* C, Tensor* Y, 
              float alpha, float beta, 
              int transA, int transB) {
     
-    // Giả định chuẩn cho Inference ResNet ONNX:
-    // A: Input vector [Batch, In_Features] (transA = 0)
-    // B: Weights [Out_Features, In_Features] (transB = 1 - đã chuyển vị)
-    // C: Bias [Out_Features]
-    // Y: Output [Batch, Out_Features]
-
-    int batch_size = A->n;
-    int M = A->c * A->h * A->w; // In_Features (sau khi flatten)
-    int N = Y->c * Y->h * Y->w; // Out_Features
-
-    for (int i = 0; i < batch_size; i++) { // Duyệt từng mẫu trong batch
-        for (int j = 0; j < N; j++) { // Duyệt từng neuron output
-            
-            float sum = 0.0f;
-            
-            // Tính tích vô hướng (Dot Product)
-            for (int k = 0; k < M; k++) {
-                float a_val = A->data[i * M + k]; 
-                
-                float b_val;
-                if (transB) {
-                    // B shape [N, M], lấy hàng j cột k
-                    b_val = B->data[j * M + k]; 
-                } else {
-                    // B shape [M, N], lấy hàng k cột j
-                    b_val = B->data[k * N + j];
-                }
+    // A, B: ma trận 2D (tensor_matrix_dims), lưu row-major
+    // C: Bias, broadcast một chiều theo ONNX tới [M, N]: [M, N], [1, N], [M, 1], [N] hoặc scalar
+    // Y: Output [M, N]
+    int rows_a, cols_a, rows_b, cols_b;
+    tensor_matrix_dims(A, &rows_a, &cols_a);
+    tensor_matrix_dims(B, &rows_b, &cols_b);
+    int M = transA ? cols_a : rows_a;
+    int K = transA ? rows_a : cols_a;
+    int N = transB ? rows_b : cols_b;
 
-                sum += a_val * b_val;
-            }
+    // Khởi tạo Y = beta * C, sau đó SGEMM cộng dồn alpha * op(A) * op(B)
+    gemm_fill_bias(C, Y->data, M, N, beta);
+
+    // Lưu ý: lda/ldb là độ dài hàng lưu trong bộ nhớ, không phụ thuộc trans
+    sgemm_ex(kt, transA, transB, M, N, K,
+             alpha, A->data, cols_a,
+             B->data, cols_b,
+             (C != NULL) ? 1.0f : 0.0f, Y->data, N);
+}
+
+typedef struct {
+    const KernelTable* kt;
+    int N, K;
+    float alpha, beta;
+    const float* x;
+    const float* packed_b;
+    float* y;
+} GemvArgs;
+
+// Các panel [begin, end) của y
+static void gemv_range(void* arg, size_t begin, size_t end) {
+    const GemvArgs* g = (const GemvArgs*)arg;
+    sgemv_packed(g->kt, g->N, g->K, g->alpha, g->x, g->packed_b, g->beta, g->y,
+                 (int)begin * GEMV_NR, (int)end * GEMV_NR);
+}
+
+// Batch 1: một lượt đọc tuần tự qua weights đã pack (xem sgemv_packed trong gemm.h)
+void op_gemv_packed(const KernelTable* kt, Tensor* A, const float* packed_b, Tensor* C, Tensor* Y,
+                    float alpha, float beta) {
+    int M, K, N;
+    tensor_matrix_dims(A, &M, &K);
+    N = Y->dims[Y->rank - 1];
+    gemm_fill_bias(C, Y->data, 1, N, beta);
+
+    // Mỗi thread đọc một dải panel GEMV_NR cột riêng của weights
+    GemvArgs args = { kt, N, K, alpha, (C != NULL) ? 1.0f : 0.0f, A->data, packed_b, Y->data };
+    size_t n_panels = (size_t)(N + GEMV_NR - 1) / GEMV_NR;
+    parallel_for(n_panels, parallel_grain((size_t)K * GEMV_NR), gemv_range, &args);
+}
+
+// ============================================================
+// 9. Contiguous (materialize view có stride)
+// ============================================================
+typedef struct {
+    const Tensor* X;
+    Tensor* Y;
+} CopyArgs;
+
+// Các hàng (chiều trong cùng) thứ [begin, end) của Y, đọc X theo strides như add_broadcast_range
+static void contiguous_range(void* arg, size_t begin, size_t end) {
+    const CopyArgs* a = (const CopyArgs*)arg;
+    const Tensor* X = a->X;
+    int rank = X->rank;
+    int inner = (rank > 0) ? X->dims[rank - 1] : 1;
+    size_t si = (rank > 0) ? X->strides[rank - 1] : 0;
 
-            // Cộng Bias
-            float bias_val = (C != NULL) ? C->data[j] : 0.0f;
-            
-            // Kết quả cuối cùng
-            Y->data[i * N + j] = alpha * sum + beta * bias_val;
+    int idx[TENSOR_MAX_RANK] = { 0 };
+    size_t off = 0, rest = begin;
+    for (int d = rank - 2; d >= 0; d--) {
+        idx[d] = (int)(rest % X->dims[d]);
+        rest /= X->dims[d];
+        off += idx[d] * X->strides[d];
+    }
+    float* y = a->Y->data + begin * inner;
+
+    for (size_t o = begin; o < end; o++) {
+        const float* px = X->data + off;
+        for (int j = 0; j < inner; j++) y[j] = px[j * si];
+        y += inner;
+
+        for (int d = rank - 2; d >= 0; d--) {
+            off += X->strides[d];
+            if (++idx[d] < X->dims[d]) break;
+            off -= X->strides[d] * X->dims[d];
+            idx[d] = 0;
         }
     }
-}
\ No newline at end of file
+}
+
+void op_contiguous(const Tensor* X, Tensor* Y) {
+    size_t numel = tensor_numel(X);
+    if (tensor_is_contiguous(X)) {
+        memcpy(Y->data, X->data, numel * sizeof(float));
+        return;
+    }
+    CopyArgs args = { X, Y };
+    int inner = (X->rank > 0) ? X->dims[X->rank - 1] : 1;
+    size_t n_outer = (inner > 0) ? numel / inner : 0;
+    parallel_for(n_outer, parallel_grain((size_t)inner), contiguous_range, &args);
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/exec_plan.h"
+#include "../include/op_registry.h"
+#include "../include/graph.h"
+#include "../include/fusion.h"
+#include "../include/layout.h"
+#include "../include/pass_manager.h"
+
+// ============================================================
+// 1. CLEANUP PASSES
+// ============================================================
+
+// Node không có output nào được dùng (và không sinh output của graph) bị xóa.
+// Duyệt ngược để chuỗi node chết được xóa trong một lượt.
+static int eliminate_dead_nodes(ExecPlan* plan) {
+    if (plan->n_nodes <= 0) return 0;
+    GraphIndex g;
+    graph_index_build(&g, plan);
+
+    for (int i = plan->n_nodes - 1; i >= 0; i--) {
+        const ExecNode* n = &plan->nodes[i];
+        int live = 0;
+        for (int k = 0; k < n->n_outputs; k++) {
+            int s = n->outputs[k];
+            if (s == plan->output_slot || g.use_count[s] > 0) live = 1;
+        }
+        if (!live) graph_remove_node(&g, i);
+    }
+
+    int n_removed = graph_compact(&g);
+    if (n_removed > 0) printf("[Pass] %d dead nodes removed\n", n_removed);
+    graph_index_free(&g);
+    return n_removed;
+}
+
+// Identity và Dropout (lúc inference) trả lại đúng input: mọi nơi đọc output chuyển sang
+// đọc input, node bị xóa. Dropout có dùng output mask thì giữ lại.
+static int eliminate_identity(ExecPlan* plan) {
+    if (plan->n_nodes <= 0) return 0;
+    GraphIndex g;
+    graph_index_build(&g, plan);
+
+    for (int i = 0; i < plan->n_nodes; i++) {
+        const ExecNode* n = &plan->nodes[i];
+        const char* op = n->kernel->op_type;
+        if (strcmp(op, "Identity") != 0 && strcmp(op, "Dropout") != 0) continue;
+        if (n->n_inputs < 1 || n->inputs[0] < 0) continue;
+
+        int mask_used = 0;
+        for (int k = 1; k < n->n_outputs; k++) {
+            int s = n->outputs[k];
+            if (s == plan->output_slot || g.use_count[s] > 0) mask_used = 1;
+        }
+        if (mask_used) continue;
+
+        // Output của graph phải do một node sinh ra (không trỏ thẳng vào input / weight)
+        int in = n->inputs[0], out = n->outputs[0];
+        if (out == plan->output_slot && g.producer[in] < 0) continue;
+
+        graph_replace_uses(&g, out, in);
+        graph_remove_node(&g, i);
+    }
+
+    int n_removed = graph_compact(&g);
+    if (n_removed > 0) printf("[Pass] %d Identity/Dropout nodes removed\n", n_removed);
+    graph_index_free(&g);
+    return n_removed;
+}
+
+// ============================================================
+// 2. PASS TABLE
+// ============================================================
+
+static const GraphPass passes[] = {
+    { "dead-node-elimination", "Remove nodes whose outputs are never used",           eliminate_dead_nodes },
+    { "eliminate-identity",    "Forward Identity / Dropout inputs to their consumers", eliminate_identity },
+    { "fold-batchnorm",        "Fold Conv -> BatchNormalization into Conv weights",   fusion_fold_batchnorm },
+    { "fuse-conv-epilogue",    "Fuse Conv -> [BatchNorm] -> [Add] -> [Relu]",         fusion_apply },
+    { "layout-nchwc",          "Run supported nodes in the blocked NCHWc layout",     layout_assign_nchwc },
+};
+
+#define N_PASSES ((int)(sizeof(passes) / sizeof(passes[0])))
+
+static int pass_disabled[N_PASSES];
+
+int graph_pass_set_enabled(const char* name, int enabled) {
+    for (int i = 0; i < N_PASSES; i++) {
+        if (strcmp(passes[i].name, name) == 0) {
+            pass_disabled[i] = !enabled;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void graph_pass_list(void) {
+    printf("Graph passes (in order):\n");
+    for (int i = 0; i < N_PASSES; i++) {
+        printf("  %-22s %s%s\n", passes[i].name, passes[i].description, pass_disabled[i] ? " [disabled]" : "");
+    }
+}
+
+// ============================================================
+// 3. RUN
+// ============================================================
+
+int graph_passes_run(ExecPlan* plan) {
+    if (graph_verify(plan, "compile") != 0) return -1;
+
+    for (int i = 0; i < N_PASSES; i++) {
+        if (pass_disabled[i]) {
+            printf("[Pass] %s disabled\n", passes[i].name);
+            continue;
+        }
+        if (passes[i].run(plan) < 0 || graph_verify(plan, passes[i].name) != 0) {
+            fprintf(stderr, "[Error] Graph pass %s failed\n", passes[i].name);
+            return -1;
+        }
+    }
+    return 0;
+}
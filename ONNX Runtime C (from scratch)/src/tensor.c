@@ -3,17 +3,139 @@
 #include <stdio.h>
 
 Tensor* tensor_create(const char* name, int n, int c, int h, int w) {
-    Tensor* t = (Tensor*)malloc(sizeof(Tensor));
+    int dims[4] = { n, c, h, w };
+    return tensor_create_nd(name, 4, dims, TENSOR_FLOAT32);
+}
+
+Tensor* tensor_create_nd(const char* name, int rank, const int* dims, TensorDType dtype) {
+    Tensor* t = (Tensor*)calloc(1, sizeof(Tensor));
     t->name = strdup(name); // Copy tên
-    t->n = n; t->c = c; t->h = h; t->w = w;
-    t->data = (float*)calloc(n * c * h * w, sizeof(float));
+    t->dtype = dtype;
+    t->layout = TENSOR_LAYOUT_NCHW;
+    tensor_set_shape(t, rank, dims);
+
+    // aligned_alloc yêu cầu kích thước là bội của alignment
+    size_t bytes = tensor_numel(t) * tensor_dtype_size(dtype);
+    bytes = (bytes + TENSOR_ALIGNMENT - 1) / TENSOR_ALIGNMENT * TENSOR_ALIGNMENT;
+    if (bytes == 0) bytes = TENSOR_ALIGNMENT;
+    t->data = (float*)aligned_alloc(TENSOR_ALIGNMENT, bytes);
+    memset(t->data, 0, bytes);
     return t;
 }
 
+Tensor* tensor_clone(const Tensor* t) {
+    Tensor* c = tensor_create_nd(t->name ? t->name : "", t->rank, t->dims, t->dtype);
+    memcpy(c->data, t->data, tensor_numel(t) * tensor_dtype_size(t->dtype));
+    return c;
+}
+
+void tensor_set_shape(Tensor* t, int rank, const int* dims) {
+    if (rank > TENSOR_MAX_RANK) {
+        fprintf(stderr, "[Error] Tensor %s: rank %d exceeds %d\n", t->name ? t->name : "?", rank, TENSOR_MAX_RANK);
+        exit(1);
+    }
+    t->rank = rank;
+    size_t stride = 1;
+    for (int i = rank - 1; i >= 0; i--) {
+        t->dims[i] = dims[i];
+        t->strides[i] = stride;
+        stride *= (size_t)dims[i];
+    }
+
+    // View 4 chiều căn phải, các chiều dư ở đầu gộp vào n
+    int v[4] = { 1, 1, 1, 1 };
+    for (int i = 0; i < rank; i++) {
+        int k = 4 - rank + i;
+        if (k < 0) v[0] *= dims[i];
+        else v[k] = (k == 0) ? v[0] * dims[i] : dims[i];
+    }
+    t->n = v[0]; t->c = v[1]; t->h = v[2]; t->w = v[3];
+}
+
+size_t tensor_numel(const Tensor* t) {
+    size_t numel = 1;
+    for (int i = 0; i < t->rank; i++) numel *= (size_t)t->dims[i];
+    return numel;
+}
+
+size_t tensor_dtype_size(TensorDType dtype) {
+    return (dtype == TENSOR_INT64) ? sizeof(int64_t) : sizeof(float);
+}
+
+int tensor_is_contiguous(const Tensor* t) {
+    size_t stride = 1;
+    for (int i = t->rank - 1; i >= 0; i--) {
+        if (t->dims[i] != 1 && t->strides[i] != stride) return 0;
+        stride *= (size_t)t->dims[i];
+    }
+    return 1;
+}
+
+void tensor_matrix_dims(const Tensor* t, int* rows, int* cols) {
+    *cols = (t->rank > 0) ? t->dims[t->rank - 1] : 1;
+    *rows = (*cols > 0) ? (int)(tensor_numel(t) / *cols) : 0;
+}
+
+int64_t tensor_int64_at(const Tensor* t, size_t i) {
+    if (t->dtype == TENSOR_INT64) return ((const int64_t*)t->data)[i];
+    return (int64_t)t->data[i];
+}
+
+void tensor_permute_view(Tensor* dst, const Tensor* src, const int* perm) {
+    int dims[TENSOR_MAX_RANK];
+    size_t strides[TENSOR_MAX_RANK];
+    for (int i = 0; i < src->rank; i++) {
+        dims[i] = src->dims[perm[i]];
+        strides[i] = src->strides[perm[i]];
+    }
+    tensor_set_shape(dst, src->rank, dims);
+    memcpy(dst->strides, strides, src->rank * sizeof(size_t));
+    dst->dtype = src->dtype;
+    dst->layout = src->layout;
+    dst->data = src->data;
+}
+
+int tensor_broadcast_shape(const Tensor* a, const Tensor* b, int* dims) {
+    int rank = (a->rank > b->rank) ? a->rank : b->rank;
+    for (int i = 0; i < rank; i++) {
+        int ia = i - (rank - a->rank), ib = i - (rank - b->rank);
+        int da = (ia >= 0) ? a->dims[ia] : 1;
+        int db = (ib >= 0) ? b->dims[ib] : 1;
+        if (da != db && da != 1 && db != 1) return -1;
+        dims[i] = (da == 1) ? db : da;
+    }
+    return rank;
+}
+
+int tensor_broadcast_strides(const Tensor* t, int rank, const int* dims, size_t* strides) {
+    if (t->rank > rank) return -1;
+    for (int i = 0; i < rank; i++) {
+        int it = i - (rank - t->rank);
+        if (it < 0) {
+            strides[i] = 0;
+        } else if (t->dims[it] == dims[i]) {
+            strides[i] = t->strides[it];
+        } else if (t->dims[it] == 1) {
+            strides[i] = 0;
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+size_t tensor_storage_size(const Tensor* t) {
+    int c = t->c;
+    if (t->layout == TENSOR_LAYOUT_NCHWC) {
+        c = (c + TENSOR_BLOCK_C - 1) / TENSOR_BLOCK_C * TENSOR_BLOCK_C;
+    }
+    return (size_t)t->n * c * t->h * t->w;
+}
+
 void tensor_free(Tensor* t) {
     if (t) {
         if (t->name) free(t->name);
         if (t->data) free(t->data);
         free(t);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,342 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "../include/thread_pool.h"
+
+// Số vòng spin của worker trước khi ngủ (mỗi vòng một lệnh pause, tổng cỡ 100 micro giây)
+#define POOL_SPIN_ITERS 4096
+
+// Thread đợi group cứ sau số vòng này thì nhường CPU một lần (máy có ít core hơn số thread)
+#define POOL_YIELD_AFTER 256
+
+#define DEQUE_INITIAL_CAP 64
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// ============================================================
+// 1. DEQUE TASK (MỖI THREAD MỘT DEQUE)
+// ============================================================
+
+typedef struct {
+    TaskFn fn;
+    void* arg;
+    size_t index;
+    TaskGroup* group;
+} Task;
+
+// Chủ deque đẩy / lấy ở tail, thread khác lấy trộm ở head; [head, tail) là các task đang chờ.
+// Khóa chỉ bị tranh chấp khi có thread lấy trộm nên chi phí chủ yếu là một lần lock không tranh chấp.
+typedef struct {
+    pthread_mutex_t lock;
+    Task* items;
+    size_t head, tail, cap;
+} __attribute__((aligned(64))) TaskDeque;
+
+static void deque_init(TaskDeque* d) {
+    pthread_mutex_init(&d->lock, NULL);
+    d->cap = DEQUE_INITIAL_CAP;
+    d->items = (Task*)malloc(d->cap * sizeof(Task));
+    d->head = d->tail = 0;
+}
+
+static void deque_destroy(TaskDeque* d) {
+    pthread_mutex_destroy(&d->lock);
+    free(d->items);
+}
+
+static void deque_push(TaskDeque* d, const Task* t) {
+    pthread_mutex_lock(&d->lock);
+    if (d->tail == d->cap) {
+        size_t count = d->tail - d->head;
+        if (d->head >= d->cap / 2) {
+            // Nửa đầu đã bị lấy hết: dồn về đầu mảng thay vì cấp phát thêm
+            memmove(d->items, d->items + d->head, count * sizeof(Task));
+        } else {
+            d->cap *= 2;
+            Task* items = (Task*)malloc(d->cap * sizeof(Task));
+            memcpy(items, d->items + d->head, count * sizeof(Task));
+            free(d->items);
+            d->items = items;
+        }
+        d->head = 0;
+        d->tail = count;
+    }
+    d->items[d->tail++] = *t;
+    pthread_mutex_unlock(&d->lock);
+}
+
+// from_head = 0: chủ deque lấy task mới nhất, 1: thread khác lấy trộm task cũ nhất
+static int deque_take(TaskDeque* d, Task* t, int from_head) {
+    pthread_mutex_lock(&d->lock);
+    int found = d->head < d->tail;
+    if (found) {
+        *t = from_head ? d->items[d->head++] : d->items[--d->tail];
+        if (d->head == d->tail) d->head = d->tail = 0;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+// ============================================================
+// 2. TRẠNG THÁI POOL
+// ============================================================
+
+typedef struct {
+    pthread_t* threads;
+    TaskDeque* deques;              // [n_threads]: deque 0 của các thread ngoài pool
+    // Kể cả thread gọi; 0 = chưa khởi tạo. Ghi (release) sau khi deques đã sẵn sàng, đọc (acquire)
+    // không cần khóa: thread thấy n > 0 thì cũng thấy deques đã khởi tạo xong
+    atomic_int n_threads;
+    atomic_uint epoch;              // Tăng mỗi khi có task mới
+    atomic_int n_sleeping;          // Worker đang ngủ đợi task mới
+    atomic_int n_waiting;           // Thread đang ngủ trong task_group_wait
+    atomic_int stop;
+    pthread_mutex_t lock;           // Chỉ dùng cho ngủ / đánh thức
+    pthread_cond_t wake;            // Có task mới (worker)
+    pthread_cond_t done;            // Một group vừa xong (task_group_wait)
+} ThreadPool;
+
+static ThreadPool pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+static int pool_requested = 0;       // Kích thước do thread_pool_set_size đặt (0: mặc định)
+static pthread_mutex_t pool_init_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Deque của thread hiện tại: worker k dùng deque k, thread ngoài pool dùng deque 0
+static _Thread_local int self_index = 0;
+
+// Lấy task: deque của mình trước, sau đó lấy trộm lần lượt từ các thread kế tiếp
+static int find_task(Task* t) {
+    int n = atomic_load_explicit(&pool.n_threads, memory_order_acquire);
+    if (deque_take(&pool.deques[self_index], t, 0)) return 1;
+    for (int k = 1; k < n; k++) {
+        if (deque_take(&pool.deques[(self_index + k) % n], t, 1)) return 1;
+    }
+    return 0;
+}
+
+static void run_task(const Task* t) {
+    t->fn(t->arg, t->index);
+    // Task cuối của group: đánh thức thread đang ngủ trong task_group_wait. Sau lệnh trừ này group
+    // có thể đã bị hủy (nằm trên stack của thread đợi) nên không được đọc lại t->group.
+    // Thread đợi tăng n_waiting rồi mới kiểm tra pending, ở đây trừ pending rồi mới xem n_waiting
+    // nên không mất tín hiệu (giống task_spawn / wait_for_work).
+    if (atomic_fetch_sub(&t->group->pending, 1) == 1 && atomic_load(&pool.n_waiting) > 0) {
+        pthread_mutex_lock(&pool.lock);
+        pthread_cond_broadcast(&pool.done);
+        pthread_mutex_unlock(&pool.lock);
+    }
+}
+
+// ============================================================
+// 3. WORKER
+// ============================================================
+
+// Đợi epoch khác seen (có task mới): spin trước, hết số vòng thì ngủ trên condition variable
+static void wait_for_work(unsigned seen) {
+    for (int i = 0; i < POOL_SPIN_ITERS; i++) {
+        if (atomic_load(&pool.epoch) != seen || atomic_load(&pool.stop)) return;
+        cpu_relax();
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    atomic_fetch_add(&pool.n_sleeping, 1);
+    while (atomic_load(&pool.epoch) == seen && !atomic_load(&pool.stop)) {
+        pthread_cond_wait(&pool.wake, &pool.lock);
+    }
+    atomic_fetch_sub(&pool.n_sleeping, 1);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+static void* worker_main(void* arg) {
+    self_index = (int)(intptr_t)arg;
+
+    for (;;) {
+        // Đọc epoch trước khi tìm: task được đẩy sau lần tìm này chắc chắn làm epoch thay đổi
+        unsigned seen = atomic_load(&pool.epoch);
+        Task t;
+        if (find_task(&t)) {
+            run_task(&t);
+            continue;
+        }
+        if (atomic_load(&pool.stop)) break;
+        wait_for_work(seen);
+    }
+    return NULL;
+}
+
+// ============================================================
+// 4. KHỞI TẠO / DỪNG
+// ============================================================
+
+static int default_size(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+}
+
+// Gọi khi đang giữ pool_init_lock
+static void pool_start(int n) {
+    if (n < 1) n = 1;
+    atomic_store(&pool.stop, 0);
+    pool.threads = (pthread_t*)calloc(n, sizeof(pthread_t));
+    pool.deques = (TaskDeque*)aligned_alloc(64, n * sizeof(TaskDeque));
+    for (int i = 0; i < n; i++) deque_init(&pool.deques[i]);
+
+    // n_threads phải có trước khi worker đầu tiên tìm task
+    atomic_store_explicit(&pool.n_threads, n, memory_order_release);
+    for (int i = 1; i < n; i++) {
+        if (pthread_create(&pool.threads[i], NULL, worker_main, (void*)(intptr_t)i) != 0) {
+            fprintf(stderr, "[Warning] Thread pool: only %d of %d threads started\n", i, n);
+            // Worker chưa tạo không bao giờ lấy task từ deque của mình, chỉ cần thu nhỏ phạm vi tìm
+            atomic_store_explicit(&pool.n_threads, i, memory_order_release);
+            break;
+        }
+    }
+}
+
+// Gọi khi đang giữ pool_init_lock và không còn task nào (xem thread_pool_set_size)
+static void pool_stop(void) {
+    int n = atomic_load_explicit(&pool.n_threads, memory_order_relaxed);
+    if (n == 0) return;
+    pthread_mutex_lock(&pool.lock);
+    atomic_store(&pool.stop, 1);
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    // Worker chỉ thoát sau một lần find_task không thấy gì: khi join xong không còn ai đọc deques.
+    // Về 0 trước khi giải phóng deques để lời gọi thread_pool_size sau đó tạo pool mới.
+    for (int i = 1; i < n; i++) pthread_join(pool.threads[i], NULL);
+    atomic_store_explicit(&pool.n_threads, 0, memory_order_release);
+    for (int i = 0; i < n; i++) deque_destroy(&pool.deques[i]);
+    free(pool.deques);
+    free(pool.threads);
+    pool.deques = NULL;
+    pool.threads = NULL;
+}
+
+void thread_pool_set_size(int n) {
+    pthread_mutex_lock(&pool_init_lock);
+    pool_requested = (n > 0) ? n : 0;
+    pool_stop();
+    pool_start(pool_requested ? pool_requested : default_size());
+    pthread_mutex_unlock(&pool_init_lock);
+}
+
+int thread_pool_size(void) {
+    int n = atomic_load_explicit(&pool.n_threads, memory_order_acquire);
+    if (__builtin_expect(n == 0, 0)) {
+        // Khởi tạo lần đầu: kiểm tra lại dưới khóa, chỉ một thread tạo pool
+        pthread_mutex_lock(&pool_init_lock);
+        if (atomic_load_explicit(&pool.n_threads, memory_order_relaxed) == 0) {
+            pool_start(pool_requested ? pool_requested : default_size());
+        }
+        n = atomic_load_explicit(&pool.n_threads, memory_order_relaxed);
+        pthread_mutex_unlock(&pool_init_lock);
+    }
+    return n;
+}
+
+void thread_pool_shutdown(void) {
+    pthread_mutex_lock(&pool_init_lock);
+    pool_stop();
+    pthread_mutex_unlock(&pool_init_lock);
+}
+
+// ============================================================
+// 5. TASK API
+// ============================================================
+
+void task_spawn(TaskGroup* group, TaskFn fn, void* arg, size_t index) {
+    thread_pool_size();
+    Task t = { fn, arg, index, group };
+    atomic_fetch_add(&group->pending, 1);
+    deque_push(&pool.deques[self_index], &t);
+
+    // Tăng epoch sau khi đẩy rồi mới xem có ai ngủ: worker tăng n_sleeping rồi mới kiểm tra epoch,
+    // nên hoặc worker thấy epoch mới, hoặc ở đây thấy worker đang ngủ (không mất tín hiệu)
+    atomic_fetch_add(&pool.epoch, 1);
+    if (atomic_load(&pool.n_sleeping) > 0) {
+        pthread_mutex_lock(&pool.lock);
+        pthread_cond_signal(&pool.wake);
+        pthread_mutex_unlock(&pool.lock);
+    }
+}
+
+// Ngủ tới khi group xong (task cuối của group đánh thức trong run_task)
+static void group_sleep(TaskGroup* group) {
+    pthread_mutex_lock(&pool.lock);
+    atomic_fetch_add(&pool.n_waiting, 1);
+    while (atomic_load(&group->pending) > 0) pthread_cond_wait(&pool.done, &pool.lock);
+    atomic_fetch_sub(&pool.n_waiting, 1);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+void task_group_wait(TaskGroup* group) {
+    for (int i = 0; atomic_load(&group->pending) > 0; ) {
+        Task t;
+        if (find_task(&t)) {
+            run_task(&t);
+            i = 0;
+        } else if (++i < POOL_SPIN_ITERS) {
+            // Task còn lại đang chạy trên thread khác: thường xong ngay, spin trước
+            if (i % POOL_YIELD_AFTER == 0) sched_yield();
+            else cpu_relax();
+        } else {
+            // Không còn task nào để lấy: ngủ thay vì chiếm core (task lồng nhau của group
+            // do thread đang chạy nó đẩy ra, thread đó tự chạy hoặc worker lấy trộm)
+            group_sleep(group);
+            return;
+        }
+    }
+}
+
+// ============================================================
+// 6. PARALLEL FOR
+// ============================================================
+
+typedef struct {
+    ParallelFn fn;
+    void* ctx;
+    size_t n;
+    size_t chunk;           // Số phần tử mỗi đoạn (đoạn cuối có thể ít hơn)
+} ParallelJob;
+
+static void parallel_chunk(void* arg, size_t c) {
+    const ParallelJob* job = (const ParallelJob*)arg;
+    size_t begin = c * job->chunk;
+    size_t end = (begin + job->chunk < job->n) ? begin + job->chunk : job->n;
+    job->fn(job->ctx, begin, end);
+}
+
+void parallel_for(size_t n, size_t grain, ParallelFn fn, void* ctx) {
+    if (n == 0) return;
+    if (grain < 1) grain = 1;
+
+    size_t n_chunks = (n + grain - 1) / grain;
+    size_t threads = (size_t)thread_pool_size();
+    if (n_chunks > threads) n_chunks = threads;
+    if (n_chunks <= 1) {
+        fn(ctx, 0, n);
+        return;
+    }
+
+    ParallelJob job = { fn, ctx, n, (n + n_chunks - 1) / n_chunks };
+    n_chunks = (n + job.chunk - 1) / job.chunk;
+
+    // job nằm trên stack: task_group_wait chỉ trả về khi mọi đoạn đã chạy xong
+    TaskGroup group = TASK_GROUP_INIT;
+    for (size_t c = n_chunks - 1; c >= 1; c--) task_spawn(&group, parallel_chunk, &job, c);
+    parallel_chunk(&job, 0);
+    task_group_wait(&group);
+}
@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../include/onnx_parser.h"
+#include "../include/engine.h"
+#include "../include/batch_queue.h"
+#include "../include/async_session.h"
+#include "../include/pass_manager.h"
+#include "../include/thread_pool.h"
+
+/**
+ * Kiểm tra cả engine trên các model nhỏ trong tests/models (sinh bởi tests/models/gen_model.py):
+ *   mini.onnx       ResNet thu nhỏ nhiều nhánh (downsample, skip connection), input [N, 3, 64, 64]
+ *   group.onnx      như mini nhưng Conv group / depthwise
+ *   broadcast.onnx  như mini, thêm Conv -> Add với activation [N, C, 1, 1] (không được fuse)
+ *   transpose.onnx  như mini nhưng đầu ra đi qua Reshape / Transpose (view có stride)
+ * Bản tham chiếu: session không bật pass nào, bảng kernel generic, 1 thread, từng ảnh một.
+ * Sau đó so với session có mọi pass + kernel tốt nhất + nhiều thread:
+ *   - batch 1 và batch N, đổi qua lại (plan được lập lại theo shape của input)
+ *   - batch queue với nhiều client
+ *   - async (handle và callback)
+ *   - nhiều RunContext chạy đồng thời
+ * Cách chạy: ./tests/test_model tests/models
+ */
+
+#define N_SAMPLES 4
+#define N_WORKERS 4
+#define N_ROUNDS 10
+#define TOL 1e-4f
+
+static const char* all_passes[] = {
+    "dead-node-elimination", "eliminate-identity", "fold-batchnorm", "fuse-conv-epilogue", "layout-nchwc"
+};
+
+static int n_checks = 0;
+static int n_failures = 0;
+
+// ============================================================
+// 1. TIỆN ÍCH
+// ============================================================
+
+typedef struct {
+    const char* name;
+    EngineSession* session;
+    Tensor* input;              // [N_SAMPLES, 3, 64, 64]
+    float* ref;                 // [N_SAMPLES, out_size]
+    int out_size;
+    int fails;                  // Lỗi từ các thread (cộng dồn atomic)
+} ModelTest;
+
+static OnnxModel* load_model(const char* dir, const char* file) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    OnnxModel* model = onnx_load_from_file(path);
+    if (!model) fprintf(stderr, "[Error] Cannot load %s\n", path);
+    return model;
+}
+
+static const char* model_input_name(const OnnxModel* model) {
+    return model->graph->input_name ? model->graph->input_name : "data";
+}
+
+static void free_model(OnnxModel* model) {
+    free_onnx_model(model);
+}
+
+// View [1, C, H, W] của ảnh k trong input, dùng chung data
+static Tensor sample_view(const Tensor* input, int k) {
+    Tensor s = *input;
+    int dims[TENSOR_MAX_RANK];
+    memcpy(dims, input->dims, sizeof(dims));
+    dims[0] = 1;
+    tensor_set_shape(&s, input->rank, dims);
+    s.data = input->data + (size_t)k * (tensor_numel(input) / input->dims[0]);
+    return s;
+}
+
+// 0 nếu output o (dims[0] ảnh) khớp với tham chiếu bắt đầu từ ảnh k0
+static int compare(const ModelTest* t, const Tensor* o, int k0, int n) {
+    if (!o || o->dims[0] != n || (int)tensor_numel(o) != n * t->out_size) return 1;
+    const float* ref = t->ref + (size_t)k0 * t->out_size;
+    for (int i = 0; i < n * t->out_size; i++) {
+        float tol = TOL * fmaxf(1.0f, fabsf(ref[i]));
+        if (!(fabsf(o->data[i] - ref[i]) <= tol)) return 1;
+    }
+    return 0;
+}
+
+static void report(const char* model, const char* what, int fails) {
+    n_checks++;
+    if (fails) n_failures++;
+    printf("[%s] %s: %s (%d mismatches)\n", fails ? "FAIL" : " ok ", model, what, fails);
+}
+
+// ============================================================
+// 2. THAM CHIẾU VÀ CHẠY TRỰC TIẾP
+// ============================================================
+
+// Tham chiếu: không pass, kernel generic, 1 thread, từng ảnh
+static int build_reference(ModelTest* t, OnnxModel* model) {
+    for (size_t i = 0; i < sizeof(all_passes) / sizeof(all_passes[0]); i++) {
+        if (graph_pass_set_enabled(all_passes[i], 0) != 0) {
+            fprintf(stderr, "[Error] Unknown graph pass %s\n", all_passes[i]);
+            return -1;
+        }
+    }
+    thread_pool_set_size(1);
+    EngineSession* session = engine_session_create_isa(model, CPU_ISA_GENERIC);
+
+    for (int k = 0; k < N_SAMPLES; k++) {
+        Tensor s = sample_view(t->input, k);
+        Tensor* o = engine_session_run(session, &s);
+        if (!o) {
+            engine_session_free(session);
+            return -1;
+        }
+        if (!t->ref) {
+            t->out_size = (int)tensor_numel(o);
+            t->ref = (float*)malloc((size_t)N_SAMPLES * t->out_size * sizeof(float));
+        }
+        memcpy(t->ref + (size_t)k * t->out_size, o->data, t->out_size * sizeof(float));
+    }
+    engine_session_free(session);
+
+    for (size_t i = 0; i < sizeof(all_passes) / sizeof(all_passes[0]); i++) {
+        graph_pass_set_enabled(all_passes[i], 1);
+    }
+    return 0;
+}
+
+static void test_direct(ModelTest* t) {
+    int fails = 0;
+    for (int k = 0; k < N_SAMPLES; k++) {
+        Tensor s = sample_view(t->input, k);
+        fails += compare(t, engine_session_run(t->session, &s), k, 1);
+    }
+    report(t->name, "batch 1", fails);
+
+    fails = 0;
+    for (int r = 0; r < 2; r++) {
+        fails += compare(t, engine_session_run(t->session, t->input), 0, N_SAMPLES);
+    }
+    report(t->name, "batch 4 (replanned twice)", fails);
+
+    // Quay lại batch 1 sau khi đã chạy batch lớn hơn (arena đã cấp cho shape lớn)
+    fails = 0;
+    Tensor s = sample_view(t->input, N_SAMPLES - 1);
+    fails += compare(t, engine_session_run(t->session, &s), N_SAMPLES - 1, 1);
+    report(t->name, "batch 1 after batch 4", fails);
+}
+
+// ============================================================
+// 3. BATCH QUEUE
+// ============================================================
+
+typedef struct {
+    ModelTest* t;
+    BatchQueue* queue;
+    int k;
+} Client;
+
+static void* queue_client(void* arg) {
+    Client* c = (Client*)arg;
+    Tensor s = sample_view(c->t->input, c->k);
+    for (int r = 0; r < N_ROUNDS; r++) {
+        Tensor* o = batch_queue_run(c->queue, &s);
+        if (compare(c->t, o, c->k, 1)) __atomic_add_fetch(&c->t->fails, 1, __ATOMIC_RELAXED);
+        tensor_free(o);
+    }
+    return NULL;
+}
+
+static void test_batch_queue(ModelTest* t) {
+    pthread_t threads[N_WORKERS];
+    Client clients[N_WORKERS];
+    BatchQueue* queue = batch_queue_create(t->session, 3, 2000);
+    t->fails = 0;
+    for (int k = 0; k < N_WORKERS; k++) {
+        clients[k].t = t;
+        clients[k].queue = queue;
+        clients[k].k = k;
+        pthread_create(&threads[k], NULL, queue_client, &clients[k]);
+    }
+    for (int k = 0; k < N_WORKERS; k++) pthread_join(threads[k], NULL);
+    batch_queue_free(queue);
+    report(t->name, "batch queue", t->fails);
+}
+
+// ============================================================
+// 4. ASYNC
+// ============================================================
+
+typedef struct {
+    ModelTest* t;
+    int k;
+    int done;
+} CallbackArg;
+
+static void async_callback(Tensor* output, void* user_data) {
+    CallbackArg* a = (CallbackArg*)user_data;
+    if (compare(a->t, output, a->k, 1)) __atomic_add_fetch(&a->t->fails, 1, __ATOMIC_RELAXED);
+    tensor_free(output);
+    __atomic_store_n(&a->done, 1, __ATOMIC_RELEASE);
+}
+
+static void test_async(ModelTest* t) {
+    enum { N_REQUESTS = 4 * N_ROUNDS };
+    AsyncSession* async = async_session_create(t->session, 3);
+    AsyncRequest* handles[N_REQUESTS];
+    CallbackArg args[N_REQUESTS];
+    int n_handles = 0, handle_k[N_REQUESTS];
+    t->fails = 0;
+
+    // Xen kẽ request có handle và request có callback; submit bị từ chối khi đầy thì thử lại
+    for (int r = 0; r < N_REQUESTS; r++) {
+        int k = r % N_SAMPLES;
+        Tensor s = sample_view(t->input, k);
+        args[r].t = t;
+        args[r].k = k;
+        args[r].done = (r % 2 == 0);
+        if (r % 2) {
+            while (async_session_submit_callback(async, &s, async_callback, &args[r]) != 0) usleep(50);
+        } else {
+            AsyncRequest* req;
+            while (!(req = async_session_submit(async, &s))) usleep(50);
+            handle_k[n_handles] = k;
+            handles[n_handles++] = req;
+        }
+    }
+    for (int i = 0; i < n_handles; i++) {
+        t->fails += compare(t, async_request_wait(handles[i]), handle_k[i], 1);
+        async_request_free(handles[i]);
+    }
+    async_session_free(async);
+
+    // async_session_free đợi mọi request xong: mọi callback phải đã được gọi
+    for (int r = 0; r < N_REQUESTS; r++) {
+        if (!__atomic_load_n(&args[r].done, __ATOMIC_ACQUIRE)) t->fails++;
+    }
+    report(t->name, "async handles + callbacks", t->fails);
+}
+
+// ============================================================
+// 5. RUNCONTEXT ĐỒNG THỜI
+// ============================================================
+
+typedef struct {
+    ModelTest* t;
+    int k;
+} Worker;
+
+// Worker 0 dùng context mặc định của session, các worker khác có context riêng
+static void* context_worker(void* arg) {
+    Worker* w = (Worker*)arg;
+    ModelTest* t = w->t;
+    Tensor s = sample_view(t->input, w->k);
+    RunContext* ctx = (w->k == 0) ? NULL : engine_context_create(t->session);
+    for (int r = 0; r < N_ROUNDS; r++) {
+        int full = (r % 3 == 2);
+        Tensor* in = full ? t->input : &s;
+        Tensor* o = ctx ? engine_session_run_context(t->session, ctx, in) : engine_session_run(t->session, in);
+        if (compare(t, o, full ? 0 : w->k, full ? N_SAMPLES : 1)) __atomic_add_fetch(&t->fails, 1, __ATOMIC_RELAXED);
+    }
+    engine_context_free(ctx);
+    return NULL;
+}
+
+static void test_contexts(ModelTest* t) {
+    pthread_t threads[N_WORKERS];
+    Worker workers[N_WORKERS];
+    t->fails = 0;
+    for (int k = 0; k < N_WORKERS; k++) {
+        workers[k].t = t;
+        workers[k].k = k;
+        pthread_create(&threads[k], NULL, context_worker, &workers[k]);
+    }
+    for (int k = 0; k < N_WORKERS; k++) pthread_join(threads[k], NULL);
+    report(t->name, "concurrent run contexts", t->fails);
+}
+
+// ============================================================
+// 6. MAIN
+// ============================================================
+
+static int run_model(const char* dir, const char* file, float** ref_out, int* out_size) {
+    OnnxModel* model = load_model(dir, file);
+    if (!model) {
+        report(file, "load", 1);
+        return -1;
+    }
+    ModelTest t;
+    memset(&t, 0, sizeof(t));
+    t.name = file;
+    t.input = tensor_create(model_input_name(model), N_SAMPLES, 3, 64, 64);
+    unsigned int seed = 7;
+    for (size_t i = 0; i < tensor_numel(t.input); i++) {
+        seed = seed * 1103515245u + 12345u;
+        t.input->data[i] = ((seed >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+    }
+
+    if (build_reference(&t, model) != 0) {
+        report(file, "reference run", 1);
+    } else {
+        thread_pool_set_size(N_WORKERS);
+        t.session = engine_session_create(model);
+        test_direct(&t);
+        test_batch_queue(&t);
+        test_async(&t);
+        test_contexts(&t);
+        engine_session_free(t.session);
+    }
+
+    tensor_free(t.input);
+    free_model(model);
+    *ref_out = t.ref;
+    *out_size = t.out_size;
+    return t.ref ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    const char* dir = argc > 1 ? argv[1] : "tests/models";
+    float* ref_mini = NULL;
+    float* ref_other = NULL;
+    int size_mini = 0, size_other = 0;
+
+    run_model(dir, "mini.onnx", &ref_mini, &size_mini);
+    run_model(dir, "group.onnx", &ref_other, &size_other);
+    free(ref_other);
+    ref_other = NULL;
+    run_model(dir, "broadcast.onnx", &ref_other, &size_other);
+    free(ref_other);
+    ref_other = NULL;
+
+    // transpose.onnx dùng cùng weights với mini.onnx; các Transpose triệt tiêu nhau nên output phải trùng
+    if (run_model(dir, "transpose.onnx", &ref_other, &size_other) == 0 && ref_mini) {
+        int fails = (size_other != size_mini);
+        for (int i = 0; !fails && i < N_SAMPLES * size_mini; i++) {
+            if (!(fabsf(ref_other[i] - ref_mini[i]) <= TOL * fmaxf(1.0f, fabsf(ref_mini[i])))) fails++;
+        }
+        report("transpose.onnx", "matches mini.onnx", fails);
+    }
+    free(ref_mini);
+    free(ref_other);
+    thread_pool_shutdown();
+
+    printf("test_model: %d checks, %d failures\n", n_checks, n_failures);
+    return n_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+#ifndef ASYNC_SESSION_H
+#define ASYNC_SESSION_H
+
+#include "tensor.h"
+#include "engine.h"
+
+/**
+ * Inference bất đồng bộ trên một session.
+ * Submit copy input rồi trả về ngay; một thread executor chạy lần lượt các request trên RunContext
+ * riêng của async session và copy output ra khỏi arena, một thread completion gọi callback. Vì vậy copy input (thread của caller), tính
+ * toán (executor) và xử lý output (callback) của các request khác nhau chạy chồng lên nhau, và
+ * caller không phải giữ một thread cho mỗi request đang chạy.
+ *
+ * Hai cách nhận kết quả:
+ *   - async_session_submit: trả về handle, dùng async_request_poll / async_request_wait, sau đó
+ *     async_request_free.
+ *   - async_session_submit_callback: callback(output, user_data) được gọi trên thread completion,
+ *     output thuộc về callback (giải phóng bằng tensor_free), request tự giải phóng.
+ */
+typedef struct AsyncSession AsyncSession;
+typedef struct AsyncRequest AsyncRequest;
+
+// output = NULL nếu inference lỗi. Callback không được chặn lâu: các callback sau phải đợi nó.
+typedef void (*AsyncCallback)(Tensor* output, void* user_data);
+
+// max_in_flight: số request tối đa đã submit mà chưa xong (<= 0: không giới hạn).
+// session phải sống lâu hơn async session; vẫn chạy trực tiếp được trong lúc đó (context riêng).
+AsyncSession* async_session_create(EngineSession* session, int max_in_flight);
+
+// Submit không bao giờ chặn: trả về NULL (hoặc -1) nếu đã có max_in_flight request đang chạy,
+// caller thử lại sau khi một request xong. Input được copy nên caller dùng lại buffer được ngay.
+AsyncRequest* async_session_submit(AsyncSession* async, const Tensor* input);
+int async_session_submit_callback(AsyncSession* async, const Tensor* input,
+                                  AsyncCallback callback, void* user_data);
+
+// 1 nếu request đã xong (không chặn)
+int async_request_poll(const AsyncRequest* req);
+
+// Đợi request xong, trả về output (thuộc về request, hợp lệ tới async_request_free)
+Tensor* async_request_wait(AsyncRequest* req);
+
+// Giải phóng handle (và output); request phải đã xong
+void async_request_free(AsyncRequest* req);
+
+// Chạy nốt các request đã submit, đợi mọi callback rồi dừng các thread
+void async_session_free(AsyncSession* async);
+
+#endif // ASYNC_SESSION_H
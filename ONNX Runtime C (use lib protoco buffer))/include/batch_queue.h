@@ -0,0 +1,29 @@
+#ifndef BATCH_QUEUE_H
+#define BATCH_QUEUE_H
+
+#include "tensor.h"
+#include "engine.h"
+
+/**
+ * Dynamic batching: hàng đợi request đặt trước một session.
+ * Nhiều thread gọi batch_queue_run với từng ảnh riêng lẻ; một thread dispatcher gom các request
+ * đang chờ thành một batch (tối đa max_batch ảnh, hoặc khi request cũ nhất đã đợi timeout_us
+ * micro giây), ghép input theo chiều batch, chạy session một lần rồi tách output trả về từng caller.
+ * Dispatcher chạy session trên RunContext riêng của hàng đợi, nên session vẫn dùng được trực tiếp
+ * (engine_session_run_context) hoặc bởi hàng đợi khác cùng lúc. Các request trong một
+ * batch phải có cùng shape (trừ chiều batch); request khác shape được để sang batch sau.
+ */
+typedef struct BatchQueue BatchQueue;
+
+// Tạo hàng đợi, RunContext và thread dispatcher. session phải sống lâu hơn hàng đợi.
+// timeout_us = 0: chạy ngay những gì đang có trong hàng đợi, không đợi thêm.
+BatchQueue* batch_queue_create(EngineSession* session, int max_batch, int timeout_us);
+
+// Gửi input (dims[0] ảnh) và đợi kết quả. Output là tensor mới với dims[0] = input->dims[0],
+// caller giải phóng bằng tensor_free; NULL nếu inference lỗi. Gọi được từ nhiều thread cùng lúc.
+Tensor* batch_queue_run(BatchQueue* queue, const Tensor* input);
+
+// Xử lý nốt các request còn trong hàng đợi, dừng dispatcher và in thống kê batch
+void batch_queue_free(BatchQueue* queue);
+
+#endif // BATCH_QUEUE_H
@@ -0,0 +1,23 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+/**
+ * Phát hiện tập lệnh SIMD của CPU lúc chạy (cpuid + xgetbv)
+ * Các mức được sắp theo thứ tự tăng dần: mức sau bao gồm mức trước.
+ * Mức chỉ được báo khi cả CPU lẫn hệ điều hành hỗ trợ (OS phải lưu thanh ghi ymm/zmm).
+ */
+typedef enum {
+    CPU_ISA_GENERIC = 0,    // x86-64 baseline (SSE2) hoặc CPU không phải x86
+    CPU_ISA_SSE42,
+    CPU_ISA_AVX2,           // AVX2 + FMA
+    CPU_ISA_AVX512,         // AVX-512 F/DQ/BW/VL
+    CPU_ISA_COUNT
+} CpuIsa;
+
+// Tập lệnh cao nhất mà máy đang chạy hỗ trợ (kết quả được cache sau lần gọi đầu)
+CpuIsa cpu_detect_isa(void);
+
+// Tên ngắn của mức ISA ("generic", "sse42", "avx2", "avx512")
+const char* cpu_isa_name(CpuIsa isa);
+
+#endif // CPU_FEATURES_H
@@ -0,0 +1,124 @@
+#ifndef EXEC_PLAN_H
+#define EXEC_PLAN_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "tensor.h"
+
+#define MAX_NODE_IO 8
+
+struct OpKernel; // Định nghĩa trong op_registry.h
+struct NodeDag;  // Định nghĩa trong scheduler.h
+struct KernelTable; // Định nghĩa trong kernels.h
+
+/**
+ * Attributes đã được trích xuất sẵn từ node ONNX.
+ * Mỗi op chỉ dùng một phần, phần còn lại giữ giá trị mặc định.
+ * pads theo thứ tự ONNX: [h_begin, w_begin, h_end, w_end]
+ */
+typedef struct {
+    int kernel_shape[2];
+    int strides[2];
+    int pads[4];
+    int dilations[2];
+    int group;
+    float epsilon;
+    float alpha, beta;
+    int transA, transB;
+    int axis;
+    int axes[4];        // Squeeze / Unsqueeze (opset < 13; opset 13 dùng input 1)
+    int n_axes;
+    int perm[TENSOR_MAX_RANK];  // Transpose (n_perm = 0: đảo ngược thứ tự chiều)
+    int n_perm;
+} NodeAttrs;
+
+/**
+ * Các node đã được fuse vào epilogue của node này (graph fusion, xem fusion.h).
+ * Giá trị là vị trí trong inputs[] của node; 0 = không có (vị trí 0 luôn là input chính)
+ */
+typedef struct {
+    int bn_input;           // 4 input liên tiếp của BatchNorm: scale, B, mean, var
+    float bn_epsilon;
+    int residual_input;     // Toán hạng còn lại của Add
+    int relu;
+} FusedEpilogue;
+
+/**
+ * Một node đã compile: input/output là chỉ số slot (-1 = input optional bị bỏ trống)
+ */
+typedef struct {
+    const struct OpKernel* kernel;  // Resolve một lần lúc load, không strcmp khi chạy
+    void* state;        // Dữ liệu do kernel->prepare tạo ra (weights đã pack...)
+    const char* name;   // Trỏ vào tên node trong graph (chỉ để debug)
+    int inputs[MAX_NODE_IO];
+    int n_inputs;
+    int outputs[MAX_NODE_IO];
+    int n_outputs;
+    NodeAttrs attrs;
+    FusedEpilogue fused;  // Toàn 0 nếu không có gì được fuse
+    int scratch_slot;     // Slot bộ nhớ tạm của compute (-1: không cần), infer_shape đặt shape [số float]
+    const struct KernelTable* kernels;  // = ExecPlan::kernels, gán trước prepare (prepare / compute dùng)
+} ExecNode;
+
+/**
+ * Execution plan: mọi tensor (weights, input, activations) nằm trong mảng slots,
+ * vòng lặp chạy chỉ duyệt mảng nodes và truy cập slots theo chỉ số.
+ * Sau khi tạo xong, plan không bị ghi khi chạy: shape và data của input / activations / scratch
+ * nằm trong RunContext, slots của plan chỉ giữ weights và tensor mẫu (tên, layout) cho activations.
+ */
+typedef struct {
+    Tensor** slots;
+    char** slot_names;  // Chỉ dùng lúc compile / debug
+    int n_slots;
+    int cap_slots;
+    int n_weights;      // slots [0, n_weights) là weights
+
+    ExecNode* nodes;
+    int n_nodes;
+
+    int input_slot;
+    int output_slot;
+
+    struct NodeDag* dag;  // Lịch chạy song song giữa các node (NULL: chạy tuần tự theo thứ tự node)
+
+    // Bảng kernel theo ISA của session, chọn một lần lúc tạo session (trước layout pass)
+    // và không đổi về sau: layout pass và mọi op của plan chỉ dùng bảng này
+    const struct KernelTable* kernels;
+} ExecPlan;
+
+/**
+ * Workspace của một lần chạy: bản riêng của các Tensor input / activation / scratch (shape, data)
+ * và arena chứa data của chúng. Weights và kernel state (weights đã pack) dùng chung qua plan,
+ * nên nhiều thread chạy cùng một plan được, mỗi thread một RunContext.
+ */
+typedef struct RunContext {
+    Tensor** slots;         // [n_slots]: [0, n_weights) trỏ tới weights của plan, input do caller gắn
+    Tensor* tensors;        // Tensor riêng của slot [n_weights, n_slots)
+    int input_rank;         // Shape input của lần infer_shape gần nhất (-1: chưa chạy)
+    int input_dims[TENSOR_MAX_RANK];
+
+    float* arena;           // Vùng nhớ chung cho mọi activation (do memory planner quản lý)
+    size_t arena_bytes;
+    int n_plans;            // Số lần memory planner đã chạy trên context này
+
+    atomic_int* pending;    // [n_nodes] bộ đếm phụ thuộc của DAG scheduler (NULL: plan chạy tuần tự)
+} RunContext;
+
+// Thêm slot mới (tên được copy), trả về chỉ số slot. Chỉ dùng lúc compile.
+int exec_plan_add_slot(ExecPlan* plan, const char* name, Tensor* t);
+
+// Chèn node Contiguous (copy ra buffer liên tục) trước mỗi kernel không có OP_FLAG_STRIDED đọc output
+// của một view có stride (Transpose), và trước output của graph nếu cần (sau graph passes, trước prepare)
+void exec_plan_add_contiguous_copies(ExecPlan* plan);
+
+// Cấp slot scratch cho các node có kernel OP_FLAG_SCRATCH (sau graph passes, trước prepare)
+void exec_plan_add_scratch_slots(ExecPlan* plan);
+
+// Tạo / hủy workspace cho một lần chạy (plan phải đã compile xong, kể cả DAG)
+RunContext* exec_plan_context_create(const ExecPlan* plan);
+void exec_plan_context_free(RunContext* ctx);
+
+// Tìm slot theo tên, -1 nếu không có. Chỉ dùng lúc compile, không bao giờ trong vòng lặp chạy.
+int exec_plan_find_slot(const ExecPlan* plan, const char* name);
+
+#endif // EXEC_PLAN_H
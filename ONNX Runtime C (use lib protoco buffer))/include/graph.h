@@ -0,0 +1,80 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include "exec_plan.h"
+
+/**
+ * Chỉ mục cạnh producer / consumer của ExecPlan, dùng cho các pass viết lại graph.
+ * Pass chỉ đánh dấu node bị xóa (removed) trong lúc duyệt để chỉ số node không đổi;
+ * graph_compact() xóa thật sự ở cuối pass.
+ */
+typedef struct {
+    ExecPlan* plan;
+    int* producer;      // [n_slots]: node sinh ra slot, -1 nếu là weight / input của graph
+    int* use_count;     // [n_slots]: số lần slot được node (chưa bị xóa) đọc
+    int* removed;       // [n_nodes]
+} GraphIndex;
+
+void graph_index_build(GraphIndex* g, ExecPlan* plan);
+void graph_index_free(GraphIndex* g);
+
+// Node đầu tiên (sau vị trí from, chưa bị xóa) đọc slot, -1 nếu không có
+int graph_consumer(const GraphIndex* g, int slot, int from);
+
+// Như graph_consumer nhưng chỉ khi node đó là nơi DUY NHẤT dùng slot
+// (slot được đọc đúng một lần và không phải output của graph)
+int graph_sole_consumer(const GraphIndex* g, int slot, int from);
+
+// Đánh dấu xóa node, giảm use_count các input của nó
+void graph_remove_node(GraphIndex* g, int node);
+
+// Đặt node vào vị trí pos thay cho node cũ (đã bị xóa hoặc chưa), cập nhật use_count / producer
+void graph_set_node(GraphIndex* g, int pos, const ExecNode* node);
+
+// Mọi nơi đọc slot old (kể cả output của graph) chuyển sang đọc slot new
+void graph_replace_uses(GraphIndex* g, int old_slot, int new_slot);
+
+// Xóa các node đã đánh dấu, giữ nguyên thứ tự; trả về số node bị xóa.
+// Sau lệnh này chỉ mục không còn hợp lệ (cần build lại nếu dùng tiếp).
+int graph_compact(GraphIndex* g);
+
+/**
+ * Pattern matching theo chuỗi: bắt đầu từ node start, mỗi bước là node duy nhất đọc
+ * output 0 của bước khớp trước đó (qua input 0 hoặc bất kỳ input nào nếu any_input).
+ * Bước optional không khớp thì bỏ qua và thử bước sau trên cùng tensor.
+ * matched[k] = chỉ số node khớp bước k, -1 nếu bước bị bỏ qua.
+ * Trả về số node khớp, -1 nếu có bước bắt buộc không khớp.
+ */
+typedef struct {
+    const char* op_type;
+    int optional;
+    int any_input;      // Tensor nối tiếp có thể là input bất kỳ (op giao hoán như Add)
+} PatternStep;
+
+int graph_match_chain(const GraphIndex* g, int start, const PatternStep* steps, int n_steps, int* matched);
+
+/**
+ * Shape ký hiệu (symbolic) của từng slot, suy ra lúc compile khi shape input chưa biết:
+ * mỗi chiều không gian là một chuỗi phép biến đổi của Conv / pool (H -> (H + a) / s + 1) áp dụng
+ * lên input của graph, số channel lấy từ weights. Chỉ theo dõi các op giữ nguyên batch và biết
+ * trước cách đổi shape (Conv, MaxPool, GlobalAveragePool, BatchNorm, Relu, Add cùng shape...);
+ * slot do op khác sinh ra là "không biết".
+ * Dùng để chứng minh hai tensor chắc chắn cùng shape với MỌI shape input (fusion residual,
+ * Add ở layout NCHWc); không chứng minh được thì pass phải giữ đường tổng quát (có broadcast).
+ */
+typedef struct GraphShapes GraphShapes;
+
+GraphShapes* graph_shapes_build(const ExecPlan* plan);
+void graph_shapes_free(GraphShapes* shapes);
+
+// 1 nếu slot a và slot b chắc chắn có cùng shape, 0 nếu không biết hoặc khác
+int graph_shapes_equal(const GraphShapes* shapes, int slot_a, int slot_b);
+
+/**
+ * Verifier (chạy sau mỗi pass): mỗi slot activation được ghi đúng một lần, mọi input
+ * đã được tính trước khi node chạy, slot và số input/output nằm trong giới hạn,
+ * output của graph tồn tại. Trả về 0 nếu hợp lệ, -1 (kèm thông báo lỗi) nếu không.
+ */
+int graph_verify(const ExecPlan* plan, const char* stage);
+
+#endif // GRAPH_H
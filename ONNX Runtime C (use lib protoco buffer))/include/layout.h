@@ -0,0 +1,21 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include "exec_plan.h"
+#include "kernels.h"
+
+/**
+ * Layout pass (chạy một lần sau compile, trước prepare)
+ * Node nào có kernel NCHWc (op_registry_find_nchwc) thì chạy ở layout blocked; node
+ * chưa hỗ trợ giữ layout NCHW (kể cả Add mà hai toán hạng không chắc chắn cùng shape). Node chuyển layout chỉ được chèn ở biên giữa hai vùng
+ * (thực tế với ResNet: sau input của graph và trước Flatten / output).
+ *
+ * Trả về số node chạy blocked (0 nếu plan->kernels thấp hơn AVX2 + FMA), -1 nếu lỗi.
+ */
+int layout_assign_nchwc(ExecPlan* plan);
+
+// Các kernel trong nchwc.c có được dùng với bảng kernel kt không (CPU có AVX2 + FMA
+// và session không bị giới hạn xuống tập lệnh thấp hơn)
+int nchwc_cpu_supported(const KernelTable* kt);
+
+#endif // LAYOUT_H
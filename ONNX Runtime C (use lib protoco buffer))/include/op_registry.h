@@ -0,0 +1,63 @@
+#ifndef OP_REGISTRY_H
+#define OP_REGISTRY_H
+
+#include "tensor.h"
+#include "exec_plan.h"
+
+/**
+ * Operator Registry
+ * Mỗi loại op đăng ký một bộ callbacks, được tra cứu MỘT lần lúc load model:
+ *  - infer_shape: tính shape output từ shape input (gọi khi shape input thay đổi)
+ *  - prepare:     chạy một lần lúc tạo session (pack weights, chọn thuật toán...),
+ *                 kết quả lưu vào node->state
+ *  - compute:     tính toán thực sự, output đã được cấp phát sẵn
+ *  - release:     giải phóng node->state (có thể NULL)
+ *  - flags:       tổ hợp OP_FLAG_* (0 nếu không có)
+ * infer_shape/prepare trả về 0 nếu thành công, khác 0 nếu lỗi.
+ */
+typedef struct OpKernel {
+    const char* op_type;
+    int  (*infer_shape)(ExecNode* node, Tensor** slots);
+    int  (*prepare)(ExecNode* node, Tensor** slots);
+    void (*compute)(ExecNode* node, Tensor** slots);
+    void (*release)(ExecNode* node);
+    unsigned int flags;
+} OpKernel;
+
+// Op element-wise: output 0 được phép dùng chung buffer với một input cùng kích thước
+// (memory planner chỉ làm vậy khi input đó không còn được node nào đọc sau op này)
+#define OP_FLAG_INPLACE 1u
+
+// Kernel đọc node->fused: fusion pass được phép gộp BatchNorm / Add / Relu phía sau vào node
+#define OP_FLAG_FUSE_EPILOGUE 2u
+
+// Op chỉ đổi shape (Flatten, Reshape...): output 0 là view dùng chung data với input 0, không có
+// buffer riêng; compute chỉ gán con trỏ. Memory planner giữ buffer của input sống tới hết output.
+#define OP_FLAG_VIEW 4u
+
+// compute cần bộ nhớ tạm: node được cấp thêm slot scratch_slot, infer_shape đặt shape [số float]
+// cho tensor ở slot đó và memory planner cấp data trong arena (chỉ sống trong lúc node chạy)
+#define OP_FLAG_SCRATCH 8u
+
+// compute đọc input qua strides nên nhận được input không liên tục (view có stride).
+// Kernel không có cờ này luôn nhận input liên tục: exec_plan_add_contiguous_copies chèn copy trước nó.
+// Với op view (OP_FLAG_VIEW | OP_FLAG_STRIDED, ví dụ Transpose) output có thể không liên tục.
+#define OP_FLAG_STRIDED 16u
+
+// Đăng ký thêm op (hoặc ghi đè op có sẵn cùng op_type)
+void op_registry_register(const OpKernel* kernel);
+
+// Tra cứu op theo tên, NULL nếu chưa được hỗ trợ
+const OpKernel* op_registry_find(const char* op_type);
+
+// Kernel layout NCHWc thay cho kernel hiện tại của node (input/output đều blocked),
+// NULL nếu op hoặc attributes của node không được hỗ trợ ở layout này
+const OpKernel* op_registry_find_nchwc(const ExecNode* node);
+
+// Kernel chuyển layout: NCHW -> NCHWc (to_blocked = 1) hoặc NCHWc -> NCHW (to_blocked = 0)
+const OpKernel* op_registry_reorder_kernel(int to_blocked);
+
+// Kernel copy tensor có stride bất kỳ thành tensor liên tục cùng shape
+const OpKernel* op_registry_contiguous_kernel(void);
+
+#endif // OP_REGISTRY_H
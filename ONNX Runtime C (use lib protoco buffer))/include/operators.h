@@ -2,6 +2,25 @@
 #define OPERATORS_H
 
 #include "tensor.h"
+#include "kernels.h"
+
+/**
+ * Epilogue của Conv (graph fusion, xem fusion.h): áp dụng lên output khi còn trong
+ * thanh ghi / cache, ngay sau khi tính xong, thay cho các lượt BN, Add, ReLU riêng:
+ *   y = (conv + bias) * scale[c] + shift[c] + residual;  y = max(y, 0) nếu relu
+ * scale, shift: [C_out] (NULL = bỏ qua, luôn đi cùng nhau)
+ * residual: cùng shape với Y (NULL = bỏ qua)
+ * Mọi hàm Conv bên dưới nhận ep = NULL khi không có gì được fuse.
+ *
+ * Các op có vòng lặp vector hóa theo ISA nhận thêm kt: bảng kernel của session
+ * (ExecPlan::kernels, xem kernels.h), không có bảng toàn cục nào được đọc ngầm.
+ */
+typedef struct {
+    const float* scale;
+    const float* shift;
+    const Tensor* residual;
+    int relu;
+} ConvEpilogue;
 
 /**
  * 1. Convolution (Conv)
@@ -9,13 +28,65 @@
  * W: Weight [C_out, C_in, kH, kW]
  * B: Bias [C_out] (Optional - có thể là NULL)
  * Y: Output [N, C_out, H_out, W_out]
- * group: Số lượng group (thường là 1 với ResNet cơ bản)
+ * group: Số lượng group; W có shape [C_out, C_in / group, kH, kW]
+ * Bản cài đặt trực tiếp, chậm nhưng dễ kiểm chứng (dùng làm tham chiếu cho các kernel nhanh)
  */
 void op_conv2d(Tensor* X, Tensor* W, Tensor* B, Tensor* Y, 
                int stride_h, int stride_w, 
                int pad_h, int pad_w,
                int dilation_h, int dilation_w,
-               int group);
+               int group, const ConvEpilogue* ep);
+
+/**
+ * 1b. Convolution qua im2col + SGEMM
+ * Duỗi các cửa sổ kernel của X thành ma trận col [C_in / group * kH * kW, H_out * W_out]
+ * rồi tính Y = W * col bằng SGEMM cache-blocked, mỗi group một GEMM
+ * (bias và epilogue được áp dụng trong micro-kernel, không có lượt ghi riêng).
+ * col: scratch buffer có ít nhất C_in / group * kH * kW * H_out * W_out phần tử
+ */
+void op_conv2d_im2col(const KernelTable* kt, Tensor* X, Tensor* W, Tensor* B, Tensor* Y,
+                      int stride_h, int stride_w,
+                      int pad_h, int pad_w,
+                      int dilation_h, int dilation_w,
+                      int group, float* col, const ConvEpilogue* ep);
+
+/**
+ * 1c. Convolution 1x1 (pointwise, pad = 0, group = 1)
+ * Ảnh NCHW được coi trực tiếp là ma trận [C_in, H * W], Y = W * X bằng SGEMM, không im2col.
+ * Với stride > 1, SGEMM đọc X qua view có stride thay vì copy ra buffer riêng.
+ */
+void op_conv2d_1x1(const KernelTable* kt, Tensor* X, Tensor* W, Tensor* B, Tensor* Y,
+                   int stride_h, int stride_w, const ConvEpilogue* ep);
+
+/**
+ * 1d. Convolution Winograd F(4x4, 3x3) (kernel 3x3, stride 1, dilation 1, group = 1)
+ * Mỗi tile output 4x4 cần một tile input 6x6; phép nhân trong miền Winograd được gom
+ * thành 36 SGEMM [C_out, C_in] x [C_in, số tile].
+ *
+ * op_winograd_transform_filter: U = G * g * G^T cho mọi cặp (oc, ic), chỉ tính một lần
+ *   U: [36, C_out, C_in] = 36 * C_out * C_in phần tử
+ * op_conv2d_winograd: U là filter đã transform, scratch có ít nhất
+ *   op_conv2d_winograd_scratch(...) phần tử
+ */
+#define WINOGRAD_TILE 4
+#define WINOGRAD_ALPHA 6            // WINOGRAD_TILE + 3 - 1
+#define WINOGRAD_TILE_BLOCK 128     // Số tile xử lý mỗi lượt (giữ V, M trong cache)
+
+void op_winograd_transform_filter(const Tensor* W, float* U);
+size_t op_conv2d_winograd_scratch(int in_channels, int out_channels, int out_h, int out_w);
+void op_conv2d_winograd(const KernelTable* kt, Tensor* X, const float* U, Tensor* B, Tensor* Y,
+                        int pad_h, int pad_w, float* scratch,
+                        const ConvEpilogue* ep);
+
+/**
+ * 1e. Depthwise Convolution (group = C_in = C_out, W: [C, 1, kH, kW])
+ * Mỗi channel được xử lý độc lập theo từng hàng output, không cần scratch.
+ */
+void op_conv2d_depthwise(const KernelTable* kt, Tensor* X, Tensor* W, Tensor* B, Tensor* Y,
+                         int stride_h, int stride_w,
+                         int pad_h, int pad_w,
+                         int dilation_h, int dilation_w,
+                         const ConvEpilogue* ep);
 
 /**
  * 2. BatchNormalization
@@ -27,7 +98,7 @@ void op_conv2d(Tensor* X, Tensor* W, Tensor* B, Tensor* Y,
  * Y: Output
  * epsilon: hằng số nhỏ tránh chia cho 0 (thường là 1e-5)
  */
-void op_batch_normalization(Tensor* X, Tensor* scale, Tensor* B, 
+void op_batch_normalization(const KernelTable* kt, Tensor* X, Tensor* scale, Tensor* B, 
                             Tensor* mean, Tensor* var, Tensor* Y, 
                             float epsilon);
 
@@ -35,14 +106,17 @@ void op_batch_normalization(Tensor* X, Tensor* scale, Tensor* B,
  * 3. Relu
  * Hàm kích hoạt: Y = max(0, X)
  */
-void op_relu(Tensor* X, Tensor* Y);
+void op_relu(const KernelTable* kt, Tensor* X, Tensor* Y);
 
 /**
  * 4. Add (Element-wise)
  * Dùng cho kết nối tắt (skip connection) trong ResNet
  * Y = A + B
  */
-void op_add(Tensor* A, Tensor* B, Tensor* Y);
+void op_add(const KernelTable* kt, Tensor* A, Tensor* B, Tensor* Y);
+
+// Y = A + B với broadcast theo ONNX (căn phải, chiều 1 được kéo dãn); Y có shape chung của A và B
+void op_add_broadcast(Tensor* A, Tensor* B, Tensor* Y);
 
 /**
  * 5. MaxPool
@@ -58,26 +132,32 @@ void op_maxpool(Tensor* X, Tensor* Y,
  * Tính trung bình cộng toàn bộ spatial dimension (H, W) -> 1x1
  * Thường dùng cuối ResNet trước khi vào lớp Fully Connected
  */
-void op_global_average_pool(Tensor* X, Tensor* Y);
-
-/**
- * 7. Flatten
- * Duỗi Tensor nhiều chiều thành 2 chiều [Batch, Dimensions]
- * Thường dùng để nối Conv layer vào FC layer
- */
-void op_flatten(Tensor* X, Tensor* Y);
+void op_global_average_pool(const KernelTable* kt, Tensor* X, Tensor* Y);
 
 /**
- * 8. Gemm (General Matrix Multiplication)
+ * 7. Gemm (General Matrix Multiplication)
  * Dùng cho lớp Fully Connected (Linear)
- * Công thức: Y = alpha * A * B + beta * C
- * A: Input vector (sau khi flatten)
- * B: Weights ma trận
- * C: Bias
+ * Công thức: Y = alpha * op(A) * op(B) + beta * C (tính bằng SGEMM packed, xem gemm.h)
+ * A: Input vector (sau khi flatten) [batch, features]
+ * B: Weights ma trận (initializer 2D)
+ * C: Bias (có thể NULL), broadcast theo ONNX
  * transA, transB: Cờ báo hiệu có cần chuyển vị ma trận hay không (1 là có)
  */
-void op_gemm(Tensor* A, Tensor* B, Tensor* C, Tensor* Y, 
+void op_gemm(const KernelTable* kt, Tensor* A, Tensor* B, Tensor* C, Tensor* Y, 
              float alpha, float beta, 
              int transA, int transB);
 
+/**
+ * 8b. Gemm batch 1 (A: [1, K], transA = 0) với op(B) đã pack sẵn bằng sgemv_pack_b
+ * Lớp FC với 1 ảnh là GEMV bị giới hạn bởi băng thông: weights chỉ được đọc tuần tự một lần.
+ */
+void op_gemv_packed(const KernelTable* kt, Tensor* A, const float* packed_b, Tensor* C, Tensor* Y,
+                    float alpha, float beta);
+
+/**
+ * 9. Contiguous
+ * Copy X (float32, strides bất kỳ, ví dụ view của Transpose) sang Y liên tục row-major cùng shape
+ */
+void op_contiguous(const Tensor* X, Tensor* Y);
+
 #endif // OPERATORS_H
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef PASS_MANAGER_H
+#define PASS_MANAGER_H
+
+#include "exec_plan.h"
+
+/**
+ * Pass manager: các pass viết lại graph chạy theo thứ tự cố định trên ExecPlan đã
+ * compile (sau compile_plan, trước prepare). Sau compile và sau mỗi pass, graph_verify()
+ * kiểm tra lại plan; pass làm hỏng plan sẽ bị báo lỗi ngay tại pass đó.
+ *
+ * Thứ tự: dead-node-elimination, eliminate-identity, fold-batchnorm,
+ *         fuse-conv-epilogue, layout-nchwc
+ */
+typedef struct {
+    const char* name;
+    const char* description;
+    int (*run)(ExecPlan* plan);     // Trả về số thay đổi (>= 0), -1 nếu lỗi
+} GraphPass;
+
+// Bật / tắt một pass theo tên (áp dụng cho các session tạo sau đó). Trả về -1 nếu không có pass đó.
+int graph_pass_set_enabled(const char* name, int enabled);
+
+// In danh sách pass theo thứ tự chạy
+void graph_pass_list(void);
+
+// Chạy các pass đang bật. Trả về 0 nếu thành công, -1 nếu pass lỗi hoặc plan không hợp lệ.
+int graph_passes_run(ExecPlan* plan);
+
+#endif // PASS_MANAGER_H
@@ -0,0 +1,76 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+/**
+ * Thread pool dùng chung cho song song giữa các node (inter-op, xem scheduler.h) và
+ * trong một op (intra-op, parallel_for).
+ * Các worker pthread được tạo một lần và sống suốt chương trình. Mỗi thread có một deque
+ * task riêng: thread đẩy / lấy task ở đuôi deque của mình (LIFO, dữ liệu còn nóng trong cache),
+ * thread rảnh lấy trộm task ở đầu deque của thread khác. Khi không có việc, worker spin một lúc
+ * (việc mới thường đến ngay) rồi mới ngủ trên condition variable.
+ * Thread ngoài pool (thread gọi engine) dùng chung deque 0.
+ */
+
+// ============================================================
+// TASK
+// ============================================================
+
+typedef void (*TaskFn)(void* arg, size_t index);
+
+// Nhóm task: đếm số task đã spawn mà chưa chạy xong
+typedef struct {
+    atomic_size_t pending;
+} TaskGroup;
+
+#define TASK_GROUP_INIT { 0 }
+
+// Đưa task fn(arg, index) vào deque của thread hiện tại và đánh thức một worker đang ngủ
+void task_spawn(TaskGroup* group, TaskFn fn, void* arg, size_t index);
+
+// Chạy task (của deque mình trước, sau đó lấy trộm) cho tới khi mọi task của group xong.
+// Nhờ vậy thread đang đợi không ngồi không khi còn việc và các lời gọi lồng nhau không bị deadlock.
+// Khi không còn task nào để lấy (task cuối đang chạy ở thread khác), thread spin một lúc
+// rồi ngủ tới khi task cuối của group đánh thức, không chiếm core trong lúc đợi.
+void task_group_wait(TaskGroup* group);
+
+// ============================================================
+// PARALLEL FOR
+// ============================================================
+
+/**
+ * Chia [0, n) thành các đoạn liên tiếp bằng nhau (phân chia tĩnh), số đoạn không vượt quá
+ * số thread và mỗi đoạn có ít nhất grain phần tử. Thread gọi chạy đoạn đầu tiên, các đoạn còn
+ * lại là task có thể bị thread khác lấy trộm; hàm chỉ trả về khi mọi đoạn đã xong.
+ * Mỗi phần tử output chỉ do một thread ghi nên kết quả không phụ thuộc số thread.
+ * Gọi được từ bên trong một task hoặc một đoạn khác (song song lồng nhau).
+ */
+typedef void (*ParallelFn)(void* ctx, size_t begin, size_t end);
+
+void parallel_for(size_t n, size_t grain, ParallelFn fn, void* ctx);
+
+// Số phép tính tối thiểu của một đoạn: nhỏ hơn thì chi phí chia việc lớn hơn phần tiết kiệm được
+#define PARALLEL_MIN_WORK 32768
+
+// grain cho parallel_for khi mỗi phần tử tốn khoảng work phép tính
+static inline size_t parallel_grain(size_t work) {
+    return (work >= PARALLEL_MIN_WORK) ? 1 : (PARALLEL_MIN_WORK + work - 1) / (work ? work : 1);
+}
+
+// ============================================================
+// CẤU HÌNH
+// ============================================================
+
+// Đặt số thread (kể cả thread gọi), n <= 0: số core đang online.
+// Chỉ gọi khi không có task nào đang chạy; pool cũ được dừng và tạo lại.
+void thread_pool_set_size(int n);
+
+// Số thread hiện tại (khởi tạo pool với kích thước mặc định nếu chưa có)
+int thread_pool_size(void);
+
+// Dừng và join mọi worker (gọi lại parallel_for sau đó sẽ tạo pool mới)
+void thread_pool_shutdown(void);
+
+#endif // THREAD_POOL_H
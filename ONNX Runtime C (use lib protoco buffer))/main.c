@@ -2,16 +2,19 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <pthread.h>
 #include <math.h> // Cần thư viện toán học cho expf
 
 #include "include/onnx_loader.h"
 #include "include/tensor.h"
 #include "include/operators.h"
+#include "include/engine.h"
+#include "include/pass_manager.h"
+#include "include/thread_pool.h"
+#include "include/batch_queue.h"
+#include "include/async_session.h"
 #include "libs/onnx.pb-c.h"
 
-// Cập nhật prototype: engine_run trả về Tensor*
-Tensor* engine_run(Onnx__ModelProto* model, Tensor* input_img);
-
 // Hàm đọc Tensor từ file .pb (Giữ nguyên như cũ)
 Tensor* load_tensor_pb(const char* filename) {
     FILE* f = fopen(filename, "rb");
@@ -33,6 +36,17 @@ Tensor* load_tensor_pb(const char* filename) {
     return t;
 }
 
+// Nhân bản ảnh đầu tiên của t thành batch n ảnh (file input .pb thường chỉ có một ảnh)
+Tensor* repeat_batch(Tensor* t, int n) {
+    if (n <= t->n) return t;
+    size_t sample = tensor_numel(t) / t->n;
+    Tensor* r = tensor_create(t->name, n, t->c, t->h, t->w);
+    for (int b = 0; b < n; b++) memcpy(r->data + b * sample, t->data, sample * sizeof(float));
+    printf("Input replicated to batch %d\n", n);
+    tensor_free(t);
+    return r;
+}
+
 // --- HÀM MỚI: SOFTMAX ---
 void softmax(float* data, int n) {
     float max_val = -1e9;
@@ -47,43 +61,194 @@ void softmax(float* data, int n) {
     for(int i=0; i<n; i++) data[i] /= sum;
 }
 
-// --- HÀM MỚI: IN TOP 5 ---
+// --- HÀM MỚI: IN TOP 5 (MỖI ẢNH TRONG BATCH) ---
 void print_top5(Tensor* out) {
-    int size = out->c * out->h * out->w; // Thường là 1000 class
+    int batch = out->dims[0];
+    int size = (int)(tensor_numel(out) / batch); // Thường là 1000 class
     printf("\nOutput Size: %d classes\n", size);
 
-    // 1. Tính xác suất
-    softmax(out->data, size);
+    for (int b = 0; b < batch; b++) {
+        float* data = out->data + (size_t)b * size;
 
-    printf("=== TOP 5 PREDICTIONS ===\n");
-    for (int k = 0; k < 5; k++) {
-        float max_val = -1.0f;
-        int max_idx = -1;
+        // 1. Tính xác suất
+        softmax(data, size);
 
-        // Tìm giá trị lớn nhất
-        for (int i = 0; i < size; i++) {
-            if (out->data[i] > max_val) {
-                max_val = out->data[i];
-                max_idx = i;
+        if (batch > 1) printf("=== TOP 5 PREDICTIONS (sample %d) ===\n", b);
+        else printf("=== TOP 5 PREDICTIONS ===\n");
+        for (int k = 0; k < 5; k++) {
+            float max_val = -1.0f;
+            int max_idx = -1;
+
+            // Tìm giá trị lớn nhất
+            for (int i = 0; i < size; i++) {
+                if (data[i] > max_val) {
+                    max_val = data[i];
+                    max_idx = i;
+                }
             }
-        }
 
-        if (max_idx != -1) {
-            printf("#%d: Class ID %4d | Probability: %.2f%%\n", 
-                   k+1, max_idx, max_val * 100.0f);
-            
-            // Đánh dấu đã chọn để vòng lặp sau tìm số lớn tiếp theo
-            out->data[max_idx] = -1.0f; 
+            if (max_idx != -1) {
+                printf("#%d: Class ID %4d | Probability: %.2f%%\n", 
+                       k+1, max_idx, max_val * 100.0f);
+                
+                // Đánh dấu đã chọn để vòng lặp sau tìm số lớn tiếp theo
+                data[max_idx] = -1.0f; 
+            }
         }
+        printf("=========================\n");
+    }
+}
+
+// --- THỜI GIAN THỰC (clock() cộng dồn CPU time của mọi thread) ---
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// --- DYNAMIC BATCHING: NHIỀU CLIENT, MỖI CLIENT GỬI TỪNG ẢNH MỘT ---
+typedef struct {
+    BatchQueue* queue;
+    const Tensor* input;
+    int n_requests;
+    Tensor* output;     // Kết quả của request cuối cùng (thuộc về client)
+} ClientArgs;
+
+static void* client_main(void* arg) {
+    ClientArgs* c = (ClientArgs*)arg;
+    for (int r = 0; r < c->n_requests; r++) {
+        Tensor* out = batch_queue_run(c->queue, c->input);
+        tensor_free(c->output);
+        c->output = out;
+    }
+    return NULL;
+}
+
+// n_clients thread cùng gửi ảnh đầu tiên của input qua batch queue, trả về output của client 0
+// (caller giải phóng bằng tensor_free)
+static Tensor* run_clients(EngineSession* session, const Tensor* input, int n_clients, int n_requests,
+                           int max_batch, int timeout_us) {
+    BatchQueue* queue = batch_queue_create(session, max_batch, timeout_us);
+    if (!queue) return NULL;
+
+    // View [1, C, H, W] của ảnh đầu tiên, dùng chung data với input
+    Tensor sample = *input;
+    int dims[TENSOR_MAX_RANK];
+    memcpy(dims, input->dims, sizeof(dims));
+    dims[0] = 1;
+    tensor_set_shape(&sample, input->rank, dims);
+
+    pthread_t* threads = (pthread_t*)malloc(n_clients * sizeof(pthread_t));
+    int* started = (int*)calloc(n_clients, sizeof(int));
+    ClientArgs* clients = (ClientArgs*)calloc(n_clients, sizeof(ClientArgs));
+    double start = now_seconds();
+    for (int i = 0; i < n_clients; i++) {
+        clients[i] = (ClientArgs){ queue, &sample, n_requests, NULL };
+        started[i] = (pthread_create(&threads[i], NULL, client_main, &clients[i]) == 0);
+        if (!started[i]) client_main(&clients[i]);
+    }
+    for (int i = 0; i < n_clients; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
     }
-    printf("=========================\n");
+    double elapsed = now_seconds() - start;
+    batch_queue_free(queue);
+    printf("%d clients x %d requests: %.4f seconds (%.1f images/s)\n",
+           n_clients, n_requests, elapsed, n_clients * n_requests / elapsed);
+
+    Tensor* output = clients[0].output;
+    for (int i = 1; i < n_clients; i++) tensor_free(clients[i].output);
+    free(clients);
+    free(started);
+    free(threads);
+    return output;
+}
+
+// --- ASYNC: n_requests REQUEST, TỐI ĐA max_in_flight REQUEST CHẠY CHỒNG NHAU ---
+// Trả về bản copy output của request cuối cùng (caller giải phóng bằng tensor_free)
+static Tensor* run_async(EngineSession* session, const Tensor* input, int n_requests, int max_in_flight) {
+    AsyncSession* async = async_session_create(session, max_in_flight);
+    if (!async) return NULL;
+
+    AsyncRequest** reqs = (AsyncRequest**)calloc(n_requests, sizeof(AsyncRequest*));
+    int oldest = 0;
+    double start = now_seconds();
+    for (int r = 0; r < n_requests; r++) {
+        // Đủ max_in_flight request đang chạy: đợi request cũ nhất rồi submit lại
+        while ((reqs[r] = async_session_submit(async, input)) == NULL) async_request_wait(reqs[oldest++]);
+    }
+    for (int r = oldest; r < n_requests; r++) async_request_wait(reqs[r]);
+    double elapsed = now_seconds() - start;
+    printf("%d async requests (max %d in flight): %.4f seconds (%.1f images/s)\n",
+           n_requests, max_in_flight, elapsed, n_requests * input->dims[0] / elapsed);
+
+    Tensor* last = async_request_wait(reqs[n_requests - 1]);
+    Tensor* output = last ? tensor_clone(last) : NULL;
+    for (int r = 0; r < n_requests; r++) async_request_free(reqs[r]);
+    free(reqs);
+    async_session_free(async);
+    return output;
 }
 
 int main(int argc, char* argv[]) {
     const char* model_path = "model/resnet50-v1-12.onnx";
     const char* input_path = "model/resnet_input_float32.pb";
-    if (argc > 1) model_path = argv[1];
-    if (argc > 2) input_path = argv[2];
+    int n_runs = 1;
+    int batch = 1;
+    int n_clients = 0;          // > 0: chạy qua batch queue thay vì gọi session trực tiếp
+    int max_batch = 8;
+    int batch_timeout_us = 1000;
+    int async_in_flight = 0;    // > 0: chạy n_runs request qua async API
+    // Tham số theo vị trí: [model] [input] [n_runs]; tùy chọn:
+    //   --disable-pass NAME (lặp lại được), --list-passes, --threads N (mặc định: số core),
+    //   --batch N (số ảnh mỗi lần chạy, input có một ảnh thì được nhân bản),
+    //   --clients N (N thread gửi từng ảnh qua dynamic batching, mỗi thread n_runs request),
+    //   --max-batch N (mặc định 8), --batch-timeout US (mặc định 1000 micro giây),
+    //   --async N (submit n_runs request bất đồng bộ, tối đa N request chạy chồng nhau)
+    int n_positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--list-passes") == 0) {
+            graph_pass_list();
+            return 0;
+        }
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            thread_pool_set_size(atoi(argv[++i]));
+            continue;
+        }
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            n_clients = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--max-batch") == 0 && i + 1 < argc) {
+            max_batch = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--batch-timeout") == 0 && i + 1 < argc) {
+            batch_timeout_us = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--async") == 0 && i + 1 < argc) {
+            async_in_flight = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--disable-pass") == 0) {
+            if (i + 1 >= argc || graph_pass_set_enabled(argv[i + 1], 0) != 0) {
+                fprintf(stderr, "Unknown graph pass: %s (see --list-passes)\n", i + 1 < argc ? argv[i + 1] : "");
+                return -1;
+            }
+            i++;
+            continue;
+        }
+        if (n_positional == 0) model_path = argv[i];
+        else if (n_positional == 1) input_path = argv[i];
+        else if (n_positional == 2) n_runs = atoi(argv[i]);
+        n_positional++;
+    }
+    if (n_runs < 1) n_runs = 1;
+    if (batch < 1) batch = 1;
 
     printf("=== Mini ResNet-50 Inference Engine ===\n");
 
@@ -95,26 +260,43 @@ int main(int argc, char* argv[]) {
     Tensor* input = load_tensor_pb(input_path);
     if (!input) {
         printf("Creating Random Input...\n");
-        input = tensor_create(model->graph->input[0]->name, 1, 3, 224, 224);
-        for(int i=0; i<1*3*224*224; i++) input->data[i] = ((float)rand()/RAND_MAX);
+        input = tensor_create(model->graph->input[0]->name, batch, 3, 224, 224);
+        for(int i=0; i<batch*3*224*224; i++) input->data[i] = ((float)rand()/RAND_MAX);
     } else {
         // Override tên input cho khớp model
         if(input->name) free(input->name);
         input->name = strdup(model->graph->input[0]->name);
+        input = repeat_batch(input, batch);
     }
     utils_print_graph(model->graph);
     utils_save_graph_to_file(model->graph, "resnet_structure.txt");
-    // 3. Run Inference
-    printf("Running Inference...\n");
-    clock_t start = clock();
-    
-    // LẤY KẾT QUẢ TẠI ĐÂY
-    Tensor* output = engine_run(model, input);
-    
-    double time_taken = ((double)(clock() - start)) / CLOCKS_PER_SEC;
-    printf("Time: %.4f seconds\n", time_taken);
-
-    // 4. IN KẾT QUẢ
+    // 3. Tạo Session (load weights một lần duy nhất)
+    double start = now_seconds();
+    EngineSession* session = engine_session_create(model);
+    if (!session) { fprintf(stderr, "Create Session Failed\n"); return -1; }
+    printf("Session Ready. Time: %.4f seconds\n", now_seconds() - start);
+
+    // 4. Run Inference (các lần chạy sau chỉ xử lý activations)
+    Tensor* output = NULL;
+    Tensor* owned_output = NULL;    // Output của batch queue / async API thuộc về caller
+    if (n_clients > 0) {
+        printf("Running Inference (%d clients x %d request(s), dynamic batching)...\n", n_clients, n_runs);
+        output = owned_output = run_clients(session, input, n_clients, n_runs, max_batch, batch_timeout_us);
+    } else if (async_in_flight > 0) {
+        printf("Running Inference (%d async request(s), batch %d)...\n", n_runs, batch);
+        output = owned_output = run_async(session, input, n_runs, async_in_flight);
+    } else {
+        printf("Running Inference (%d run(s), batch %d)...\n", n_runs, batch);
+    }
+    for (int r = 0; r < n_runs && n_clients <= 0 && async_in_flight <= 0; r++) {
+        start = now_seconds();
+        // LẤY KẾT QUẢ TẠI ĐÂY
+        output = engine_session_run(session, input);
+        double time_taken = now_seconds() - start;
+        printf("Run %d Time: %.4f seconds (%.1f images/s)\n", r + 1, time_taken, batch / time_taken);
+    }
+
+    // 5. IN KẾT QUẢ
     if (output) {
         print_top5(output);
     } else {
@@ -122,10 +304,10 @@ int main(int argc, char* argv[]) {
     }
 
     // Cleanup
+    // Lưu ý: output của session được giải phóng cùng session, output của batch queue thì không
+    tensor_free(owned_output);
+    engine_session_free(session);
     tensor_free(input);
-    // tensor_free(output); // Lưu ý: output đang nằm trong TensorTable của engine, 
-                            // nếu engine hủy table thì output cũng mất.
-                            // Ở code demo này ta để OS tự dọn dẹp khi exit.
     onnx__model_proto__free_unpacked(model, NULL);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "../include/cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define CPU_HAVE_CPUID 1
+#endif
+
+#ifdef CPU_HAVE_CPUID
+// XCR0: những thanh ghi mà OS lưu/khôi phục khi chuyển context
+static unsigned long long read_xcr0(void) {
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+}
+
+static CpuIsa detect(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return CPU_ISA_GENERIC;
+
+    CpuIsa isa = CPU_ISA_GENERIC;
+    int has_sse42 = (ecx >> 20) & 1;
+    int has_fma = (ecx >> 12) & 1;
+    int has_osxsave = (ecx >> 27) & 1;
+    int has_avx = (ecx >> 28) & 1;
+    if (has_sse42) isa = CPU_ISA_SSE42;
+    if (!has_osxsave || !has_avx) return isa;
+
+    unsigned long long xcr0 = read_xcr0();
+    int os_ymm = (xcr0 & 0x06) == 0x06;    // SSE + AVX state
+    int os_zmm = (xcr0 & 0xe6) == 0xe6;    // + opmask, ZMM_Hi256, Hi16_ZMM
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return isa;
+
+    int has_avx2 = (ebx >> 5) & 1;
+    int has_avx512 = ((ebx >> 16) & 1) &&  // F
+                     ((ebx >> 17) & 1) &&  // DQ
+                     ((ebx >> 30) & 1) &&  // BW
+                     ((ebx >> 31) & 1);    // VL
+    if (has_avx2 && has_fma && os_ymm) isa = CPU_ISA_AVX2;
+    if (isa == CPU_ISA_AVX2 && has_avx512 && os_zmm) isa = CPU_ISA_AVX512;
+    return isa;
+}
+#else
+static CpuIsa detect(void) {
+    return CPU_ISA_GENERIC;
+}
+#endif
+
+CpuIsa cpu_detect_isa(void) {
+    static int cached = -1;
+    if (cached < 0) cached = (int)detect();
+    return (CpuIsa)cached;
+}
+
+const char* cpu_isa_name(CpuIsa isa) {
+    switch (isa) {
+        case CPU_ISA_SSE42:  return "sse42";
+        case CPU_ISA_AVX2:   return "avx2";
+        case CPU_ISA_AVX512: return "avx512";
+        default:             return "generic";
+    }
+}
@@ -6,49 +6,32 @@
 #include "../libs/onnx.pb-c.h"
 #include "../include/tensor.h"
 #include "../include/operators.h"
-
-#define MAX_TENSORS 2000 // ResNet-50 có khoảng ~175 layers + weights
+#include "../include/exec_plan.h"
+#include "../include/op_registry.h"
+#include "../include/memory_planner.h"
+#include "../include/pass_manager.h"
+#include "../include/kernels.h"
+#include "../include/thread_pool.h"
+#include "../include/scheduler.h"
+#include "../include/engine.h"
 
 // ============================================================
-// 1. QUẢN LÝ TENSOR (SYMBOL TABLE)
+// 1. QUẢN LÝ SLOT (CHỈ DÙNG LÚC COMPILE)
 // ============================================================
 
-typedef struct {
-    char* name;
-    Tensor* tensor;
-} NamedTensor;
-
-typedef struct {
-    NamedTensor entries[MAX_TENSORS];
-    int count;
-} TensorTable;
-
-// Tìm Tensor theo tên
-Tensor* get_tensor(TensorTable* table, char* name) {
-    for (int i = 0; i < table->count; i++) {
-        if (strcmp(table->entries[i].name, name) == 0) {
-            return table->entries[i].tensor;
-        }
-    }
-    fprintf(stderr, "[Error] Tensor not found: %s\n", name);
-    exit(1);
-    return NULL;
-}
-
-// Đăng ký Tensor mới vào bảng
-void register_tensor(TensorTable* table, char* name, Tensor* t) {
-    if (table->count >= MAX_TENSORS) {
-        fprintf(stderr, "[Error] Tensor table overflow!\n");
+// Resolve tên input của node thành slot. Tên rỗng = input optional bị bỏ trống.
+static int resolve_input(ExecPlan* plan, const char* name) {
+    if (name == NULL || name[0] == '\0') return -1;
+    int slot = exec_plan_find_slot(plan, name);
+    if (slot < 0) {
+        fprintf(stderr, "[Error] Tensor not found: %s\n", name);
         exit(1);
     }
-    // Copy tên để đảm bảo an toàn bộ nhớ
-    table->entries[table->count].name = strdup(name);
-    table->entries[table->count].tensor = t;
-    table->count++;
+    return slot;
 }
 
 // ============================================================
-// 2. HELPER FUNCTIONS (ATTRIBUTE PARSING)
+// 2. HELPER FUNCTIONS (ATTRIBUTE PARSING - NEW STRUCTS)
 // ============================================================
 
 // Tìm attribute theo tên trong Node
@@ -83,229 +66,259 @@ float get_attr_float(Onnx__NodeProto* node, const char* name, float default_val)
     return (attr) ? (float)attr->f : default_val;
 }
 
-// Tính kích thước output của Conv/Pool
-int calc_out_dim(int input_dim, int kernel, int stride, int pad, int dilation) {
-    // Formula: floor((input + 2*pad - dilation*(kernel-1) - 1) / stride) + 1
-    return (input_dim + 2 * pad - dilation * (kernel - 1) - 1) / stride + 1;
+// Trích xuất toàn bộ attribute cần thiết một lần duy nhất
+static void extract_attrs(Onnx__NodeProto* node, NodeAttrs* a) {
+    a->kernel_shape[0] = a->kernel_shape[1] = 1;
+    a->strides[0] = a->strides[1] = 1;
+    a->pads[0] = a->pads[1] = a->pads[2] = a->pads[3] = 0;
+    a->dilations[0] = a->dilations[1] = 1;
+
+    get_attr_ints(node, "kernel_shape", a->kernel_shape, 2);
+    get_attr_ints(node, "strides", a->strides, 2);
+    get_attr_ints(node, "pads", a->pads, 4);
+    get_attr_ints(node, "dilations", a->dilations, 2);
+    a->group = get_attr_int(node, "group", 1);
+    a->epsilon = get_attr_float(node, "epsilon", 1e-5f);
+    a->alpha = get_attr_float(node, "alpha", 1.0f);
+    a->beta = get_attr_float(node, "beta", 1.0f);
+    a->transA = get_attr_int(node, "transA", 0);
+    a->transB = get_attr_int(node, "transB", 0);
+    a->axis = get_attr_int(node, "axis", 1);
+    Onnx__AttributeProto* axes = find_attr(node, "axes");
+    a->n_axes = axes ? (axes->n_ints < 4 ? (int)axes->n_ints : 4) : 0;
+    get_attr_ints(node, "axes", a->axes, 4);
+    Onnx__AttributeProto* perm = find_attr(node, "perm");
+    a->n_perm = perm ? (perm->n_ints < TENSOR_MAX_RANK ? (int)perm->n_ints : TENSOR_MAX_RANK) : 0;
+    get_attr_ints(node, "perm", a->perm, TENSOR_MAX_RANK);
 }
 
 // ============================================================
 // 3. HÀM CHUYỂN ĐỔI INITIALIZER (WEIGHTS)
 // ============================================================
-void load_initializers(TensorTable* table, Onnx__GraphProto* graph) {
+void load_initializers(ExecPlan* plan, Onnx__GraphProto* graph) {
     printf("Loading %zu initializers...\n", graph->n_initializer);
-    
+
     for (size_t i = 0; i < graph->n_initializer; i++) {
         Onnx__TensorProto* init = graph->initializer[i];
-        
-        // Parse Dimensions
-        int n = 1, c = 1, h = 1, w = 1;
-        if (init->n_dims == 4) {
-            n = init->dims[0]; c = init->dims[1]; h = init->dims[2]; w = init->dims[3];
-        } else if (init->n_dims == 3) {
-            n = 1; c = init->dims[0]; h = init->dims[1]; w = init->dims[2];
-        } else if (init->n_dims == 2) {
-            n = 1; c = 1; h = init->dims[0]; w = init->dims[1];
-        } else if (init->n_dims == 1) {
-            n = 1; c = 1; h = 1; w = init->dims[0];
-        }
-
-        // Tạo Tensor
-        Tensor* t = tensor_create(init->name, n, c, h, w);
 
-        // Copy Data (Handle Raw Data vs Float Data)
-        if (init->has_raw_data) {
-            // ONNX lưu raw data dạng bytes (Little Endian)
-            memcpy(t->data, init->raw_data.data, init->raw_data.len);
-        } else if (init->n_float_data > 0) {
-            for (int j = 0; j < init->n_float_data; j++) {
-                t->data[j] = init->float_data[j];
+        int dims[TENSOR_MAX_RANK];
+        int rank = (init->n_dims < TENSOR_MAX_RANK) ? (int)init->n_dims : TENSOR_MAX_RANK;
+        for (int d = 0; d < rank; d++) dims[d] = (int)init->dims[d];
+
+        Tensor* t;
+        if (init->data_type == ONNX__TENSOR_PROTO__DATA_TYPE__INT64) {
+            // Tensor số nguyên (shape của Reshape, axes...) giữ nguyên kiểu int64
+            t = tensor_create_nd(init->name, rank, dims, TENSOR_INT64);
+            int64_t* dst = (int64_t*)t->data;
+            size_t count = init->has_raw_data ? init->raw_data.len / sizeof(int64_t) : init->n_int64_data;
+            if (count > tensor_numel(t)) count = tensor_numel(t);
+            if (init->has_raw_data) memcpy(dst, init->raw_data.data, count * sizeof(int64_t));
+            else memcpy(dst, init->int64_data, count * sizeof(int64_t));
+        } else {
+            t = tensor_create_nd(init->name, rank, dims, TENSOR_FLOAT32);
+            // Copy Data (Handle Raw Data vs Float Data), ONNX lưu raw data dạng bytes (Little Endian)
+            size_t bytes = tensor_numel(t) * sizeof(float);
+            if (init->has_raw_data) {
+                memcpy(t->data, init->raw_data.data, init->raw_data.len < bytes ? init->raw_data.len : bytes);
+            } else {
+                for (size_t j = 0; j < init->n_float_data && j < tensor_numel(t); j++) {
+                    t->data[j] = init->float_data[j];
+                }
             }
         }
-        
-        register_tensor(table, init->name, t);
+
+        exec_plan_add_slot(plan, init->name, t);
     }
 }
 
 // ============================================================
-// 4. ENGINE CHÍNH (INFERENCE LOOP)
+// 4. COMPILE: GRAPH -> EXECUTION PLAN
 // ============================================================
 
-Tensor* engine_run(Onnx__ModelProto* model, Tensor* input_img) {
-    TensorTable table = {0};
-    Onnx__GraphProto* graph = model->graph;
+// Resolve toàn bộ tên tensor thành slot và trích xuất attributes.
+// Sau bước này vòng lặp chạy không còn thao tác chuỗi nào.
+static int compile_plan(ExecPlan* plan, Onnx__GraphProto* graph) {
+    // Input đầu tiên của graph là ảnh đầu vào
+    plan->input_slot = exec_plan_add_slot(plan, graph->input[0]->name, NULL);
 
-    // B1: Đăng ký Input Image vào bảng (tên input đầu tiên của graph)
-    register_tensor(&table, graph->input[0]->name, input_img);
+    plan->nodes = (ExecNode*)calloc(graph->n_node, sizeof(ExecNode));
+    plan->n_nodes = (int)graph->n_node;
 
-    // B2: Load Weights từ Initializers
-    load_initializers(&table, graph);
-
-    printf("Starting Inference Loop on %zu nodes...\n", graph->n_node);
-
-    // B3: Duyệt tuần tự các layer (Topological Sort đã được ONNX đảm bảo)
+    // Topological Sort đã được ONNX đảm bảo
     for (size_t i = 0; i < graph->n_node; i++) {
         Onnx__NodeProto* node = graph->node[i];
-        char* op = node->op_type;
-        
-        // Debug info
-        // printf("Running Node [%zu]: %s (%s)\n", i, node->name, op);
-
-        // -------------------------------------------------------
-        // CONVOLUTION
-        // -------------------------------------------------------
-        if (strcmp(op, "Conv") == 0) {
-            Tensor* X = get_tensor(&table, node->input[0]);
-            Tensor* W = get_tensor(&table, node->input[1]);
-            Tensor* B = (node->n_input > 2) ? get_tensor(&table, node->input[2]) : NULL;
-
-            // Lấy attributes mặc định
-            int pads[2] = {0, 0};     // pad_h, pad_w (giản lược cho symmetric padding)
-            int strides[2] = {1, 1};  // stride_h, stride_w
-            int dilations[2] = {1, 1};
-            int group = get_attr_int(node, "group", 1);
-            
-            get_attr_ints(node, "pads", pads, 2); 
-            get_attr_ints(node, "strides", strides, 2);
-            get_attr_ints(node, "dilations", dilations, 2);
-            
-            // ONNX pads thường là [h_begin, w_begin, h_end, w_end], ở đây ta lấy h_begin làm chung
-            // Bạn cần xử lý kỹ hơn nếu pad không đối xứng
-            int pad_val = pads[0]; 
-
-            // Tính Output Shape
-            int out_h = calc_out_dim(X->h, W->h, strides[0], pad_val, dilations[0]);
-            int out_w = calc_out_dim(X->w, W->w, strides[1], pad_val, dilations[1]);
-            
-            Tensor* Y = tensor_create(node->output[0], X->n, W->n, out_h, out_w);
-            
-            op_conv2d(X, W, B, Y, strides[0], strides[1], pad_val, pad_val, dilations[0], dilations[1], group);
-            register_tensor(&table, node->output[0], Y);
-        }
-        
-        // -------------------------------------------------------
-        // BATCH NORMALIZATION
-        // -------------------------------------------------------
-        else if (strcmp(op, "BatchNormalization") == 0) {
-            Tensor* X = get_tensor(&table, node->input[0]);
-            Tensor* scale = get_tensor(&table, node->input[1]);
-            Tensor* B = get_tensor(&table, node->input[2]);
-            Tensor* mean = get_tensor(&table, node->input[3]);
-            Tensor* var = get_tensor(&table, node->input[4]);
-            
-            float epsilon = get_attr_float(node, "epsilon", 1e-5f);
-
-            // BN giữ nguyên kích thước
-            Tensor* Y = tensor_create(node->output[0], X->n, X->c, X->h, X->w);
-            
-            op_batch_normalization(X, scale, B, mean, var, Y, epsilon);
-            register_tensor(&table, node->output[0], Y);
+        ExecNode* en = &plan->nodes[i];
+
+        en->kernel = op_registry_find(node->op_type);
+        en->name = node->name;
+        if (en->kernel == NULL) {
+            fprintf(stderr, "[Error] Unsupported Operator: %s\n", node->op_type);
+            return -1;
         }
+        extract_attrs(node, &en->attrs);
 
-        // -------------------------------------------------------
-        // RELU
-        // -------------------------------------------------------
-        else if (strcmp(op, "Relu") == 0) {
-            Tensor* X = get_tensor(&table, node->input[0]);
-            Tensor* Y = tensor_create(node->output[0], X->n, X->c, X->h, X->w);
-            op_relu(X, Y);
-            register_tensor(&table, node->output[0], Y);
+        en->n_inputs = (node->n_input < MAX_NODE_IO) ? (int)node->n_input : MAX_NODE_IO;
+        for (int j = 0; j < en->n_inputs; j++) {
+            en->inputs[j] = resolve_input(plan, node->input[j]);
         }
 
-        // -------------------------------------------------------
-        // ADD
-        // -------------------------------------------------------
-        else if (strcmp(op, "Add") == 0) {
-            Tensor* A = get_tensor(&table, node->input[0]);
-            Tensor* B = get_tensor(&table, node->input[1]);
-            Tensor* Y = tensor_create(node->output[0], A->n, A->c, A->h, A->w);
-            op_add(A, B, Y);
-            register_tensor(&table, node->output[0], Y);
+        // Mỗi output là một slot activation mới, Tensor được cấp phát khi chạy
+        en->n_outputs = (node->n_output < MAX_NODE_IO) ? (int)node->n_output : MAX_NODE_IO;
+        for (int j = 0; j < en->n_outputs; j++) {
+            Tensor* t = (Tensor*)calloc(1, sizeof(Tensor));
+            t->name = strdup(node->output[j]);
+            en->outputs[j] = exec_plan_add_slot(plan, node->output[j], t);
         }
+    }
 
-        // -------------------------------------------------------
-        // MAX POOL
-        // -------------------------------------------------------
-        else if (strcmp(op, "MaxPool") == 0) {
-            Tensor* X = get_tensor(&table, node->input[0]);
-            
-            int kernel_shape[2] = {1, 1};
-            int strides[2] = {1, 1};
-            int pads[2] = {0, 0};
-            
-            get_attr_ints(node, "kernel_shape", kernel_shape, 2);
-            get_attr_ints(node, "strides", strides, 2);
-            get_attr_ints(node, "pads", pads, 2); // Lấy giá trị đầu
-
-            int out_h = calc_out_dim(X->h, kernel_shape[0], strides[0], pads[0], 1);
-            int out_w = calc_out_dim(X->w, kernel_shape[1], strides[1], pads[0], 1);
-
-            Tensor* Y = tensor_create(node->output[0], X->n, X->c, out_h, out_w);
-            op_maxpool(X, Y, kernel_shape[0], kernel_shape[1], strides[0], strides[1], pads[0], pads[0]);
-            register_tensor(&table, node->output[0], Y);
+    // Lấy tên output của graph (Thường là 'resnetv17_dense0_fwd' hoặc 'softmax_output')
+    const char* output_name = graph->output[0]->name;
+    plan->output_slot = resolve_input(plan, output_name);
+
+    printf("[Engine] Compiled %d nodes, %d tensor slots. Final Output Tensor: %s\n",
+           plan->n_nodes, plan->n_slots, output_name);
+    return 0;
+}
+
+// Chèn copy cho view có stride, cấp slot scratch rồi gọi prepare của từng op một lần duy nhất
+// (pack weights, chọn thuật toán...)
+static int prepare_plan(ExecPlan* plan) {
+    exec_plan_add_contiguous_copies(plan);
+    exec_plan_add_scratch_slots(plan);
+    for (int i = 0; i < plan->n_nodes; i++) {
+        ExecNode* node = &plan->nodes[i];
+        node->kernels = plan->kernels;
+        if (node->kernel->prepare && node->kernel->prepare(node, plan->slots) != 0) {
+            fprintf(stderr, "[Error] Prepare failed at node %s (%s)\n", node->name, node->kernel->op_type);
+            return -1;
         }
+    }
+    return 0;
+}
+
+// ============================================================
+// 5. SESSION (LOAD WEIGHTS + COMPILE MỘT LẦN)
+// ============================================================
+
+struct EngineSession {
+    Onnx__ModelProto* model;
+    ExecPlan plan;
+    RunContext* default_ctx;    // Workspace của engine_session_run
+};
+
+EngineSession* engine_session_create(Onnx__ModelProto* model) {
+    return engine_session_create_isa(model, cpu_detect_isa());
+}
 
-        // -------------------------------------------------------
-        // GLOBAL AVERAGE POOL
-        // -------------------------------------------------------
-        else if (strcmp(op, "GlobalAveragePool") == 0) {
-            Tensor* X = get_tensor(&table, node->input[0]);
-            // Output shape: [N, C, 1, 1]
-            Tensor* Y = tensor_create(node->output[0], X->n, X->c, 1, 1);
-            op_global_average_pool(X, Y);
-            register_tensor(&table, node->output[0], Y);
+EngineSession* engine_session_create_isa(Onnx__ModelProto* model, CpuIsa max_isa) {
+    EngineSession* session = (EngineSession*)calloc(1, sizeof(EngineSession));
+    session->model = model;
+
+    // Chọn bản kernel theo tập lệnh của CPU đang chạy (trước layout pass và prepare);
+    // bảng thuộc về plan nên session tạo sau không đổi kernel của session này
+    const KernelTable* kt = kernels_select(max_isa);
+    session->plan.kernels = kt;
+    printf("[Engine] CPU ISA: %s, kernels: %s\n", cpu_isa_name(cpu_detect_isa()), kt->name);
+    printf("[Engine] Threads: %d\n", thread_pool_size());
+
+    load_initializers(&session->plan, model->graph);
+    session->plan.n_weights = session->plan.n_slots;
+    if (compile_plan(&session->plan, model->graph) != 0 ||
+        graph_passes_run(&session->plan) != 0 ||
+        prepare_plan(&session->plan) != 0) {
+        engine_session_free(session);
+        return NULL;
+    }
+
+    // Nhiều thread: các node độc lập chạy song song theo DAG phụ thuộc dữ liệu (trước memory planner)
+    if (thread_pool_size() > 1) {
+        NodeDag* dag = node_dag_build(&session->plan);
+        if (dag) {
+            printf("[Engine] DAG scheduler: %d nodes, %d edges, %d roots, critical path %d nodes\n",
+                   dag->n_nodes, dag->n_edges, dag->n_roots, dag->depth);
         }
+        session->plan.dag = dag;
+    }
+    session->default_ctx = exec_plan_context_create(&session->plan);
+    return session;
+}
 
-        // -------------------------------------------------------
-        // FLATTEN
-        // -------------------------------------------------------
-        else if (strcmp(op, "Flatten") == 0) {
-            Tensor* X = get_tensor(&table, node->input[0]);
-            // Reshape [N, C, H, W] -> [N, C*H*W, 1, 1]
-            int flatten_dim = X->c * X->h * X->w;
-            Tensor* Y = tensor_create(node->output[0], X->n, flatten_dim, 1, 1);
-            op_flatten(X, Y);
-            register_tensor(&table, node->output[0], Y);
+void engine_session_free(EngineSession* session) {
+    if (!session) return;
+    ExecPlan* plan = &session->plan;
+    exec_plan_context_free(session->default_ctx);
+    for (int i = 0; i < plan->n_slots; i++) {
+        // Slot input thuộc về caller, tensor mẫu của activations không có data
+        if (i != plan->input_slot) tensor_free(plan->slots[i]);
+        free(plan->slot_names[i]);
+    }
+    node_dag_free(plan->dag);
+    for (int i = 0; i < plan->n_nodes; i++) {
+        ExecNode* node = &plan->nodes[i];
+        if (node->kernel && node->kernel->release) node->kernel->release(node);
+    }
+    free(plan->slots);
+    free(plan->slot_names);
+    free(plan->nodes);
+    free(session);
+}
+
+// Chạy infer_shape cho toàn bộ graph rồi lập kế hoạch bộ nhớ cho activations của ctx.
+// Chỉ gọi khi shape input thay đổi, arena được giữ lại giữa các lần chạy.
+static int infer_shapes(const ExecPlan* plan, RunContext* ctx) {
+    for (int i = 0; i < plan->n_nodes; i++) {
+        ExecNode* node = &plan->nodes[i];
+        if (node->kernel->infer_shape(node, ctx->slots) != 0) {
+            fprintf(stderr, "[Error] Shape inference failed at node %s (%s)\n", node->name, node->kernel->op_type);
+            return -1;
         }
+    }
+    return memory_plan_activations(plan, ctx);
+}
 
-        // -------------------------------------------------------
-        // GEMM (Fully Connected)
-        // -------------------------------------------------------
-        else if (strcmp(op, "Gemm") == 0) {
-            Tensor* A = get_tensor(&table, node->input[0]); // Input Vector
-            Tensor* B = get_tensor(&table, node->input[1]); // Weights
-            Tensor* C = (node->n_input > 2) ? get_tensor(&table, node->input[2]) : NULL; // Bias
-
-            float alpha = get_attr_float(node, "alpha", 1.0f);
-            float beta = get_attr_float(node, "beta", 1.0f);
-            int transA = get_attr_int(node, "transA", 0);
-            int transB = get_attr_int(node, "transB", 0); // Thường là 1 cho FC layer
-
-            // Xác định Output Features
-            // Nếu B là [Out, In] và transB=1 -> output feature là B->dims[0] (hoặc B->n nếu lưu dạng 4D)
-            // Trong logic load_initializers, B->n=1, B->c=1, B->h=Rows, B->w=Cols (giả định 2D)
-            int out_features = (transB) ? B->h : B->w; 
-
-            Tensor* Y = tensor_create(node->output[0], A->n, 1, 1, out_features);
-            // Lưu ý: Hack shape output về dạng 4D [N, 1, 1, Out] để tương thích struct Tensor
-            // Thực tế Gemm trả về 2D [N, Out]
-            
-            op_gemm(A, B, C, Y, alpha, beta, transA, transB);
-            register_tensor(&table, node->output[0], Y);
+RunContext* engine_context_create(const EngineSession* session) {
+    return exec_plan_context_create(&session->plan);
+}
+
+void engine_context_free(RunContext* ctx) {
+    exec_plan_context_free(ctx);
+}
+
+// ============================================================
+// 6. ENGINE CHÍNH (INFERENCE LOOP)
+// ============================================================
+
+Tensor* engine_session_run(EngineSession* session, Tensor* input_img) {
+    return engine_session_run_context(session, session->default_ctx, input_img);
+}
+
+Tensor* engine_session_run_context(const EngineSession* session, RunContext* ctx, Tensor* input_img) {
+    const ExecPlan* plan = &session->plan;
+    Tensor** slots = ctx->slots;
+
+    // B1: Gắn Input Image vào slot input
+    slots[plan->input_slot] = input_img;
+
+    // B2: Shape chỉ được tính lại khi shape input khác lần chạy trước trên ctx này
+    if (ctx->input_rank != input_img->rank ||
+        memcmp(ctx->input_dims, input_img->dims, input_img->rank * sizeof(int)) != 0) {
+        if (infer_shapes(plan, ctx) != 0) {
+            ctx->input_rank = -1;
+            return NULL;
         }
-        else {
-            printf("[Warning] Unsupported Operator: %s\n", op);
+        ctx->input_rank = input_img->rank;
+        memcpy(ctx->input_dims, input_img->dims, input_img->rank * sizeof(int));
+    }
+
+    // B3: Chạy các node theo DAG (nhiều thread) hoặc tuần tự, dispatch qua con trỏ hàm đã resolve sẵn
+    if (plan->dag) {
+        node_dag_run(plan->dag, plan, ctx);
+    } else {
+        for (int i = 0; i < plan->n_nodes; i++) {
+            ExecNode* node = &plan->nodes[i];
+            node->kernel->compute(node, slots);
         }
     }
-    
-    // Kết thúc: Có thể lấy output cuối cùng ở đây để trả về
-    // Tensor* final_out = get_tensor(&table, graph->output[0]->name);
-    // Lấy tên output node cuối cùng của graph (Thường là 'resnetv17_dense0_fwd' hoặc 'softmax_output')
-    char* output_name = graph->output[0]->name;
-    
-    // Lấy Tensor kết quả từ bảng
-    Tensor* final_out = get_tensor(&table, output_name);
-    
-    // Trả về con trỏ (Lưu ý: Logic này chưa free table để đơn giản hóa)
-    return final_out;
-}
\ No newline at end of file
+
+    return slots[plan->output_slot];
+}
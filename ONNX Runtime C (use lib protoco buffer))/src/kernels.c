@@ -0,0 +1,20 @@
+#include <stddef.h>
+
+#include "../include/cpu_features.h"
+#include "../include/kernels.h"
+
+// File này được biên dịch cho baseline: nó chỉ chọn bảng, không chạy kernel nào
+
+static const KernelTable* const kernel_tables[CPU_ISA_COUNT] = {
+    [CPU_ISA_GENERIC] = &kernel_table_generic,
+    [CPU_ISA_SSE42]   = &kernel_table_sse42,
+    [CPU_ISA_AVX2]    = &kernel_table_avx2,
+    [CPU_ISA_AVX512]  = &kernel_table_avx512,
+};
+
+const KernelTable* kernels_select(CpuIsa max_isa) {
+    CpuIsa isa = cpu_detect_isa();
+    if (max_isa < isa) isa = max_isa;
+    if (isa < CPU_ISA_GENERIC) isa = CPU_ISA_GENERIC;
+    return kernel_tables[isa];
+}
@@ -0,0 +1,497 @@
+// File này được biên dịch nhiều lần, mỗi lần cho một tập lệnh (xem KERNEL_VARIANTS trong Makefile):
+//   -DKERNEL_ISA=<tên> cùng cờ -m tương ứng, mỗi bản xuất kernel_table_<tên>.
+// Mọi hàm đều static nên các bản không xung đột khi link chung.
+// Các vòng lặp phụ (sum, axpy) viết bằng C thuần để compiler tự vectorize theo độ rộng của từng ISA;
+// GEMM/GEMV và các vòng element-wise chính dùng intrinsics khi tập lệnh có sẵn.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../include/kernels.h"
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#ifndef KERNEL_ISA
+#error "KERNEL_ISA must be defined (generic, sse42, avx2, avx512)"
+#endif
+
+#define KERNEL_CONCAT_(a, b) a##b
+#define KERNEL_CONCAT(a, b) KERNEL_CONCAT_(a, b)
+#define KERNEL_STR_(x) #x
+#define KERNEL_STR(x) KERNEL_STR_(x)
+
+// Mức ISA của bản này suy ra từ chính cờ biên dịch
+#if defined(__AVX512F__)
+#define KERNEL_ISA_ID CPU_ISA_AVX512
+#define KERNEL_LANES 16
+#elif defined(__AVX2__) && defined(__FMA__)
+#define KERNEL_ISA_ID CPU_ISA_AVX2
+#define KERNEL_LANES 8
+#elif defined(__SSE4_2__)
+#define KERNEL_ISA_ID CPU_ISA_SSE42
+#define KERNEL_LANES 4
+#else
+#define KERNEL_ISA_ID CPU_ISA_GENERIC
+#define KERNEL_LANES 4
+#endif
+
+// ============================================================
+// 1. MICRO-KERNEL GEMM (MR x NR, tile C nằm trong thanh ghi)
+// ============================================================
+
+#if !defined(__AVX512F__)
+// Epilogue cho hàng i của tile, đã nằm trong c[0 : nr]
+static void epilogue_row(const GemmEpilogue* ep, int i, float* c, int nr) {
+    if (ep->bias) {
+        for (int j = 0; j < nr; j++) c[j] += ep->bias[i];
+    }
+    if (ep->scale) {
+        for (int j = 0; j < nr; j++) c[j] = c[j] * ep->scale[i] + ep->shift[i];
+    }
+    if (ep->residual) {
+        const float* r = ep->residual + (size_t)i * ep->ldr;
+        for (int j = 0; j < nr; j++) c[j] += r[j];
+    }
+    if (ep->relu) {
+        for (int j = 0; j < nr; j++) c[j] = (c[j] > 0.0f) ? c[j] : 0.0f;
+    }
+}
+
+// Ghi tile tạm (tile không đủ MR x NR hoặc kernel portable) vào C
+static void store_tile(const float tile[GEMM_MR][GEMM_NR], float* C, int ldc,
+                       int mr, int nr, float alpha, float beta, const GemmEpilogue* ep) {
+    for (int i = 0; i < mr; i++) {
+        float* c = C + (size_t)i * ldc;
+        if (beta == 0.0f) {
+            for (int j = 0; j < nr; j++) c[j] = alpha * tile[i][j];
+        } else {
+            for (int j = 0; j < nr; j++) c[j] = alpha * tile[i][j] + beta * c[j];
+        }
+        if (ep) epilogue_row(ep, i, c, nr);
+    }
+}
+#endif
+
+#if defined(__AVX512F__)
+// --- AVX-512 ---
+// Mỗi hàng tile 16 float = 1 thanh ghi zmm. Hai bước k xen kẽ vào 2 bộ accumulator
+// (12 zmm) để che độ trễ FMA; tile thiếu được ghi bằng mask, không cần tile tạm.
+static void gemm_micro(int kc, const float* a, const float* b,
+                       float* C, int ldc, int mr, int nr,
+                       float alpha, float beta, const GemmEpilogue* ep) {
+    __m512 c0 = _mm512_setzero_ps(), c1 = _mm512_setzero_ps(), c2 = _mm512_setzero_ps();
+    __m512 c3 = _mm512_setzero_ps(), c4 = _mm512_setzero_ps(), c5 = _mm512_setzero_ps();
+    __m512 d0 = _mm512_setzero_ps(), d1 = _mm512_setzero_ps(), d2 = _mm512_setzero_ps();
+    __m512 d3 = _mm512_setzero_ps(), d4 = _mm512_setzero_ps(), d5 = _mm512_setzero_ps();
+
+    int p = 0;
+    for (; p + 1 < kc; p += 2) {
+        __m512 b0 = _mm512_load_ps(b);
+        __m512 b1 = _mm512_load_ps(b + GEMM_NR);
+        c0 = _mm512_fmadd_ps(_mm512_set1_ps(a[0]), b0, c0);
+        c1 = _mm512_fmadd_ps(_mm512_set1_ps(a[1]), b0, c1);
+        c2 = _mm512_fmadd_ps(_mm512_set1_ps(a[2]), b0, c2);
+        c3 = _mm512_fmadd_ps(_mm512_set1_ps(a[3]), b0, c3);
+        c4 = _mm512_fmadd_ps(_mm512_set1_ps(a[4]), b0, c4);
+        c5 = _mm512_fmadd_ps(_mm512_set1_ps(a[5]), b0, c5);
+        d0 = _mm512_fmadd_ps(_mm512_set1_ps(a[6]), b1, d0);
+        d1 = _mm512_fmadd_ps(_mm512_set1_ps(a[7]), b1, d1);
+        d2 = _mm512_fmadd_ps(_mm512_set1_ps(a[8]), b1, d2);
+        d3 = _mm512_fmadd_ps(_mm512_set1_ps(a[9]), b1, d3);
+        d4 = _mm512_fmadd_ps(_mm512_set1_ps(a[10]), b1, d4);
+        d5 = _mm512_fmadd_ps(_mm512_set1_ps(a[11]), b1, d5);
+        a += 2 * GEMM_MR;
+        b += 2 * GEMM_NR;
+    }
+    if (p < kc) {
+        __m512 b0 = _mm512_load_ps(b);
+        c0 = _mm512_fmadd_ps(_mm512_set1_ps(a[0]), b0, c0);
+        c1 = _mm512_fmadd_ps(_mm512_set1_ps(a[1]), b0, c1);
+        c2 = _mm512_fmadd_ps(_mm512_set1_ps(a[2]), b0, c2);
+        c3 = _mm512_fmadd_ps(_mm512_set1_ps(a[3]), b0, c3);
+        c4 = _mm512_fmadd_ps(_mm512_set1_ps(a[4]), b0, c4);
+        c5 = _mm512_fmadd_ps(_mm512_set1_ps(a[5]), b0, c5);
+    }
+
+    __m512 acc[GEMM_MR] = {
+        _mm512_add_ps(c0, d0), _mm512_add_ps(c1, d1), _mm512_add_ps(c2, d2),
+        _mm512_add_ps(c3, d3), _mm512_add_ps(c4, d4), _mm512_add_ps(c5, d5)
+    };
+
+    __mmask16 mask = (nr >= GEMM_NR) ? (__mmask16)0xFFFF : (__mmask16)((1u << nr) - 1);
+    __m512 va = _mm512_set1_ps(alpha), vb = _mm512_set1_ps(beta);
+    for (int i = 0; i < mr; i++) {
+        float* c = C + (size_t)i * ldc;
+        __m512 r = _mm512_mul_ps(va, acc[i]);
+        if (beta != 0.0f) r = _mm512_fmadd_ps(vb, _mm512_maskz_loadu_ps(mask, c), r);
+        if (ep) {
+            if (ep->bias) r = _mm512_add_ps(r, _mm512_set1_ps(ep->bias[i]));
+            if (ep->scale) r = _mm512_fmadd_ps(r, _mm512_set1_ps(ep->scale[i]), _mm512_set1_ps(ep->shift[i]));
+            if (ep->residual) r = _mm512_add_ps(r, _mm512_maskz_loadu_ps(mask, ep->residual + (size_t)i * ep->ldr));
+            if (ep->relu) r = _mm512_max_ps(r, _mm512_setzero_ps());
+        }
+        _mm512_mask_storeu_ps(c, mask, r);
+    }
+}
+
+#elif defined(__AVX2__) && defined(__FMA__)
+// --- AVX2 + FMA ---
+// Toàn bộ tile 6 x 16 = 12 thanh ghi ymm; mỗi bước k: 2 lần nạp B, 6 broadcast A, 12 FMA.
+static void gemm_micro(int kc, const float* a, const float* b,
+                       float* C, int ldc, int mr, int nr,
+                       float alpha, float beta, const GemmEpilogue* ep) {
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+    for (int p = 0; p < kc; p++) {
+        __m256 b0 = _mm256_load_ps(b);
+        __m256 b1 = _mm256_load_ps(b + 8);
+        __m256 av;
+        av = _mm256_broadcast_ss(a + 0); c00 = _mm256_fmadd_ps(av, b0, c00); c01 = _mm256_fmadd_ps(av, b1, c01);
+        av = _mm256_broadcast_ss(a + 1); c10 = _mm256_fmadd_ps(av, b0, c10); c11 = _mm256_fmadd_ps(av, b1, c11);
+        av = _mm256_broadcast_ss(a + 2); c20 = _mm256_fmadd_ps(av, b0, c20); c21 = _mm256_fmadd_ps(av, b1, c21);
+        av = _mm256_broadcast_ss(a + 3); c30 = _mm256_fmadd_ps(av, b0, c30); c31 = _mm256_fmadd_ps(av, b1, c31);
+        av = _mm256_broadcast_ss(a + 4); c40 = _mm256_fmadd_ps(av, b0, c40); c41 = _mm256_fmadd_ps(av, b1, c41);
+        av = _mm256_broadcast_ss(a + 5); c50 = _mm256_fmadd_ps(av, b0, c50); c51 = _mm256_fmadd_ps(av, b1, c51);
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    __m256 acc[GEMM_MR][2] = {
+        { c00, c01 }, { c10, c11 }, { c20, c21 }, { c30, c31 }, { c40, c41 }, { c50, c51 }
+    };
+
+    if (mr == GEMM_MR && nr == GEMM_NR) {
+        // Tile đầy đủ: ghi thẳng bằng vector
+        __m256 va = _mm256_set1_ps(alpha), vb = _mm256_set1_ps(beta);
+        for (int i = 0; i < GEMM_MR; i++) {
+            float* c = C + (size_t)i * ldc;
+            for (int h = 0; h < 2; h++) {
+                __m256 r = _mm256_mul_ps(va, acc[i][h]);
+                if (beta != 0.0f) r = _mm256_fmadd_ps(vb, _mm256_loadu_ps(c + h * 8), r);
+                if (ep) {
+                    if (ep->bias) r = _mm256_add_ps(r, _mm256_set1_ps(ep->bias[i]));
+                    if (ep->scale) r = _mm256_fmadd_ps(r, _mm256_set1_ps(ep->scale[i]), _mm256_set1_ps(ep->shift[i]));
+                    if (ep->residual) r = _mm256_add_ps(r, _mm256_loadu_ps(ep->residual + (size_t)i * ep->ldr + h * 8));
+                    if (ep->relu) r = _mm256_max_ps(r, _mm256_setzero_ps());
+                }
+                _mm256_storeu_ps(c + h * 8, r);
+            }
+        }
+        return;
+    }
+
+    float tile[GEMM_MR][GEMM_NR] __attribute__((aligned(32)));
+    for (int i = 0; i < GEMM_MR; i++) {
+        _mm256_store_ps(&tile[i][0], acc[i][0]);
+        _mm256_store_ps(&tile[i][8], acc[i][1]);
+    }
+    store_tile((const float (*)[GEMM_NR])tile, C, ldc, mr, nr, alpha, beta, ep);
+}
+
+#else
+// --- Portable ---
+// Vector 4 float (SSE trên x86, NEON trên ARM) bằng vector extension của GCC.
+// Tile 6 x 16 được tính thành 2 nửa 6 x 8 để 12 accumulator vừa đủ 16 thanh ghi vector.
+typedef float v4f __attribute__((vector_size(16)));
+
+static void gemm_micro(int kc, const float* a, const float* b,
+                       float* C, int ldc, int mr, int nr,
+                       float alpha, float beta, const GemmEpilogue* ep) {
+    float tile[GEMM_MR][GEMM_NR] __attribute__((aligned(16)));
+
+    for (int half = 0; half < GEMM_NR; half += 8) {
+        v4f c00 = {0}, c01 = {0}, c10 = {0}, c11 = {0}, c20 = {0}, c21 = {0};
+        v4f c30 = {0}, c31 = {0}, c40 = {0}, c41 = {0}, c50 = {0}, c51 = {0};
+        const float* pa = a;
+        const float* pb = b + half;
+
+        for (int p = 0; p < kc; p++) {
+            v4f b0 = *(const v4f*)(pb);
+            v4f b1 = *(const v4f*)(pb + 4);
+            c00 += pa[0] * b0; c01 += pa[0] * b1;
+            c10 += pa[1] * b0; c11 += pa[1] * b1;
+            c20 += pa[2] * b0; c21 += pa[2] * b1;
+            c30 += pa[3] * b0; c31 += pa[3] * b1;
+            c40 += pa[4] * b0; c41 += pa[4] * b1;
+            c50 += pa[5] * b0; c51 += pa[5] * b1;
+            pa += GEMM_MR;
+            pb += GEMM_NR;
+        }
+
+        *(v4f*)&tile[0][half] = c00; *(v4f*)&tile[0][half + 4] = c01;
+        *(v4f*)&tile[1][half] = c10; *(v4f*)&tile[1][half + 4] = c11;
+        *(v4f*)&tile[2][half] = c20; *(v4f*)&tile[2][half + 4] = c21;
+        *(v4f*)&tile[3][half] = c30; *(v4f*)&tile[3][half + 4] = c31;
+        *(v4f*)&tile[4][half] = c40; *(v4f*)&tile[4][half + 4] = c41;
+        *(v4f*)&tile[5][half] = c50; *(v4f*)&tile[5][half + 4] = c51;
+    }
+
+    store_tile((const float (*)[GEMM_NR])tile, C, ldc, mr, nr, alpha, beta, ep);
+}
+#endif
+
+// ============================================================
+// 2. GEMV PANEL (BATCH 1)
+// ============================================================
+// out[0 : GEMV_NR] = x[K] * panel[K, GEMV_NR]; panel được đọc tuần tự đúng một lần.
+// Bài toán bị giới hạn bởi băng thông nên chỉ cần đủ accumulator độc lập để
+// che độ trễ cộng/FMA (nhiều bước k xen kẽ).
+
+#if defined(__AVX512F__)
+static void gemv_panel(int K, const float* x, const float* panel, float* out) {
+    __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps();
+    __m512 a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+    int p = 0;
+    for (; p + 3 < K; p += 4) {
+        const float* q = panel + (size_t)p * GEMV_NR;
+        a0 = _mm512_fmadd_ps(_mm512_set1_ps(x[p]), _mm512_load_ps(q), a0);
+        a1 = _mm512_fmadd_ps(_mm512_set1_ps(x[p + 1]), _mm512_load_ps(q + 16), a1);
+        a2 = _mm512_fmadd_ps(_mm512_set1_ps(x[p + 2]), _mm512_load_ps(q + 32), a2);
+        a3 = _mm512_fmadd_ps(_mm512_set1_ps(x[p + 3]), _mm512_load_ps(q + 48), a3);
+    }
+    for (; p < K; p++) {
+        a0 = _mm512_fmadd_ps(_mm512_set1_ps(x[p]), _mm512_load_ps(panel + (size_t)p * GEMV_NR), a0);
+    }
+    _mm512_storeu_ps(out, _mm512_add_ps(_mm512_add_ps(a0, a1), _mm512_add_ps(a2, a3)));
+}
+
+#elif defined(__AVX2__) && defined(__FMA__)
+static void gemv_panel(int K, const float* x, const float* panel, float* out) {
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+    __m256 b0 = _mm256_setzero_ps(), b1 = _mm256_setzero_ps();
+    int p = 0;
+    for (; p + 1 < K; p += 2) {
+        const float* q = panel + (size_t)p * GEMV_NR;
+        __m256 xa = _mm256_broadcast_ss(x + p);
+        __m256 xb = _mm256_broadcast_ss(x + p + 1);
+        a0 = _mm256_fmadd_ps(xa, _mm256_load_ps(q), a0);
+        a1 = _mm256_fmadd_ps(xa, _mm256_load_ps(q + 8), a1);
+        b0 = _mm256_fmadd_ps(xb, _mm256_load_ps(q + 16), b0);
+        b1 = _mm256_fmadd_ps(xb, _mm256_load_ps(q + 24), b1);
+    }
+    if (p < K) {
+        const float* q = panel + (size_t)p * GEMV_NR;
+        __m256 xa = _mm256_broadcast_ss(x + p);
+        a0 = _mm256_fmadd_ps(xa, _mm256_load_ps(q), a0);
+        a1 = _mm256_fmadd_ps(xa, _mm256_load_ps(q + 8), a1);
+    }
+    _mm256_storeu_ps(out, _mm256_add_ps(a0, b0));
+    _mm256_storeu_ps(out + 8, _mm256_add_ps(a1, b1));
+}
+
+#else
+static void gemv_panel(int K, const float* x, const float* panel, float* out) {
+    v4f a0 = {0}, a1 = {0}, a2 = {0}, a3 = {0};
+    v4f b0 = {0}, b1 = {0}, b2 = {0}, b3 = {0};
+    int p = 0;
+    for (; p + 1 < K; p += 2) {
+        const float* q = panel + (size_t)p * GEMV_NR;
+        a0 += x[p] * *(const v4f*)(q);      a1 += x[p] * *(const v4f*)(q + 4);
+        a2 += x[p] * *(const v4f*)(q + 8);  a3 += x[p] * *(const v4f*)(q + 12);
+        b0 += x[p + 1] * *(const v4f*)(q + 16); b1 += x[p + 1] * *(const v4f*)(q + 20);
+        b2 += x[p + 1] * *(const v4f*)(q + 24); b3 += x[p + 1] * *(const v4f*)(q + 28);
+    }
+    if (p < K) {
+        const float* q = panel + (size_t)p * GEMV_NR;
+        a0 += x[p] * *(const v4f*)(q);      a1 += x[p] * *(const v4f*)(q + 4);
+        a2 += x[p] * *(const v4f*)(q + 8);  a3 += x[p] * *(const v4f*)(q + 12);
+    }
+    *(v4f*)(out) = a0 + b0;     *(v4f*)(out + 4) = a1 + b1;
+    *(v4f*)(out + 8) = a2 + b2; *(v4f*)(out + 12) = a3 + b3;
+}
+#endif
+
+// ============================================================
+// 3. ELEMENT-WISE
+// ============================================================
+// Relu / Add / scale-shift (BatchNorm) chỉ đọc-ghi mỗi phần tử một lần nên bị giới hạn bởi
+// băng thông: thân vòng lặp ghi y bằng store căn lề (đầu được tách riêng tới khi y căn lề),
+// phần đuôi dùng mask (AVX-512) hoặc scalar. y được phép trùng x / a / b (chạy in-place)
+// vì mỗi phần tử chỉ phụ thuộc chính vị trí đó.
+
+// Số phần tử đầu cần xử lý riêng để y + head căn lề `align` byte
+static size_t head_to_align(const float* y, size_t align, size_t n) {
+    size_t head = ((align - ((uintptr_t)y & (align - 1))) & (align - 1)) / sizeof(float);
+    return (head < n) ? head : n;
+}
+
+#if defined(__AVX512F__)
+static __mmask16 tail_mask(size_t n) {
+    return (__mmask16)((1u << n) - 1);
+}
+
+static void relu(const float* x, float* y, size_t n) {
+    __m512 zero = _mm512_setzero_ps();
+    size_t i = head_to_align(y, 64, n);
+    if (i > 0) {
+        __mmask16 m = tail_mask(i);
+        _mm512_mask_storeu_ps(y, m, _mm512_max_ps(_mm512_maskz_loadu_ps(m, x), zero));
+    }
+    for (; i + 16 <= n; i += 16) {
+        _mm512_store_ps(y + i, _mm512_max_ps(_mm512_loadu_ps(x + i), zero));
+    }
+    if (i < n) {
+        __mmask16 m = tail_mask(n - i);
+        _mm512_mask_storeu_ps(y + i, m, _mm512_max_ps(_mm512_maskz_loadu_ps(m, x + i), zero));
+    }
+}
+
+static void add(const float* a, const float* b, float* y, size_t n) {
+    size_t i = head_to_align(y, 64, n);
+    if (i > 0) {
+        __mmask16 m = tail_mask(i);
+        _mm512_mask_storeu_ps(y, m, _mm512_add_ps(_mm512_maskz_loadu_ps(m, a), _mm512_maskz_loadu_ps(m, b)));
+    }
+    for (; i + 16 <= n; i += 16) {
+        _mm512_store_ps(y + i, _mm512_add_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+    }
+    if (i < n) {
+        __mmask16 m = tail_mask(n - i);
+        _mm512_mask_storeu_ps(y + i, m, _mm512_add_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i)));
+    }
+}
+
+static void scale_shift(const float* x, float scale, float shift, float* y, size_t n) {
+    __m512 s = _mm512_set1_ps(scale), t = _mm512_set1_ps(shift);
+    size_t i = head_to_align(y, 64, n);
+    if (i > 0) {
+        __mmask16 m = tail_mask(i);
+        _mm512_mask_storeu_ps(y, m, _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, x), s, t));
+    }
+    for (; i + 16 <= n; i += 16) {
+        _mm512_store_ps(y + i, _mm512_fmadd_ps(_mm512_loadu_ps(x + i), s, t));
+    }
+    if (i < n) {
+        __mmask16 m = tail_mask(n - i);
+        _mm512_mask_storeu_ps(y + i, m, _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, x + i), s, t));
+    }
+}
+
+#elif defined(__AVX2__) && defined(__FMA__)
+static void relu(const float* x, float* y, size_t n) {
+    __m256 zero = _mm256_setzero_ps();
+    size_t i = 0, head = head_to_align(y, 32, n);
+    for (; i < head; i++) y[i] = (x[i] > 0.0f) ? x[i] : 0.0f;
+    for (; i + 16 <= n; i += 16) {
+        _mm256_store_ps(y + i, _mm256_max_ps(_mm256_loadu_ps(x + i), zero));
+        _mm256_store_ps(y + i + 8, _mm256_max_ps(_mm256_loadu_ps(x + i + 8), zero));
+    }
+    for (; i + 8 <= n; i += 8) {
+        _mm256_store_ps(y + i, _mm256_max_ps(_mm256_loadu_ps(x + i), zero));
+    }
+    for (; i < n; i++) y[i] = (x[i] > 0.0f) ? x[i] : 0.0f;
+}
+
+static void add(const float* a, const float* b, float* y, size_t n) {
+    size_t i = 0, head = head_to_align(y, 32, n);
+    for (; i < head; i++) y[i] = a[i] + b[i];
+    for (; i + 16 <= n; i += 16) {
+        _mm256_store_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        _mm256_store_ps(y + i + 8, _mm256_add_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+    for (; i + 8 <= n; i += 8) {
+        _mm256_store_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    for (; i < n; i++) y[i] = a[i] + b[i];
+}
+
+static void scale_shift(const float* x, float scale, float shift, float* y, size_t n) {
+    __m256 s = _mm256_set1_ps(scale), t = _mm256_set1_ps(shift);
+    size_t i = 0, head = head_to_align(y, 32, n);
+    for (; i < head; i++) y[i] = x[i] * scale + shift;
+    for (; i + 16 <= n; i += 16) {
+        _mm256_store_ps(y + i, _mm256_fmadd_ps(_mm256_loadu_ps(x + i), s, t));
+        _mm256_store_ps(y + i + 8, _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), s, t));
+    }
+    for (; i + 8 <= n; i += 8) {
+        _mm256_store_ps(y + i, _mm256_fmadd_ps(_mm256_loadu_ps(x + i), s, t));
+    }
+    for (; i < n; i++) y[i] = x[i] * scale + shift;
+}
+
+#else
+// v4f căn lề 4 byte: dùng để đọc input không căn lề
+typedef float v4f_u __attribute__((vector_size(16), aligned(4)));
+typedef int v4i __attribute__((vector_size(16)));
+
+// Phép so sánh vector cho mask toàn bit 1 ở làn x > 0: AND với mask giữ x, còn lại thành 0
+static v4f relu_v4(v4f v) {
+    const v4f zero = {0};
+    return (v4f)((v4i)v & (v4i)(v > zero));
+}
+
+static void relu(const float* x, float* y, size_t n) {
+    size_t i = 0, head = head_to_align(y, 16, n);
+    for (; i < head; i++) y[i] = (x[i] > 0.0f) ? x[i] : 0.0f;
+    for (; i + 8 <= n; i += 8) {
+        *(v4f*)(y + i) = relu_v4(*(const v4f_u*)(x + i));
+        *(v4f*)(y + i + 4) = relu_v4(*(const v4f_u*)(x + i + 4));
+    }
+    for (; i < n; i++) y[i] = (x[i] > 0.0f) ? x[i] : 0.0f;
+}
+
+static void add(const float* a, const float* b, float* y, size_t n) {
+    size_t i = 0, head = head_to_align(y, 16, n);
+    for (; i < head; i++) y[i] = a[i] + b[i];
+    for (; i + 8 <= n; i += 8) {
+        *(v4f*)(y + i) = *(const v4f_u*)(a + i) + *(const v4f_u*)(b + i);
+        *(v4f*)(y + i + 4) = *(const v4f_u*)(a + i + 4) + *(const v4f_u*)(b + i + 4);
+    }
+    for (; i < n; i++) y[i] = a[i] + b[i];
+}
+
+static void scale_shift(const float* x, float scale, float shift, float* y, size_t n) {
+    size_t i = 0, head = head_to_align(y, 16, n);
+    for (; i < head; i++) y[i] = x[i] * scale + shift;
+    for (; i + 8 <= n; i += 8) {
+        *(v4f*)(y + i) = *(const v4f_u*)(x + i) * scale + shift;
+        *(v4f*)(y + i + 4) = *(const v4f_u*)(x + i + 4) * scale + shift;
+    }
+    for (; i < n; i++) y[i] = x[i] * scale + shift;
+}
+#endif
+
+// Cộng dồn vào KERNEL_LANES * 2 tổng riêng (compiler không được tự đổi thứ tự phép cộng float)
+static float sum(const float* x, size_t n) {
+    float acc[2 * KERNEL_LANES] = {0};
+    size_t i = 0;
+    for (; i + 2 * KERNEL_LANES <= n; i += 2 * KERNEL_LANES) {
+        for (int j = 0; j < 2 * KERNEL_LANES; j++) acc[j] += x[i + j];
+    }
+    float s = 0.0f;
+    for (int j = 0; j < 2 * KERNEL_LANES; j++) s += acc[j];
+    for (; i < n; i++) s += x[i];
+    return s;
+}
+
+static void axpy(float* restrict y, const float* restrict x, float a, int n) {
+    for (int i = 0; i < n; i++) y[i] += a * x[i];
+}
+
+static void axpy_strided(float* restrict y, const float* restrict x, float a, int n, int stride) {
+    for (int i = 0; i < n; i++) y[i] += a * x[i * stride];
+}
+
+// ============================================================
+// 4. BẢNG KERNEL CỦA BẢN NÀY
+// ============================================================
+
+const KernelTable KERNEL_CONCAT(kernel_table_, KERNEL_ISA) = {
+    .isa = KERNEL_ISA_ID,
+    .name = KERNEL_STR(KERNEL_ISA),
+    .gemm_micro = gemm_micro,
+    .gemv_panel = gemv_panel,
+    .relu = relu,
+    .add = add,
+    .scale_shift = scale_shift,
+    .sum = sum,
+    .axpy = axpy,
+    .axpy_strided = axpy_strided,
+};
@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/tensor.h"
+#include "../include/exec_plan.h"
+#include "../include/op_registry.h"
+#include "../include/memory_planner.h"
+#include "../include/scheduler.h"
+
+// ============================================================
+// 1. GÁN OFFSET (GREEDY BY SIZE, BEST-FIT)
+// ============================================================
+
+static size_t align_up(size_t v, size_t a) {
+    return (v + a - 1) / a * a;
+}
+
+static int lifetimes_overlap(const BufferRequest* a, const BufferRequest* b) {
+    return a->first_use <= b->last_use && b->first_use <= a->last_use;
+}
+
+// Mọi node dùng a đã xong trước khi node ghi b bắt đầu (output của graph sống tới khi caller đọc)
+static int dag_finished_before(const NodeDag* dag, const BufferRequest* a, const BufferRequest* b) {
+    return a->last_use < dag->n_nodes && node_dag_all_precede(dag, a->users, b->first_use);
+}
+
+static int buffers_conflict(const BufferRequest* a, const BufferRequest* b, const NodeDag* dag) {
+    if (!dag) return lifetimes_overlap(a, b);
+    // Request bị bỏ trống (in-place / view) không chiếm chỗ và không có users
+    if (a->size == 0 || b->size == 0) return 0;
+    return !dag_finished_before(dag, a, b) && !dag_finished_before(dag, b, a);
+}
+
+size_t memory_plan_offsets(BufferRequest* reqs, int n, const NodeDag* dag) {
+    // Duyệt buffer từ lớn đến nhỏ (sắp xếp gián tiếp qua mảng chỉ số)
+    int* order = (int*)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) order[i] = i;
+    for (int i = 1; i < n; i++) {
+        int key = order[i], j = i - 1;
+        while (j >= 0 && reqs[order[j]].size < reqs[key].size) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = key;
+    }
+
+    int* placed = (int*)malloc(n * sizeof(int)); // Các buffer đã đặt, sắp theo offset
+    int n_placed = 0;
+    size_t peak = 0;
+
+    for (int k = 0; k < n; k++) {
+        BufferRequest* r = &reqs[order[k]];
+
+        // Tìm khe hở nhỏ nhất (best-fit) giữa các buffer có lifetime giao với r
+        size_t best_offset = 0, best_gap = (size_t)-1;
+        int found = 0;
+        size_t cursor = 0;
+        for (int p = 0; p < n_placed; p++) {
+            BufferRequest* o = &reqs[placed[p]];
+            if (!buffers_conflict(r, o, dag)) continue;
+            if (o->offset >= cursor) {
+                size_t gap = o->offset - cursor;
+                if (gap >= r->size && gap < best_gap) {
+                    best_gap = gap;
+                    best_offset = cursor;
+                    found = 1;
+                }
+            }
+            if (o->offset + o->size > cursor) cursor = o->offset + o->size;
+        }
+        r->offset = found ? best_offset : cursor;
+        if (r->offset + r->size > peak) peak = r->offset + r->size;
+
+        // Chèn vào danh sách placed, giữ thứ tự tăng dần theo offset
+        int pos = n_placed;
+        while (pos > 0 && reqs[placed[pos - 1]].offset > r->offset) {
+            placed[pos] = placed[pos - 1];
+            pos--;
+        }
+        placed[pos] = order[k];
+        n_placed++;
+    }
+
+    free(placed);
+    free(order);
+    return peak;
+}
+
+// ============================================================
+// 2. LIVENESS + ARENA CHO ACTIVATIONS
+// ============================================================
+
+// Chạy theo DAG, node i chỉ được ghi đè buffer r nếu mọi node đọc r trước đó (theo chỉ số) chắc chắn
+// đã chạy xong: chỉ số nhỏ hơn không có nghĩa là chạy trước khi hai node nằm trên hai nhánh song song
+static int readers_precede(const ExecPlan* plan, const int* req_of_slot, int first, int r, int i) {
+    for (int j = 0; j < i; j++) {
+        const ExecNode* node = &plan->nodes[j];
+        for (int k = 0; k < node->n_inputs; k++) {
+            int s = node->inputs[k];
+            if (s >= first && req_of_slot[s] == r && !node_dag_precedes(plan->dag, j, i)) return 0;
+        }
+    }
+    return 1;
+}
+
+int memory_plan_activations(const ExecPlan* plan, RunContext* ctx) {
+    // Activations là các slot sau input (weights ở [0, n_weights), input do caller giữ)
+    int first = plan->n_weights;
+    int n_slots = plan->n_slots;
+    int* req_of_slot = (int*)malloc(n_slots * sizeof(int));
+    for (int i = 0; i < n_slots; i++) req_of_slot[i] = -1;
+
+    BufferRequest* reqs = (BufferRequest*)calloc(n_slots + plan->n_nodes, sizeof(BufferRequest));
+    int n_reqs = 0;
+    size_t naive_bytes = 0;
+
+    // Node sinh ra tensor -> first_use
+    for (int i = 0; i < plan->n_nodes; i++) {
+        const ExecNode* node = &plan->nodes[i];
+        for (int j = 0; j < node->n_outputs; j++) {
+            int s = node->outputs[j];
+            Tensor* t = ctx->slots[s];
+            size_t bytes = tensor_storage_size(t) * sizeof(float);
+            naive_bytes += bytes;
+            reqs[n_reqs].size = align_up(bytes, ARENA_ALIGNMENT);
+            reqs[n_reqs].first_use = i;
+            reqs[n_reqs].last_use = i;
+            req_of_slot[s] = n_reqs++;
+        }
+    }
+
+    // Node cuối cùng đọc tensor -> last_use
+    for (int i = 0; i < plan->n_nodes; i++) {
+        const ExecNode* node = &plan->nodes[i];
+        for (int j = 0; j < node->n_inputs; j++) {
+            int s = node->inputs[j];
+            if (s < first || req_of_slot[s] < 0) continue;
+            if (reqs[req_of_slot[s]].last_use < i) reqs[req_of_slot[s]].last_use = i;
+        }
+    }
+
+    // Output của graph phải sống tới khi caller đọc xong
+    if (req_of_slot[plan->output_slot] >= 0) {
+        reqs[req_of_slot[plan->output_slot]].last_use = plan->n_nodes;
+    }
+
+    // In-place: output của op element-wise dùng lại buffer của một input chết ngay tại node đó.
+    // Duyệt theo thứ tự node nên chuỗi BN -> Relu -> Add... có thể dùng chung một buffer;
+    // request của output bị bỏ trống (size 0), request của input được kéo dài tới hết output.
+    // View (Flatten, Reshape...): output luôn dùng chung buffer với input 0 dù input còn được
+    // đọc sau đó (không ai ghi đè), lifetime của buffer là hợp của hai tensor. Input không nằm
+    // trong arena (input của graph, weight) thì output không có request nào.
+    int n_inplace = 0, n_views = 0;
+    for (int i = 0; i < plan->n_nodes; i++) {
+        const ExecNode* node = &plan->nodes[i];
+        if (node->n_outputs < 1) continue;
+        int out = node->outputs[0];
+        BufferRequest* r_out = &reqs[req_of_slot[out]];
+
+        if (node->kernel->flags & OP_FLAG_VIEW) {
+            int s = node->inputs[0];
+            int r = (s >= first) ? req_of_slot[s] : -1;
+            if (r >= 0 && reqs[r].last_use < r_out->last_use) reqs[r].last_use = r_out->last_use;
+            r_out->size = 0;
+            req_of_slot[out] = r;
+            n_views++;
+            continue;
+        }
+        if (!(node->kernel->flags & OP_FLAG_INPLACE)) continue;
+
+        // Input là view có stride: ghi output dense vào buffer đó sẽ đè lên phần tử chưa đọc
+        int dense = 1;
+        for (int j = 0; j < node->n_inputs; j++) {
+            if (node->inputs[j] >= 0 && !tensor_is_contiguous(ctx->slots[node->inputs[j]])) dense = 0;
+        }
+        if (!dense) continue;
+
+        for (int j = 0; j < node->n_inputs; j++) {
+            int s = node->inputs[j];
+            if (s < first || req_of_slot[s] < 0) continue;
+            BufferRequest* r_in = &reqs[req_of_slot[s]];
+            if (r_in->last_use != i || r_in->size < r_out->size) continue;
+            if (plan->dag && !readers_precede(plan, req_of_slot, first, req_of_slot[s], i)) continue;
+
+            r_in->last_use = r_out->last_use;
+            r_out->size = 0;
+            req_of_slot[out] = req_of_slot[s];
+            n_inplace++;
+            break;
+        }
+    }
+
+    // Scratch của node chỉ sống trong lúc node chạy
+    int first_scratch = n_reqs;
+    for (int i = 0; i < plan->n_nodes; i++) {
+        int s = plan->nodes[i].scratch_slot;
+        if (s < 0) continue;
+        size_t bytes = tensor_storage_size(ctx->slots[s]) * sizeof(float);
+        if (bytes == 0) continue;
+        naive_bytes += bytes;
+        reqs[n_reqs].size = align_up(bytes, ARENA_ALIGNMENT);
+        reqs[n_reqs].first_use = i;
+        reqs[n_reqs].last_use = i;
+        req_of_slot[s] = n_reqs++;
+    }
+
+    // Chạy theo DAG: users của mỗi request là mọi node đọc / ghi các slot nằm trong request đó
+    uint64_t* users = NULL;
+    if (plan->dag) {
+        int words = plan->dag->words;
+        users = (uint64_t*)calloc((size_t)n_reqs * words + 1, sizeof(uint64_t));
+        for (int r = 0; r < n_reqs; r++) reqs[r].users = users + (size_t)r * words;
+        for (int i = 0; i < plan->n_nodes; i++) {
+            const ExecNode* node = &plan->nodes[i];
+            uint64_t bit = 1ULL << (i & 63);
+            for (int j = 0; j < node->n_inputs; j++) {
+                int s = node->inputs[j];
+                if (s >= first && req_of_slot[s] >= 0) users[(size_t)req_of_slot[s] * words + (i >> 6)] |= bit;
+            }
+            for (int j = 0; j < node->n_outputs; j++) {
+                int s = node->outputs[j];
+                if (req_of_slot[s] >= 0) users[(size_t)req_of_slot[s] * words + (i >> 6)] |= bit;
+            }
+            int s = node->scratch_slot;
+            if (s >= 0 && req_of_slot[s] >= 0) users[(size_t)req_of_slot[s] * words + (i >> 6)] |= bit;
+        }
+    }
+
+    size_t arena_bytes = memory_plan_offsets(reqs, n_reqs, plan->dag);
+    free(users);
+
+    if (arena_bytes > ctx->arena_bytes) {
+        free(ctx->arena);
+        ctx->arena = (float*)aligned_alloc(ARENA_ALIGNMENT, align_up(arena_bytes, ARENA_ALIGNMENT));
+        if (!ctx->arena) {
+            fprintf(stderr, "[Error] Cannot allocate activation arena (%zu bytes)\n", arena_bytes);
+            ctx->arena_bytes = 0;
+            free(reqs);
+            free(req_of_slot);
+            return -1;
+        }
+        ctx->arena_bytes = arena_bytes;
+    }
+
+    // Activation và scratch (kể cả view / in-place dùng chung request) trỏ vào arena của context
+    for (int s = 0; s < n_slots; s++) {
+        if (req_of_slot[s] < 0) continue;
+        ctx->slots[s]->data = (float*)((char*)ctx->arena + reqs[req_of_slot[s]].offset);
+    }
+
+    // Chỉ in lần lập kế hoạch đầu tiên của context: batch / shape thay đổi sẽ lập lại nhiều lần
+    if (ctx->n_plans++ == 0) {
+        printf("[Planner] %d activations (%d in-place, %d views, +%d scratch): naive %.2f MB -> arena %.2f MB%s\n",
+               first_scratch, n_inplace, n_views, n_reqs - first_scratch,
+               naive_bytes / (1024.0 * 1024.0), arena_bytes / (1024.0 * 1024.0),
+               plan->dag ? " (DAG-safe)" : "");
+    }
+
+    free(reqs);
+    free(req_of_slot);
+    return 0;
+}
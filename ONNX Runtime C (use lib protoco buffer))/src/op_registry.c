@@ -0,0 +1,804 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../include/tensor.h"
+#include "../include/operators.h"
+#include "../include/gemm.h"
+#include "../include/exec_plan.h"
+#include "../include/op_registry.h"
+#include "../include/nchwc.h"
+
+#define MAX_REGISTERED_OPS 64
+
+// ============================================================
+// 1. HELPER FUNCTIONS
+// ============================================================
+
+// Input thứ i của node, NULL nếu input optional bị bỏ trống
+static Tensor* node_input(ExecNode* node, Tensor** slots, int i) {
+    if (i >= node->n_inputs || node->inputs[i] < 0) return NULL;
+    return slots[node->inputs[i]];
+}
+
+static Tensor* node_output(ExecNode* node, Tensor** slots, int i) {
+    return slots[node->outputs[i]];
+}
+
+static void set_shape(Tensor* t, int n, int c, int h, int w) {
+    int dims[4] = { n, c, h, w };
+    tensor_set_shape(t, 4, dims);
+}
+
+static int calc_out_dim(int input_dim, int kernel, int stride, int pad_begin, int pad_end, int dilation) {
+    // Formula: floor((input + pad_begin + pad_end - dilation*(kernel-1) - 1) / stride) + 1
+    return (input_dim + pad_begin + pad_end - dilation * (kernel - 1) - 1) / stride + 1;
+}
+
+// BatchNorm gộp thành y = x * scale + shift cho channels channel
+static void bn_fold(const Tensor* gamma, const Tensor* beta, const Tensor* mean, const Tensor* var,
+                    float epsilon, int channels, float* scale, float* shift) {
+    for (int c = 0; c < channels; c++) {
+        float factor = gamma->data[c] / sqrtf(var->data[c] + epsilon);
+        scale[c] = factor;
+        shift[c] = beta->data[c] - mean->data[c] * factor;
+    }
+}
+
+// Shape giữ nguyên (Relu, BatchNormalization...)
+static int infer_same_shape(ExecNode* node, Tensor** slots) {
+    Tensor* X = node_input(node, slots, 0);
+    tensor_set_shape(node_output(node, slots, 0), X->rank, X->dims);
+    return 0;
+}
+
+// ============================================================
+// 2. CONVOLUTION
+// ============================================================
+
+// Thuật toán Conv được chọn một lần lúc prepare
+typedef enum {
+    CONV_ALGO_DIRECT = 0,   // Vòng lặp trực tiếp (tham chiếu, hỗ trợ mọi group)
+    CONV_ALGO_IM2COL_GEMM,  // im2col + SGEMM cache-blocked (mỗi group một GEMM)
+    CONV_ALGO_DEPTHWISE,    // group = C_in = C_out: kernel riêng theo từng channel
+    CONV_ALGO_POINTWISE,    // 1x1, pad 0: GEMM trực tiếp trên ảnh NCHW
+    CONV_ALGO_WINOGRAD      // 3x3 stride 1: Winograd F(4x4, 3x3)
+} ConvAlgo;
+
+typedef struct {
+    ConvAlgo algo;
+    float* winograd_U;      // Filter đã transform [36, C_out, C_in], tính một lần lúc prepare
+    float* bn_scale;        // BatchNorm đã fuse (xem node->fused): [scale | shift], NULL nếu không có
+} ConvState;
+
+// Gộp BatchNorm đã fuse vào node thành scale/shift, mỗi mảng padded phần tử (đệm 0)
+static float* conv_fused_bn(ExecNode* node, Tensor** slots, int channels, int padded) {
+    int i = node->fused.bn_input;
+    if (i == 0) return NULL;
+    float* st = (float*)calloc(2 * padded, sizeof(float));
+    bn_fold(node_input(node, slots, i), node_input(node, slots, i + 1),
+            node_input(node, slots, i + 2), node_input(node, slots, i + 3),
+            node->fused.bn_epsilon, channels, st, st + padded);
+    return st;
+}
+
+// Epilogue của node Conv lúc chạy, NULL nếu không có gì được fuse
+static const ConvEpilogue* conv_epilogue(ExecNode* node, Tensor** slots, const float* bn, int padded,
+                                         ConvEpilogue* ep) {
+    const FusedEpilogue* f = &node->fused;
+    if (f->bn_input == 0 && f->residual_input == 0 && !f->relu) return NULL;
+    ep->scale = bn;
+    ep->shift = bn ? bn + padded : NULL;
+    ep->residual = f->residual_input ? node_input(node, slots, f->residual_input) : NULL;
+    ep->relu = f->relu;
+    return ep;
+}
+
+// Sai số tương đối tối đa (so với kernel trực tiếp) để chấp nhận Winograd cho một layer
+#define WINOGRAD_TOLERANCE 1e-4f
+
+// Chạy layer trên input ngẫu nhiên bằng cả Winograd và kernel trực tiếp rồi so sánh.
+// Trả về max|Y_wino - Y_direct| / max|Y_direct|
+static float conv_winograd_error(ExecNode* node, Tensor* W, Tensor* B, const float* U) {
+    const NodeAttrs* a = &node->attrs;
+    // Kích thước không chia hết cho 4 để kiểm tra cả tile bị cắt ở biên
+    int in_h = 9, in_w = 11;
+    int out_h = calc_out_dim(in_h, 3, 1, a->pads[0], a->pads[2], 1);
+    int out_w = calc_out_dim(in_w, 3, 1, a->pads[1], a->pads[3], 1);
+
+    Tensor* X = tensor_create("winograd_check_x", 1, W->c, in_h, in_w);
+    Tensor* Y_ref = tensor_create("winograd_check_ref", 1, W->n, out_h, out_w);
+    Tensor* Y = tensor_create("winograd_check_y", 1, W->n, out_h, out_w);
+    float* scratch = (float*)malloc(op_conv2d_winograd_scratch(W->c, W->n, out_h, out_w) * sizeof(float));
+
+    unsigned int seed = 12345u;
+    size_t n_in = (size_t)W->c * in_h * in_w;
+    for (size_t i = 0; i < n_in; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        X->data[i] = (float)(seed >> 8) / (float)(1u << 24) * 2.0f - 1.0f;
+    }
+
+    op_conv2d(X, W, B, Y_ref, 1, 1, a->pads[0], a->pads[1], 1, 1, 1, NULL);
+    op_conv2d_winograd(node->kernels, X, U, B, Y, a->pads[0], a->pads[1], scratch, NULL);
+
+    float max_ref = 0.0f, max_diff = 0.0f;
+    size_t n_out = (size_t)W->n * out_h * out_w;
+    for (size_t i = 0; i < n_out; i++) {
+        float r = fabsf(Y_ref->data[i]);
+        float d = fabsf(Y->data[i] - Y_ref->data[i]);
+        if (r > max_ref) max_ref = r;
+        if (d > max_diff) max_diff = d;
+    }
+
+    free(scratch);
+    tensor_free(X);
+    tensor_free(Y_ref);
+    tensor_free(Y);
+    return (max_ref > 0.0f) ? max_diff / max_ref : max_diff;
+}
+
+static int conv_prepare(ExecNode* node, Tensor** slots) {
+    const NodeAttrs* a = &node->attrs;
+    Tensor* W = node_input(node, slots, 1);
+    Tensor* B = node_input(node, slots, 2);
+    ConvState* st = (ConvState*)calloc(1, sizeof(ConvState));
+
+    int no_pad = (a->pads[0] == 0 && a->pads[1] == 0 && a->pads[2] == 0 && a->pads[3] == 0);
+    int winograd_ok = (W->h == 3 && W->w == 3 &&
+                       a->strides[0] == 1 && a->strides[1] == 1 &&
+                       a->dilations[0] == 1 && a->dilations[1] == 1);
+
+    if (a->group != 1) {
+        // W: [C_out, C_in / group, kH, kW] -> depthwise khi mỗi group có đúng 1 channel vào và 1 ra
+        st->algo = (W->c == 1 && W->n == a->group) ? CONV_ALGO_DEPTHWISE : CONV_ALGO_IM2COL_GEMM;
+    } else if (W->h == 1 && W->w == 1 && no_pad) {
+        st->algo = CONV_ALGO_POINTWISE;
+    } else if (winograd_ok) {
+        st->winograd_U = (float*)malloc((size_t)WINOGRAD_ALPHA * WINOGRAD_ALPHA * W->n * W->c * sizeof(float));
+        op_winograd_transform_filter(W, st->winograd_U);
+
+        float err = conv_winograd_error(node, W, B, st->winograd_U);
+        if (err <= WINOGRAD_TOLERANCE) {
+            st->algo = CONV_ALGO_WINOGRAD;
+        } else {
+            printf("[Conv] %s: Winograd rejected (rel error %.2e), using im2col\n", node->name, err);
+            free(st->winograd_U);
+            st->winograd_U = NULL;
+            st->algo = CONV_ALGO_IM2COL_GEMM;
+        }
+    } else {
+        st->algo = CONV_ALGO_IM2COL_GEMM;
+    }
+    st->bn_scale = conv_fused_bn(node, slots, W->n, W->n);
+    node->state = st;
+    return 0;
+}
+
+static void conv_release(ExecNode* node) {
+    ConvState* st = (ConvState*)node->state;
+    if (st) {
+        free(st->winograd_U);
+        free(st->bn_scale);
+    }
+    free(st);
+    node->state = NULL;
+}
+
+// Kiểm tra channel/group và tính shape output (dùng chung cho mọi layout)
+static int conv_output_shape(ExecNode* node, Tensor** slots) {
+    const NodeAttrs* a = &node->attrs;
+    Tensor* X = node_input(node, slots, 0);
+    Tensor* W = node_input(node, slots, 1);
+
+    if (X->c != W->c * a->group) {
+        fprintf(stderr, "[Error] Conv %s: input has %d channels, weight expects %d\n",
+                node->name, X->c, W->c * a->group);
+        return -1;
+    }
+    if (W->n % a->group != 0) {
+        fprintf(stderr, "[Error] Conv %s: %d output channels not divisible by group %d\n",
+                node->name, W->n, a->group);
+        return -1;
+    }
+
+    int out_h = calc_out_dim(X->h, W->h, a->strides[0], a->pads[0], a->pads[2], a->dilations[0]);
+    int out_w = calc_out_dim(X->w, W->w, a->strides[1], a->pads[1], a->pads[3], a->dilations[1]);
+    set_shape(node_output(node, slots, 0), X->n, W->n, out_h, out_w);
+
+    // Residual đã fuse được cộng theo từng phần tử: phải cùng shape với output
+    if (node->fused.residual_input) {
+        Tensor* R = node_input(node, slots, node->fused.residual_input);
+        if (R->n != X->n || R->c != W->n || R->h != out_h || R->w != out_w) {
+            fprintf(stderr, "[Error] Conv %s: fused residual shape mismatch (broadcast not supported)\n",
+                    node->name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int conv_infer_shape(ExecNode* node, Tensor** slots) {
+    if (conv_output_shape(node, slots) != 0) return -1;
+    Tensor* W = node_input(node, slots, 1);
+    Tensor* Y = node_output(node, slots, 0);
+    int out_h = Y->h, out_w = Y->w;
+
+    // Scratch là một tensor 1 chiều trong slot riêng của node, được cấp trong arena như activation
+    const ConvState* st = (const ConvState*)node->state;
+    int scratch = 0;
+    if (st->algo == CONV_ALGO_IM2COL_GEMM) {
+        scratch = W->c * W->h * W->w * out_h * out_w;
+    } else if (st->algo == CONV_ALGO_WINOGRAD) {
+        scratch = (int)op_conv2d_winograd_scratch(W->c, W->n, out_h, out_w);
+    }
+    tensor_set_shape(slots[node->scratch_slot], 1, &scratch);
+    return 0;
+}
+
+static void conv_compute(ExecNode* node, Tensor** slots) {
+    const NodeAttrs* a = &node->attrs;
+    const ConvState* st = (const ConvState*)node->state;
+    Tensor* X = node_input(node, slots, 0);
+    Tensor* W = node_input(node, slots, 1);
+    Tensor* B = node_input(node, slots, 2);
+    Tensor* Y = node_output(node, slots, 0);
+    // Kernel chỉ cần pad đầu (trên, trái); pad cuối đã nằm trong shape output
+    int pad_h = a->pads[0], pad_w = a->pads[1];
+    float* scratch = slots[node->scratch_slot]->data;
+    ConvEpilogue ep_buf;
+    const ConvEpilogue* ep = conv_epilogue(node, slots, st->bn_scale, W->n, &ep_buf);
+
+    if (st->algo == CONV_ALGO_WINOGRAD) {
+        op_conv2d_winograd(node->kernels, X, st->winograd_U, B, Y, pad_h, pad_w, scratch, ep);
+    } else if (st->algo == CONV_ALGO_POINTWISE) {
+        op_conv2d_1x1(node->kernels, X, W, B, Y, a->strides[0], a->strides[1], ep);
+    } else if (st->algo == CONV_ALGO_DEPTHWISE) {
+        op_conv2d_depthwise(node->kernels, X, W, B, Y, a->strides[0], a->strides[1], pad_h, pad_w,
+                            a->dilations[0], a->dilations[1], ep);
+    } else if (st->algo == CONV_ALGO_IM2COL_GEMM) {
+        op_conv2d_im2col(node->kernels, X, W, B, Y, a->strides[0], a->strides[1], pad_h, pad_w,
+                         a->dilations[0], a->dilations[1], a->group, scratch, ep);
+    } else {
+        op_conv2d(X, W, B, Y, a->strides[0], a->strides[1], pad_h, pad_w,
+                  a->dilations[0], a->dilations[1], a->group, ep);
+    }
+}
+
+// ============================================================
+// 3. ELEMENT-WISE: BATCHNORM, RELU, ADD
+// ============================================================
+
+static void batchnorm_compute(ExecNode* node, Tensor** slots) {
+    op_batch_normalization(node->kernels, node_input(node, slots, 0), node_input(node, slots, 1),
+                           node_input(node, slots, 2), node_input(node, slots, 3),
+                           node_input(node, slots, 4), node_output(node, slots, 0),
+                           node->attrs.epsilon);
+}
+
+static void relu_compute(ExecNode* node, Tensor** slots) {
+    op_relu(node->kernels, node_input(node, slots, 0), node_output(node, slots, 0));
+}
+
+static int same_shape(const Tensor* a, const Tensor* b) {
+    if (a->rank != b->rank) return 0;
+    for (int i = 0; i < a->rank; i++) {
+        if (a->dims[i] != b->dims[i]) return 0;
+    }
+    return 1;
+}
+
+// Output có shape broadcast chung của A và B
+static int add_infer_shape(ExecNode* node, Tensor** slots) {
+    int dims[TENSOR_MAX_RANK];
+    int rank = tensor_broadcast_shape(node_input(node, slots, 0), node_input(node, slots, 1), dims);
+    if (rank < 0) {
+        fprintf(stderr, "[Error] Add %s: shapes cannot be broadcast\n", node->name);
+        return -1;
+    }
+    tensor_set_shape(node_output(node, slots, 0), rank, dims);
+    return 0;
+}
+
+static void add_compute(ExecNode* node, Tensor** slots) {
+    Tensor* A = node_input(node, slots, 0);
+    Tensor* B = node_input(node, slots, 1);
+    // Đường liên tục chỉ khi cả hai input là dense cùng shape; view có stride đi qua đường broadcast
+    if (same_shape(A, B) && tensor_is_contiguous(A) && tensor_is_contiguous(B)) {
+        op_add(node->kernels, A, B, node_output(node, slots, 0));
+    } else {
+        op_add_broadcast(A, B, node_output(node, slots, 0));
+    }
+}
+
+// ============================================================
+// 4. POOLING
+// ============================================================
+
+static int maxpool_infer_shape(ExecNode* node, Tensor** slots) {
+    const NodeAttrs* a = &node->attrs;
+    Tensor* X = node_input(node, slots, 0);
+    int out_h = calc_out_dim(X->h, a->kernel_shape[0], a->strides[0], a->pads[0], a->pads[2], 1);
+    int out_w = calc_out_dim(X->w, a->kernel_shape[1], a->strides[1], a->pads[1], a->pads[3], 1);
+    set_shape(node_output(node, slots, 0), X->n, X->c, out_h, out_w);
+    return 0;
+}
+
+static void maxpool_compute(ExecNode* node, Tensor** slots) {
+    const NodeAttrs* a = &node->attrs;
+    op_maxpool(node_input(node, slots, 0), node_output(node, slots, 0),
+               a->kernel_shape[0], a->kernel_shape[1], a->strides[0], a->strides[1],
+               a->pads[0], a->pads[1]);
+}
+
+static int global_avgpool_infer_shape(ExecNode* node, Tensor** slots) {
+    Tensor* X = node_input(node, slots, 0);
+    set_shape(node_output(node, slots, 0), X->n, X->c, 1, 1);
+    return 0;
+}
+
+static void global_avgpool_compute(ExecNode* node, Tensor** slots) {
+    op_global_average_pool(node->kernels, node_input(node, slots, 0), node_output(node, slots, 0));
+}
+
+// ============================================================
+// 5. SHAPE OPS (VIEW): FLATTEN, RESHAPE, SQUEEZE, UNSQUEEZE, TRANSPOSE, IDENTITY
+// ============================================================
+// Output là view của input 0 (OP_FLAG_VIEW): không có buffer riêng, compute chỉ gán con trỏ data.
+
+static int view_set_shape(ExecNode* node, Tensor** slots, const int* dims, int rank) {
+    Tensor* X = node_input(node, slots, 0);
+    size_t numel = 1;
+    for (int i = 0; i < rank; i++) numel *= (size_t)dims[i];
+    if (numel != tensor_numel(X)) {
+        fprintf(stderr, "[Error] %s %s: element count mismatch\n", node->kernel->op_type, node->name);
+        return -1;
+    }
+    tensor_set_shape(node_output(node, slots, 0), rank, dims);
+    return 0;
+}
+
+static void view_compute(ExecNode* node, Tensor** slots) {
+    node_output(node, slots, 0)->data = node_input(node, slots, 0)->data;
+}
+
+// [d0 * ... * d(axis-1), d(axis) * ... * d(r-1)]
+static int flatten_infer_shape(ExecNode* node, Tensor** slots) {
+    Tensor* X = node_input(node, slots, 0);
+    int axis = node->attrs.axis < 0 ? node->attrs.axis + X->rank : node->attrs.axis;
+    if (axis < 0 || axis > X->rank) {
+        fprintf(stderr, "[Error] Flatten %s: invalid axis %d\n", node->name, node->attrs.axis);
+        return -1;
+    }
+    int dims[2] = { 1, 1 };
+    for (int i = 0; i < X->rank; i++) dims[i < axis ? 0 : 1] *= X->dims[i];
+    return view_set_shape(node, slots, dims, 2);
+}
+
+// Shape đích lấy từ input 1 (initializer int64): 0 = giữ chiều tương ứng của input,
+// -1 = suy ra từ số phần tử còn lại
+static int reshape_infer_shape(ExecNode* node, Tensor** slots) {
+    Tensor* X = node_input(node, slots, 0);
+    Tensor* S = node_input(node, slots, 1);
+    int rank = S ? (int)tensor_numel(S) : 0;
+    if (S == NULL || rank > TENSOR_MAX_RANK) {
+        fprintf(stderr, "[Error] Reshape %s: missing or unsupported shape input\n", node->name);
+        return -1;
+    }
+    size_t known = 1;
+    int dims[TENSOR_MAX_RANK], infer = -1;
+    for (int i = 0; i < rank; i++) {
+        int64_t d = tensor_int64_at(S, i);
+        if (d == 0 && i < X->rank) d = X->dims[i];
+        if (d == -1 && infer < 0) {
+            infer = i;
+            continue;
+        }
+        if (d <= 0) {
+            fprintf(stderr, "[Error] Reshape %s: invalid dim %lld\n", node->name, (long long)d);
+            return -1;
+        }
+        dims[i] = (int)d;
+        known *= (size_t)d;
+    }
+    if (infer >= 0) dims[infer] = (int)(tensor_numel(X) / known);
+    return view_set_shape(node, slots, dims, rank);
+}
+
+// axes lấy từ attribute (opset < 13) hoặc input 1 (opset 13)
+static int view_axes_count(ExecNode* node, Tensor** slots) {
+    Tensor* A = node_input(node, slots, 1);
+    return A ? (int)tensor_numel(A) : node->attrs.n_axes;
+}
+
+// Đọc axes và chuẩn hóa về [0, rank), trả về số axes hoặc -1 nếu không hợp lệ
+static int view_axes(ExecNode* node, Tensor** slots, int rank, int* axes) {
+    const NodeAttrs* a = &node->attrs;
+    Tensor* A = node_input(node, slots, 1);
+    int n = view_axes_count(node, slots);
+    if (n > TENSOR_MAX_RANK) return -1;
+    for (int i = 0; i < n; i++) {
+        int axis = A ? (int)tensor_int64_at(A, i) : a->axes[i];
+        axes[i] = axis < 0 ? axis + rank : axis;
+        if (axes[i] < 0 || axes[i] >= rank) return -1;
+    }
+    return n;
+}
+
+static int squeeze_infer_shape(ExecNode* node, Tensor** slots) {
+    Tensor* X = node_input(node, slots, 0);
+    int axes[TENSOR_MAX_RANK];
+    int n_axes = view_axes(node, slots, X->rank, axes);
+    if (n_axes < 0) {
+        fprintf(stderr, "[Error] Squeeze %s: invalid axes\n", node->name);
+        return -1;
+    }
+    // Không có axes: bỏ mọi chiều bằng 1
+    int drop[TENSOR_MAX_RANK];
+    for (int i = 0; i < X->rank; i++) drop[i] = (n_axes == 0 && X->dims[i] == 1);
+    for (int k = 0; k < n_axes; k++) {
+        if (X->dims[axes[k]] != 1) {
+            fprintf(stderr, "[Error] Squeeze %s: axis %d has size %d\n", node->name, axes[k], X->dims[axes[k]]);
+            return -1;
+        }
+        drop[axes[k]] = 1;
+    }
+    int dims[TENSOR_MAX_RANK], rank = 0;
+    for (int i = 0; i < X->rank; i++) {
+        if (!drop[i]) dims[rank++] = X->dims[i];
+    }
+    return view_set_shape(node, slots, dims, rank);
+}
+
+static int unsqueeze_infer_shape(ExecNode* node, Tensor** slots) {
+    Tensor* X = node_input(node, slots, 0);
+    int axes[TENSOR_MAX_RANK];
+    int n_axes = view_axes_count(node, slots);
+    int rank = X->rank + n_axes;
+    if (rank > TENSOR_MAX_RANK || view_axes(node, slots, rank, axes) != n_axes) {
+        fprintf(stderr, "[Error] Unsqueeze %s: invalid axes\n", node->name);
+        return -1;
+    }
+    int insert[TENSOR_MAX_RANK] = { 0 };
+    for (int k = 0; k < n_axes; k++) insert[axes[k]] = 1;
+    int dims[TENSOR_MAX_RANK];
+    for (int i = 0, j = 0; i < rank; i++) dims[i] = insert[i] ? 1 : X->dims[j++];
+    return view_set_shape(node, slots, dims, rank);
+}
+
+// Transpose: output là view hoán vị chiều của input (tensor_permute_view), chỉ đổi dims + strides.
+// Kernel đọc output phải có OP_FLAG_STRIDED, nếu không sẽ được chèn node Contiguous phía trước.
+static int transpose_infer_shape(ExecNode* node, Tensor** slots) {
+    const NodeAttrs* a = &node->attrs;
+    Tensor* X = node_input(node, slots, 0);
+    if (X->dtype != TENSOR_FLOAT32 || (a->n_perm != 0 && a->n_perm != X->rank)) {
+        fprintf(stderr, "[Error] Transpose %s: unsupported input or perm\n", node->name);
+        return -1;
+    }
+    int perm[TENSOR_MAX_RANK], seen[TENSOR_MAX_RANK] = { 0 };
+    for (int i = 0; i < X->rank; i++) {
+        int p = a->n_perm ? a->perm[i] : X->rank - 1 - i;
+        if (p < 0 || p >= X->rank || seen[p]++) {
+            fprintf(stderr, "[Error] Transpose %s: invalid perm\n", node->name);
+            return -1;
+        }
+        perm[i] = p;
+    }
+    tensor_permute_view(node_output(node, slots, 0), X, perm);
+    return 0;
+}
+
+static void contiguous_compute(ExecNode* node, Tensor** slots) {
+    op_contiguous(node_input(node, slots, 0), node_output(node, slots, 0));
+}
+
+// Identity / Dropout (inference: y = x). Thường bị pass eliminate-identity xóa khỏi plan;
+// kernel này chỉ chạy khi pass bị tắt hoặc không xóa được node. Output mask (nếu có) toàn 1.
+static int identity_infer_shape(ExecNode* node, Tensor** slots) {
+    Tensor* X = node_input(node, slots, 0);
+    for (int k = 0; k < node->n_outputs; k++) {
+        tensor_set_shape(node_output(node, slots, k), X->rank, X->dims);
+    }
+    return 0;
+}
+
+static void identity_compute(ExecNode* node, Tensor** slots) {
+    view_compute(node, slots);
+    size_t size = tensor_storage_size(node_input(node, slots, 0));
+    for (int k = 1; k < node->n_outputs; k++) {
+        float* mask = node_output(node, slots, k)->data;
+        for (size_t i = 0; i < size; i++) mask[i] = 1.0f;
+    }
+}
+
+// ============================================================
+// 6. GEMM
+// ============================================================
+
+static int gemm_infer_shape(ExecNode* node, Tensor** slots) {
+    const NodeAttrs* a = &node->attrs;
+    Tensor* A = node_input(node, slots, 0);
+    Tensor* B = node_input(node, slots, 1);
+    int rows_a, cols_a, rows_b, cols_b;
+    tensor_matrix_dims(A, &rows_a, &cols_a);
+    tensor_matrix_dims(B, &rows_b, &cols_b);
+    int M = a->transA ? cols_a : rows_a;
+    int K = a->transA ? rows_a : cols_a;
+    int K_b = a->transB ? cols_b : rows_b;
+    if (K != K_b) {
+        fprintf(stderr, "[Error] Gemm %s: inner dimensions mismatch (%d vs %d)\n", node->name, K, K_b);
+        return -1;
+    }
+    int dims[2] = { M, a->transB ? rows_b : cols_b };
+
+    // Bias phải broadcast một chiều được tới [M, N] ([M] hay [N, 1] chỉ khớp khi trùng kích thước)
+    Tensor* C = node_input(node, slots, 2);
+    size_t strides[2];
+    if (C != NULL && tensor_broadcast_strides(C, 2, dims, strides) != 0) {
+        fprintf(stderr, "[Error] Gemm %s: bias cannot broadcast to [%d, %d]\n", node->name, dims[0], dims[1]);
+        return -1;
+    }
+    tensor_set_shape(node_output(node, slots, 0), 2, dims);
+    return 0;
+}
+
+// Weights của Gemm được pack sẵn cho đường batch 1 (GEMV)
+typedef struct {
+    float* packed_b;    // op(B) [K, N] dạng panel GEMV_NR cột (sgemv_pack_b)
+    int K, N;
+} GemmState;
+
+static int gemm_prepare(ExecNode* node, Tensor** slots) {
+    const NodeAttrs* a = &node->attrs;
+    Tensor* B = node_input(node, slots, 1);
+    GemmState* st = (GemmState*)calloc(1, sizeof(GemmState));
+    node->state = st;
+
+    // Chỉ pack khi B là initializer (activation chưa có data lúc prepare)
+    if (B == NULL || B->data == NULL) return 0;
+    int rows_b, cols_b;
+    tensor_matrix_dims(B, &rows_b, &cols_b);
+    st->K = a->transB ? cols_b : rows_b;
+    st->N = a->transB ? rows_b : cols_b;
+    st->packed_b = (float*)aligned_alloc(64, sgemv_packed_size(st->N, st->K) * sizeof(float));
+    sgemv_pack_b(a->transB, st->N, st->K, B->data, cols_b, st->packed_b);
+    return 0;
+}
+
+static void gemm_release(ExecNode* node) {
+    GemmState* st = (GemmState*)node->state;
+    if (st) free(st->packed_b);
+    free(st);
+    node->state = NULL;
+}
+
+static void gemm_compute(ExecNode* node, Tensor** slots) {
+    const NodeAttrs* a = &node->attrs;
+    const GemmState* st = (const GemmState*)node->state;
+    Tensor* A = node_input(node, slots, 0);
+    int rows_a, cols_a;
+    tensor_matrix_dims(A, &rows_a, &cols_a);
+    if (st->packed_b != NULL && rows_a == 1 && !a->transA) {
+        op_gemv_packed(node->kernels, A, st->packed_b, node_input(node, slots, 2), node_output(node, slots, 0),
+                       a->alpha, a->beta);
+        return;
+    }
+    op_gemm(node->kernels, node_input(node, slots, 0), node_input(node, slots, 1), node_input(node, slots, 2),
+            node_output(node, slots, 0), a->alpha, a->beta, a->transA, a->transB);
+}
+
+// ============================================================
+// 7. KERNEL CHO LAYOUT NCHWc (xem nchwc.h)
+// ============================================================
+// Chỉ được layout pass chọn khi CPU hỗ trợ AVX2 + FMA. Shape vẫn là shape logic nên
+// các hàm infer_shape của layout NCHW được dùng lại.
+
+typedef struct {
+    float* packed_w;    // [OCb, ICb, kH, kW, 8, 8]
+    float* bias;        // Đã đệm 0 tới OCb * 8
+    float* bn_scale;    // BatchNorm đã fuse: [scale | shift], mỗi phần đệm tới OCb * 8 (NULL nếu không có)
+} NchwcConvState;
+
+static int nchwc_conv_prepare(ExecNode* node, Tensor** slots) {
+    Tensor* W = node_input(node, slots, 1);
+    Tensor* B = node_input(node, slots, 2);
+    int out_pad = nchwc_blocks(W->n) * TENSOR_BLOCK_C;
+
+    NchwcConvState* st = (NchwcConvState*)calloc(1, sizeof(NchwcConvState));
+    st->packed_w = (float*)malloc((size_t)out_pad * nchwc_blocks(W->c) * TENSOR_BLOCK_C * W->h * W->w * sizeof(float));
+    st->bias = (float*)calloc(out_pad, sizeof(float));
+    nchwc_conv_pack_weights(W, st->packed_w);
+    if (B != NULL) memcpy(st->bias, B->data, W->n * sizeof(float));
+    st->bn_scale = conv_fused_bn(node, slots, W->n, out_pad);
+    node->state = st;
+    return 0;
+}
+
+static void nchwc_conv_release(ExecNode* node) {
+    NchwcConvState* st = (NchwcConvState*)node->state;
+    if (st) {
+        free(st->packed_w);
+        free(st->bias);
+        free(st->bn_scale);
+    }
+    free(st);
+    node->state = NULL;
+}
+
+static void nchwc_conv_compute(ExecNode* node, Tensor** slots) {
+    const NodeAttrs* a = &node->attrs;
+    const NchwcConvState* st = (const NchwcConvState*)node->state;
+    Tensor* W = node_input(node, slots, 1);
+    ConvEpilogue ep_buf;
+    const ConvEpilogue* ep = conv_epilogue(node, slots, st->bn_scale, nchwc_blocks(W->n) * TENSOR_BLOCK_C, &ep_buf);
+    nchwc_conv2d(node_input(node, slots, 0), st->packed_w, st->bias, node_output(node, slots, 0),
+                 W->h, W->w, a->strides[0], a->strides[1], a->pads[0], a->pads[1],
+                 a->dilations[0], a->dilations[1], ep);
+}
+
+// BatchNorm được gộp một lần thành y = x * scale + shift (state = [scale | shift], đã đệm 0)
+static int nchwc_batchnorm_prepare(ExecNode* node, Tensor** slots) {
+    Tensor* gamma = node_input(node, slots, 1);
+    Tensor* beta = node_input(node, slots, 2);
+    Tensor* mean = node_input(node, slots, 3);
+    Tensor* var = node_input(node, slots, 4);
+    int channels = gamma->w;
+    int padded = nchwc_blocks(channels) * TENSOR_BLOCK_C;
+
+    float* st = (float*)calloc(2 * padded, sizeof(float));
+    bn_fold(gamma, beta, mean, var, node->attrs.epsilon, channels, st, st + padded);
+    node->state = st;
+    return 0;
+}
+
+static void nchwc_state_release(ExecNode* node) {
+    free(node->state);
+    node->state = NULL;
+}
+
+static void nchwc_batchnorm_compute(ExecNode* node, Tensor** slots) {
+    Tensor* X = node_input(node, slots, 0);
+    const float* st = (const float*)node->state;
+    nchwc_scale_shift(X, st, st + nchwc_blocks(X->c) * TENSOR_BLOCK_C, node_output(node, slots, 0));
+}
+
+static void nchwc_relu_compute(ExecNode* node, Tensor** slots) {
+    nchwc_relu(node_input(node, slots, 0), node_output(node, slots, 0));
+}
+
+// Kernel NCHWc chỉ cộng hai tensor cùng shape
+static int nchwc_add_infer_shape(ExecNode* node, Tensor** slots) {
+    if (!same_shape(node_input(node, slots, 0), node_input(node, slots, 1))) {
+        fprintf(stderr, "[Error] Add %s: broadcast is not supported in NCHWc layout\n", node->name);
+        return -1;
+    }
+    return infer_same_shape(node, slots);
+}
+
+static void nchwc_add_compute(ExecNode* node, Tensor** slots) {
+    nchwc_add(node_input(node, slots, 0), node_input(node, slots, 1), node_output(node, slots, 0));
+}
+
+static void nchwc_maxpool_compute(ExecNode* node, Tensor** slots) {
+    const NodeAttrs* a = &node->attrs;
+    nchwc_maxpool(node_input(node, slots, 0), node_output(node, slots, 0),
+                  a->kernel_shape[0], a->kernel_shape[1], a->strides[0], a->strides[1],
+                  a->pads[0], a->pads[1]);
+}
+
+static void nchwc_global_avgpool_compute(ExecNode* node, Tensor** slots) {
+    nchwc_global_average_pool(node_input(node, slots, 0), node_output(node, slots, 0));
+}
+
+static void reorder_to_blocked_compute(ExecNode* node, Tensor** slots) {
+    nchwc_reorder_to_blocked(node_input(node, slots, 0), node_output(node, slots, 0));
+}
+
+static void reorder_to_plain_compute(ExecNode* node, Tensor** slots) {
+    nchwc_reorder_to_plain(node_input(node, slots, 0), node_output(node, slots, 0));
+}
+
+// ============================================================
+// 8. BẢNG ĐĂNG KÝ
+// ============================================================
+
+static const OpKernel builtin_kernels[] = {
+    // op_type              infer_shape                 prepare       compute                 release        flags
+    { "Conv",               conv_infer_shape,           conv_prepare, conv_compute,           conv_release, OP_FLAG_FUSE_EPILOGUE | OP_FLAG_SCRATCH },
+    { "BatchNormalization", infer_same_shape,           NULL,         batchnorm_compute,      NULL,         OP_FLAG_INPLACE },
+    { "Relu",               infer_same_shape,           NULL,         relu_compute,           NULL,         OP_FLAG_INPLACE },
+    { "Add",                add_infer_shape,            NULL,         add_compute,            NULL,         OP_FLAG_INPLACE | OP_FLAG_STRIDED },
+    { "MaxPool",            maxpool_infer_shape,        NULL,         maxpool_compute,        NULL,         0 },
+    { "GlobalAveragePool",  global_avgpool_infer_shape, NULL,         global_avgpool_compute, NULL,         0 },
+    { "Flatten",            flatten_infer_shape,        NULL,         view_compute,           NULL,         OP_FLAG_VIEW },
+    { "Reshape",            reshape_infer_shape,        NULL,         view_compute,           NULL,         OP_FLAG_VIEW },
+    { "Squeeze",            squeeze_infer_shape,        NULL,         view_compute,           NULL,         OP_FLAG_VIEW },
+    { "Unsqueeze",          unsqueeze_infer_shape,      NULL,         view_compute,           NULL,         OP_FLAG_VIEW },
+    { "Transpose",          transpose_infer_shape,      NULL,         view_compute,           NULL,         OP_FLAG_VIEW | OP_FLAG_STRIDED },
+    { "Identity",           identity_infer_shape,       NULL,         identity_compute,       NULL,         OP_FLAG_VIEW },
+    { "Dropout",            identity_infer_shape,       NULL,         identity_compute,       NULL,         OP_FLAG_VIEW },
+    { "Gemm",               gemm_infer_shape,           gemm_prepare, gemm_compute,           gemm_release, 0 },
+};
+
+static const OpKernel nchwc_kernels[] = {
+    // op_type              infer_shape                 prepare                  compute                       release               flags
+    { "Conv",               conv_output_shape,          nchwc_conv_prepare,      nchwc_conv_compute,           nchwc_conv_release,  OP_FLAG_FUSE_EPILOGUE },
+    { "BatchNormalization", infer_same_shape,           nchwc_batchnorm_prepare, nchwc_batchnorm_compute,      nchwc_state_release, OP_FLAG_INPLACE },
+    { "Relu",               infer_same_shape,           NULL,                    nchwc_relu_compute,           NULL,                OP_FLAG_INPLACE },
+    { "Add",                nchwc_add_infer_shape,      NULL,                    nchwc_add_compute,            NULL,                OP_FLAG_INPLACE },
+    { "MaxPool",            maxpool_infer_shape,        NULL,                    nchwc_maxpool_compute,        NULL,                0 },
+    { "GlobalAveragePool",  global_avgpool_infer_shape, NULL,                    nchwc_global_avgpool_compute, NULL,                0 },
+};
+
+static const OpKernel reorder_kernels[] = {
+    { "ReorderToNCHW",      infer_same_shape,           NULL,                    reorder_to_plain_compute,     NULL, 0 },
+    { "ReorderToNCHWc",     infer_same_shape,           NULL,                    reorder_to_blocked_compute,   NULL, 0 },
+};
+
+static const OpKernel contiguous_kernel =
+    { "Contiguous",         infer_same_shape,           NULL,                    contiguous_compute,           NULL, OP_FLAG_STRIDED };
+
+static const OpKernel* registry[MAX_REGISTERED_OPS];
+static int registry_count = 0;
+static int builtins_loaded = 0;
+
+static void load_builtins(void) {
+    if (builtins_loaded) return;
+    builtins_loaded = 1;
+    int n = (int)(sizeof(builtin_kernels) / sizeof(builtin_kernels[0]));
+    for (int i = 0; i < n; i++) op_registry_register(&builtin_kernels[i]);
+}
+
+void op_registry_register(const OpKernel* kernel) {
+    load_builtins();
+    for (int i = 0; i < registry_count; i++) {
+        if (strcmp(registry[i]->op_type, kernel->op_type) == 0) {
+            registry[i] = kernel;
+            return;
+        }
+    }
+    if (registry_count >= MAX_REGISTERED_OPS) {
+        fprintf(stderr, "[Error] Operator registry overflow!\n");
+        exit(1);
+    }
+    registry[registry_count++] = kernel;
+}
+
+const OpKernel* op_registry_find(const char* op_type) {
+    load_builtins();
+    for (int i = 0; i < registry_count; i++) {
+        if (strcmp(registry[i]->op_type, op_type) == 0) {
+            return registry[i];
+        }
+    }
+    return NULL;
+}
+
+const OpKernel* op_registry_find_nchwc(const ExecNode* node) {
+    const char* op_type = node->kernel->op_type;
+
+    // Không thay thế kernel do người dùng đăng ký đè lên kernel có sẵn
+    int n_builtin = (int)(sizeof(builtin_kernels) / sizeof(builtin_kernels[0]));
+    int is_builtin = 0;
+    for (int i = 0; i < n_builtin; i++) {
+        if (node->kernel == &builtin_kernels[i]) is_builtin = 1;
+    }
+    if (!is_builtin) return NULL;
+
+    // Conv blocked chỉ hỗ trợ group = 1 (group/depthwise vẫn chạy ở layout NCHW)
+    if (strcmp(op_type, "Conv") == 0 && node->attrs.group != 1) return NULL;
+
+    int n = (int)(sizeof(nchwc_kernels) / sizeof(nchwc_kernels[0]));
+    for (int i = 0; i < n; i++) {
+        if (strcmp(nchwc_kernels[i].op_type, op_type) == 0) return &nchwc_kernels[i];
+    }
+    return NULL;
+}
+
+const OpKernel* op_registry_reorder_kernel(int to_blocked) {
+    return &reorder_kernels[to_blocked ? 1 : 0];
+}
+
+const OpKernel* op_registry_contiguous_kernel(void) {
+    return &contiguous_kernel;
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/exec_plan.h"
+#include "../include/op_registry.h"
+#include "../include/thread_pool.h"
+#include "../include/scheduler.h"
+
+// ============================================================
+// 1. XÂY DAG
+// ============================================================
+
+NodeDag* node_dag_build(const ExecPlan* plan) {
+    int n = plan->n_nodes;
+    NodeDag* dag = (NodeDag*)calloc(1, sizeof(NodeDag));
+    int* producer = (int*)malloc(plan->n_slots * sizeof(int));  // Slot -> node ghi slot đó
+    int* mark = (int*)malloc((n > 0 ? n : 1) * sizeof(int));     // Khử cạnh trùng của node đang xét
+    int* preds = (int*)malloc((size_t)(n > 0 ? n : 1) * MAX_NODE_IO * sizeof(int));
+    int* level = (int*)calloc(n > 0 ? n : 1, sizeof(int));
+    if (!dag || !producer || !mark || !preds || !level) goto fail;
+
+    dag->n_nodes = n;
+    dag->words = (n + 63) / 64;
+    dag->n_deps = (int*)calloc(n > 0 ? n : 1, sizeof(int));
+    dag->succ_begin = (int*)calloc(n + 1, sizeof(int));
+    dag->ancestors = (uint64_t*)calloc((size_t)(n > 0 ? n : 1) * (dag->words > 0 ? dag->words : 1), sizeof(uint64_t));
+    if (!dag->n_deps || !dag->succ_begin || !dag->ancestors) goto fail;
+
+    for (int s = 0; s < plan->n_slots; s++) producer[s] = -1;
+    for (int i = 0; i < n; i++) {
+        const ExecNode* node = &plan->nodes[i];
+        for (int j = 0; j < node->n_outputs; j++) producer[node->outputs[j]] = i;
+        mark[i] = -1;
+    }
+
+    // Node trực tiếp đứng trước (mỗi node tối đa MAX_NODE_IO), đồng thời tính ancestors và level
+    for (int i = 0; i < n; i++) {
+        const ExecNode* node = &plan->nodes[i];
+        uint64_t* anc = dag->ancestors + (size_t)i * dag->words;
+        for (int j = 0; j < node->n_inputs; j++) {
+            int s = node->inputs[j];
+            int p = (s >= 0) ? producer[s] : -1;
+            if (p < 0 || p >= i || mark[p] == i) continue;
+            mark[p] = i;
+            preds[(size_t)i * MAX_NODE_IO + dag->n_deps[i]++] = p;
+            dag->succ_begin[p + 1]++;
+
+            const uint64_t* anc_p = dag->ancestors + (size_t)p * dag->words;
+            for (int w = 0; w < dag->words; w++) anc[w] |= anc_p[w];
+            anc[p >> 6] |= 1ULL << (p & 63);
+            if (level[p] + 1 > level[i]) level[i] = level[p] + 1;
+        }
+        if (dag->n_deps[i] == 0) dag->n_roots++;
+        if (level[i] + 1 > dag->depth) dag->depth = level[i] + 1;
+    }
+
+    // Danh sách kế tiếp dạng CSR, mỗi danh sách tăng dần theo chỉ số node
+    for (int i = 0; i < n; i++) dag->succ_begin[i + 1] += dag->succ_begin[i];
+    dag->n_edges = dag->succ_begin[n];
+    dag->succ = (int*)malloc((dag->n_edges > 0 ? dag->n_edges : 1) * sizeof(int));
+    if (!dag->succ) goto fail;
+    for (int i = 0; i < n; i++) mark[i] = dag->succ_begin[i];
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < dag->n_deps[i]; k++) {
+            int p = preds[(size_t)i * MAX_NODE_IO + k];
+            dag->succ[mark[p]++] = i;
+        }
+    }
+
+    free(level);
+    free(preds);
+    free(mark);
+    free(producer);
+    return dag;
+
+fail:
+    fprintf(stderr, "[Error] Cannot allocate node DAG\n");
+    free(level);
+    free(preds);
+    free(mark);
+    free(producer);
+    node_dag_free(dag);
+    return NULL;
+}
+
+void node_dag_free(NodeDag* dag) {
+    if (!dag) return;
+    free(dag->n_deps);
+    free(dag->succ_begin);
+    free(dag->succ);
+    free(dag->ancestors);
+    free(dag);
+}
+
+int node_dag_all_precede(const NodeDag* dag, const uint64_t* set, int b) {
+    const uint64_t* anc = node_dag_ancestors(dag, b);
+    for (int w = 0; w < dag->words; w++) {
+        if (set[w] & ~anc[w]) return 0;
+    }
+    return 1;
+}
+
+// ============================================================
+// 2. CHẠY THEO DAG
+// ============================================================
+
+typedef struct {
+    const NodeDag* dag;
+    const ExecPlan* plan;
+    RunContext* ctx;
+    TaskGroup group;
+} DagRun;
+
+// Chạy node i rồi giảm bộ đếm của các node kế tiếp. Node đầu tiên hết phụ thuộc được chạy luôn
+// trên thread này (dữ liệu vừa ghi còn trong cache), các node còn lại được spawn cho thread khác.
+static void dag_node_task(void* arg, size_t index) {
+    DagRun* run = (DagRun*)arg;
+    const NodeDag* dag = run->dag;
+    atomic_int* pending = run->ctx->pending;
+    int i = (int)index;
+
+    while (i >= 0) {
+        ExecNode* node = &run->plan->nodes[i];
+        node->kernel->compute(node, run->ctx->slots);
+
+        int next = -1;
+        for (int k = dag->succ_begin[i]; k < dag->succ_begin[i + 1]; k++) {
+            int s = dag->succ[k];
+            if (atomic_fetch_sub(&pending[s], 1) != 1) continue;
+            if (next < 0) next = s;
+            else task_spawn(&run->group, dag_node_task, run, (size_t)s);
+        }
+        i = next;
+    }
+}
+
+void node_dag_run(const NodeDag* dag, const ExecPlan* plan, RunContext* ctx) {
+    DagRun run = { dag, plan, ctx, TASK_GROUP_INIT };
+    for (int i = 0; i < dag->n_nodes; i++) atomic_store(&ctx->pending[i], dag->n_deps[i]);
+
+    for (int i = 0; i < dag->n_nodes; i++) {
+        if (dag->n_deps[i] == 0) task_spawn(&run.group, dag_node_task, &run, (size_t)i);
+    }
+    task_group_wait(&run.group);
+}
@@ -0,0 +1,130 @@
+# Sinh model ONNX nhỏ cho tests/test_model.c (ghi protobuf trực tiếp, không cần thư viện onnx).
+# Cách dùng: python3 gen_model.py OUT.onnx [SEED=1] [VARIANT=resnet]
+#   resnet     ResNet thu nhỏ: stem 7x7 + MaxPool, 3 bottleneck (nhánh downsample), GAP, Gemm 100 lớp
+#   group      như resnet nhưng Conv 3x3 group 4 / depthwise
+#   transpose  như resnet, thêm Reshape / Transpose / Add / Transpose trước Gemm (alpha 0.5) và
+#              hai Transpose triệt tiêu sau Gemm: cùng seed thì output trùng với resnet
+#   broadcast  thêm Conv -> Add với toán hạng activation có broadcast ([N, C, 1, 1]) ở cả hai phía
+#   views      thêm Flatten / Reshape / Squeeze / Unsqueeze
+#   cleanup    thêm Identity, Dropout và nhánh Relu chết
+#   resnet50   kiến trúc ResNet-50 đầy đủ (input 224x224, 1000 lớp, weights ngẫu nhiên)
+# Các file trong thư mục này: mini.onnx (resnet), group.onnx (group), transpose.onnx (transpose),
+# broadcast.onnx (broadcast), seed 1.
+import struct, random, sys
+
+def varint(v):
+    if v < 0: v += 1 << 64
+    out = b''
+    while True:
+        b = v & 0x7f; v >>= 7
+        if v: out += bytes([b | 0x80])
+        else: return out + bytes([b])
+def key(f, w): return varint((f << 3) | w)
+def fld_bytes(f, b): return key(f, 2) + varint(len(b)) + b
+def fld_str(f, s): return fld_bytes(f, s.encode())
+def fld_int(f, v): return key(f, 0) + varint(v)
+def fld_float(f, v): return key(f, 5) + struct.pack('<f', v)
+
+rng = random.Random(int(sys.argv[2]) if len(sys.argv) > 2 else 1)
+inits = []; nodes = []; extra_inputs = []
+
+def tensor(name, dims, vals, dtype=1):
+    b = b''.join(fld_int(1, d) for d in dims) + fld_int(2, dtype) + fld_str(8, name)
+    if dtype == 1: raw = struct.pack('<%df' % len(vals), *vals)
+    else: raw = struct.pack('<%dq' % len(vals), *vals)
+    return b + fld_bytes(9, raw)
+def init(name, dims, vals=None, scale=0.2, dtype=1):
+    n = 1
+    for d in dims: n *= d
+    if vals is None: vals = [(rng.random() * 2 - 1) * scale for _ in range(n)]
+    inits.append(tensor(name, dims, vals, dtype)); return name
+def attr_ints(name, v): return fld_str(1, name) + b''.join(fld_int(8, x) for x in v) + fld_int(20, 7)
+def attr_int(name, v): return fld_str(1, name) + fld_int(3, v) + fld_int(20, 2)
+def attr_float(name, v): return fld_str(1, name) + fld_float(2, v) + fld_int(20, 1)
+def node(op, name, ins, outs, attrs=()):
+    b = b''.join(fld_str(1, i) for i in ins) + b''.join(fld_str(2, o) for o in outs)
+    b += fld_str(3, name) + fld_str(4, op) + b''.join(fld_bytes(5, a) for a in attrs)
+    nodes.append(b); return outs[0]
+
+def conv(x, name, cin, cout, k, s=1, p=0, bias=True, group=1, pads=None):
+    w = init(name + '_weight', [cout, cin // group, k, k], scale=(2.0 / (cin // group * k * k)) ** 0.5)
+    ins = [x, w] + ([init(name + '_bias', [cout], scale=0.1)] if bias else [])
+    attrs = [attr_ints('kernel_shape', [k, k]), attr_ints('strides', [s, s]),
+             attr_ints('pads', pads if pads else [p, p, p, p]), attr_ints('dilations', [1, 1]), attr_int('group', group)]
+    return node('Conv', name + '_fwd', ins, [name + '_fwd'], attrs)
+def bn(x, name, c):
+    ins = [x, init(name + '_gamma', [c], [rng.uniform(0.5, 1.5) for _ in range(c)]),
+           init(name + '_beta', [c], scale=0.2), init(name + '_running_mean', [c], scale=0.2),
+           init(name + '_running_var', [c], [rng.uniform(0.5, 1.5) for _ in range(c)])]
+    return node('BatchNormalization', name + '_fwd', ins, [name + '_fwd'], [attr_float('epsilon', 1e-5)])
+def relu(x, name): return node('Relu', name + '_fwd', [x], [name + '_fwd'])
+
+variant = sys.argv[3] if len(sys.argv) > 3 else 'resnet'
+NCLS = 1000 if variant == 'resnet50' else 100
+C0, HW = (64, 224) if variant == 'resnet50' else (16, 64)
+x = 'data'
+x = conv(x, 'conv0', 3, C0, 7, 2, 3, bias=False); x = bn(x, 'bn0', C0); x = relu(x, 'relu0')
+x = node('MaxPool', 'pool0_fwd', [x], ['pool0_fwd'], [attr_ints('kernel_shape', [3, 3]), attr_ints('strides', [2, 2]), attr_ints('pads', [1, 1, 1, 1])])
+cin = C0
+if variant == 'cleanup':
+    x = node('Identity', 'ident0', [x], ['ident0'])
+    node('Relu', 'dead_relu', [x], ['dead_relu']); node('Relu', 'dead_relu2', ['dead_relu'], ['dead_relu2'])
+if variant == 'resnet50':
+    cfg = []
+    for si, (reps, mid) in enumerate([(3, 64), (4, 128), (6, 256), (3, 512)]):
+        cfg += [(mid, mid * 4, (1 if si == 0 or r else 2)) for r in range(reps)]
+else:
+    cfg = [(8, 32, 1), (16, 64, 2), (16, 64, 1)]
+for st, (mid, cout, stride) in enumerate(cfg):
+    p = 'stage%d_' % (st + 1)
+    g = 4 if variant == 'group' else 1
+    y = conv(x, p + 'conv0', cin, mid, 1, stride, 0); y = bn(y, p + 'bn0', mid); y = relu(y, p + 'relu0')
+    y = conv(y, p + 'conv1', mid, mid, 3, 1, 1, bias=False, group=(mid if (variant == 'group' and st == 1) else g)); y = bn(y, p + 'bn1', mid); y = relu(y, p + 'relu1')
+    y = conv(y, p + 'conv2', mid, cout, 1, 1, 0); y = bn(y, p + 'bn2', cout)
+    if cin != cout or stride != 1:
+        sc = conv(x, p + 'down', cin, cout, 1, stride, 0); sc = bn(sc, p + 'bnd', cout)
+    else: sc = x
+    y = node('Add', p + 'plus_fwd', [y, sc], [p + 'plus_fwd']); x = relu(y, p + 'relu2'); cin = cout
+if variant == 'broadcast':
+    # Add giữa hai activation có broadcast ngay sau Conv, theo cả hai chiều:
+    # [N, C, H, W] + [N, C, 1, 1] rồi [N, C, 1, 1] + [N, C, H, W]
+    g = node('GlobalAveragePool', 'bc_pool', [x], ['bc_pool'])
+    y = conv(x, 'bc_conv0', cin, cin, 1)
+    y = node('Add', 'bc_add0', [y, g], ['bc_add0']); y = relu(y, 'bc_relu0')
+    z = conv(g, 'bc_conv1', cin, cin, 1)
+    x = node('Add', 'bc_add1', [z, y], ['bc_add1']); x = relu(x, 'bc_relu1')
+x = node('GlobalAveragePool', 'pool1_fwd', [x], ['pool1_fwd'])
+if variant == 'cleanup':
+    x = node('Dropout', 'drop0', [x], ['drop0', 'drop0_mask'])
+    x = node('Identity', 'ident1', [x], ['ident1'])
+if variant == 'views':
+    x = node('Flatten', 'flatten0', [x], ['flatten0'], [attr_int('axis', 1)])
+    shp = init('reshape_shape', [4], [0, -1, 1, 1], dtype=7)
+    x = node('Reshape', 'reshape0', [x, shp], ['reshape0'])
+    x = node('Squeeze', 'squeeze0', [x], ['squeeze0'], [attr_ints('axes', [3])])
+    x = node('Unsqueeze', 'unsqueeze0', [x], ['unsqueeze0'], [attr_ints('axes', [3])])
+alpha = 1.0
+if variant == 'transpose':
+    # [N, 64, 1, 1] -> [N, 8, 8] -> x^T + x^T -> (..)^T, Gemm alpha 0.5: cùng kết quả với mini
+    shp = init('reshape_shape', [3], [0, 8, 8], dtype=7)
+    x = node('Reshape', 'reshape0', [x, shp], ['reshape0'])
+    t = node('Transpose', 'transpose0', [x], ['transpose0'], [attr_ints('perm', [0, 2, 1])])
+    x = node('Add', 'double0', [t, t], ['double0'])
+    x = node('Transpose', 'transpose1', [x], ['transpose1'], [attr_ints('perm', [0, 2, 1])])
+    alpha = 0.5
+x = node('Flatten', 'flatten_fwd', [x], ['flatten_fwd'], [attr_int('axis', 1)])
+x = node('Gemm', 'dense0_fwd', [x, init('dense0_weight', [NCLS, cin], scale=0.3), init('dense0_bias', [NCLS], scale=0.1)], ['dense0_fwd'],
+         [attr_float('alpha', alpha), attr_float('beta', 1.0), attr_int('transA', 0), attr_int('transB', 1)])
+
+if variant == 'transpose':
+    x = node('Transpose', 'transpose2', [x], ['transpose2'], [attr_ints('perm', [1, 0])])
+    x = node('Transpose', 'transpose3', [x], ['transpose3'], [attr_ints('perm', [1, 0])])
+
+def vinfo(name, dims):
+    shape = b''.join(fld_bytes(1, fld_int(1, d)) for d in dims)
+    ttype = fld_int(1, 1) + fld_bytes(2, shape)
+    return fld_str(1, name) + fld_bytes(2, fld_bytes(1, ttype))
+graph = b''.join(fld_bytes(1, n) for n in nodes) + fld_str(2, 'mini') + b''.join(fld_bytes(5, t) for t in inits)
+graph += fld_bytes(11, vinfo('data', [1, 3, HW, HW])) + fld_bytes(12, vinfo(x, [1, NCLS]))
+model = fld_int(1, 7) + fld_str(2, 'gen') + fld_bytes(7, graph) + fld_bytes(8, fld_str(1, '') + fld_int(2, 11))
+open(sys.argv[1], 'wb').write(model)